@@ -41,10 +41,13 @@ namespace reshade::d3d10
 
 		bool init_texture(texture &info) override;
 		void upload_texture(texture &texture, const uint8_t *pixels) override;
+		void upload_texture_compressed(texture &texture, const uint8_t *data) override;
 		bool update_texture_reference(texture &texture);
 		void update_texture_references(texture_reference type);
 
+		bool compile_effect_code(effect_data &effect) override;
 		bool compile_effect(effect_data &effect) override;
+		void unload_effect(size_t id) override;
 		void unload_effects() override;
 
 		bool add_sampler(const reshadefx::sampler_info &info, struct d3d10_technique_data &technique_init);
@@ -78,8 +81,11 @@ namespace reshade::d3d10
 		com_ptr<ID3D10RenderTargetView> _backbuffer_rtv[3];
 		com_ptr<ID3D10ShaderResourceView> _backbuffer_texture_srv[2];
 		com_ptr<ID3D10ShaderResourceView> _depthstencil_texture_srv;
+		std::unordered_map<std::string, effect_shader_cache_entry<com_ptr<IUnknown>>> _effect_shaders; // Shader objects by their byte code
+		std::unordered_map<std::string, effect_shader_cache_entry<std::pair<std::vector<uint8_t>, std::string>>> _effect_shader_sources; // Byte code and compiler warnings by the profile, entry point and code they were compiled from
+		std::mutex _effect_shader_sources_mutex;
 		std::unordered_map<size_t, com_ptr<ID3D10SamplerState>> _effect_sampler_states;
-		std::vector<com_ptr<ID3D10Buffer>> _constant_buffers;
+		std::vector<com_ptr<ID3D10Buffer>> _constant_buffers; // One per effect, by effect ID
 
 		std::map<UINT, depth_texture_save_info> _displayed_depth_textures;
 		std::unordered_map<UINT, com_ptr<ID3D10Texture2D>> _depth_texture_saves;
@@ -43,6 +43,10 @@ namespace reshade::d3d11
 		std::vector<com_ptr<ID3D11ShaderResourceView>> texture_bindings;
 		ptrdiff_t uniform_storage_offset = 0;
 		ptrdiff_t uniform_storage_index = -1;
+		size_t uniform_storage_size = 0;
+		ptrdiff_t per_frame_uniform_storage_offset = 0;
+		ptrdiff_t per_frame_uniform_storage_index = -1;
+		size_t per_frame_uniform_storage_size = 0;
 	};
 }
 
@@ -64,6 +68,13 @@ reshade::d3d11::runtime_d3d11::runtime_d3d11(ID3D11Device *device, IDXGISwapChai
 	if (DXGI_ADAPTER_DESC desc; SUCCEEDED(dxgi_adapter->GetDesc(&desc)))
 		_vendor_id = desc.VendorId, _device_id = desc.DeviceId;
 
+	_split_uniform_buffers = true;
+
+	// Load the compiler up front, so that worker threads compiling effects only ever read the handle
+	_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
+	if (_d3d_compiler == nullptr)
+		_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
+
 #if RESHADE_GUI
 	subscribe_to_ui("DX11", [this]() { draw_debug_menu(); });
 #endif
@@ -477,6 +488,13 @@ bool reshade::d3d11::runtime_d3d11::init_texture(texture &info)
 		break;
 	}
 
+	// Block-compressed formats cannot be rendered to, so these textures can only be filled with image data
+	if (desc.Format >= DXGI_FORMAT_BC1_TYPELESS && desc.Format <= DXGI_FORMAT_BC5_SNORM)
+	{
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.MiscFlags = 0;
+	}
+
 	const auto texture_data = info.impl->as<d3d11_tex_data>();
 
 	if (HRESULT hr = _device->CreateTexture2D(&desc, nullptr, &texture_data->texture); FAILED(hr))
@@ -561,6 +579,39 @@ void reshade::d3d11::runtime_d3d11::upload_texture(texture &texture, const uint8
 	if (texture.levels > 1)
 		_immediate_context->GenerateMips(texture_impl->srv[0].get());
 }
+void reshade::d3d11::runtime_d3d11::upload_texture_compressed(texture &texture, const uint8_t *data)
+{
+	assert(texture.impl_reference == texture_reference::none && data != nullptr);
+
+	uint32_t block_size;
+
+	switch (texture.format)
+	{
+	case reshadefx::texture_format::dxt1:
+		block_size = 8;
+		break;
+	case reshadefx::texture_format::dxt3:
+	case reshadefx::texture_format::dxt5:
+		block_size = 16;
+		break;
+	default:
+		LOG(ERROR) << "Compressed texture upload is not supported for format " << static_cast<unsigned int>(texture.format) << '!';
+		return;
+	}
+
+	const auto texture_impl = texture.impl->as<d3d11_tex_data>();
+	assert(texture_impl != nullptr);
+
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		const uint32_t upload_pitch = std::max(1u, ((texture.width >> level) + 3) / 4) * block_size;
+		const uint32_t num_rows = std::max(1u, ((texture.height >> level) + 3) / 4);
+
+		_immediate_context->UpdateSubresource(texture_impl->texture.get(), level, nullptr, data, upload_pitch, upload_pitch * num_rows);
+
+		data += upload_pitch * num_rows;
+	}
+}
 bool reshade::d3d11::runtime_d3d11::update_texture_reference(texture &texture)
 {
 	com_ptr<ID3D11ShaderResourceView> new_reference[2];
@@ -608,13 +659,8 @@ void reshade::d3d11::runtime_d3d11::update_texture_references(texture_reference
 			update_texture_reference(tex);
 }
 
-bool reshade::d3d11::runtime_d3d11::compile_effect(effect_data &effect)
+bool reshade::d3d11::runtime_d3d11::compile_effect_code(effect_data &effect)
 {
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
-
 	if (_d3d_compiler == nullptr)
 	{
 		LOG(ERROR) << "Unable to load D3DCompiler library. Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.";
@@ -625,7 +671,8 @@ bool reshade::d3d11::runtime_d3d11::compile_effect(effect_data &effect)
 
 	const std::string hlsl = effect.preamble + effect.module.hlsl;
 
-	std::unordered_map<std::string, com_ptr<IUnknown>> entry_points;
+	// Keys of the byte code cache entries used by this effect, so that those it used before (e.g. before it was re-specialized) can be released afterwards
+	std::vector<const std::string *> used_source_keys;
 
 	// Compile the generated HLSL source code to DX byte code
 	for (const auto &entry_point : effect.module.entry_points)
@@ -653,22 +700,83 @@ bool reshade::d3d11::runtime_d3d11::compile_effect(effect_data &effect)
 			break;
 		}
 
+		// Identical effects (e.g. copies of the same file) generate the same code, so only compile each combination of code, entry point and profile once
+		// The full source is part of the key, so that two different shaders cannot end up with the same byte code just because their hashes collide
+		std::string source_key = profile + ' ' + entry_point.first + '\n' + hlsl;
+		{
+			const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+			if (const auto it = _effect_shader_sources.find(source_key); it != _effect_shader_sources.end())
+			{
+				const auto &[bytecode, warnings] = it->second.value;
+				effect.compiled_entry_points[entry_point.first] = bytecode;
+				effect.errors += warnings; // Report the same warnings as if the code was compiled again
+
+				it->second.add_effect(effect.index);
+				used_source_keys.push_back(&it->first);
+				continue;
+			}
+		}
+
 		com_ptr<ID3DBlob> d3d_compiled, d3d_errors;
 
-		HRESULT hr = D3DCompile(hlsl.c_str(), hlsl.size(), nullptr, nullptr, nullptr, entry_point.first.c_str(), profile.c_str(), D3DCOMPILE_ENABLE_STRICTNESS, 0, &d3d_compiled, &d3d_errors);
+		const HRESULT hr = D3DCompile(hlsl.c_str(), hlsl.size(), nullptr, nullptr, nullptr, entry_point.first.c_str(), profile.c_str(), D3DCOMPILE_ENABLE_STRICTNESS, 0, &d3d_compiled, &d3d_errors);
 
+		std::string warnings;
 		if (d3d_errors != nullptr) // Append warnings to the output error string as well
-			effect.errors.append(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+			warnings.assign(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+		effect.errors += warnings;
 
 		// No need to setup resources if any of the shaders failed to compile
 		if (FAILED(hr))
 			return false;
 
+		std::vector<uint8_t> &bytecode = effect.compiled_entry_points[entry_point.first];
+		bytecode.assign(static_cast<const uint8_t *>(d3d_compiled->GetBufferPointer()), static_cast<const uint8_t *>(d3d_compiled->GetBufferPointer()) + d3d_compiled->GetBufferSize());
+
+		const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+		const auto it = _effect_shader_sources.emplace(std::move(source_key), effect_shader_cache_entry<std::pair<std::vector<uint8_t>, std::string>> { std::make_pair(bytecode, std::move(warnings)) }).first;
+		it->second.add_effect(effect.index);
+		used_source_keys.push_back(&it->first);
+	}
+
+	// Release byte code no effect uses anymore
+	const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+	release_effect_shader_cache_entries(_effect_shader_sources, effect.index, used_source_keys, [](auto &) {});
+
+	return true;
+}
+
+bool reshade::d3d11::runtime_d3d11::compile_effect(effect_data &effect)
+{
+	// Compile the code now if that did not happen on a worker thread already
+	if (effect.compiled_entry_points.empty() && !compile_effect_code(effect))
+		return false;
+
+	std::unordered_map<std::string, com_ptr<IUnknown>> entry_points;
+	std::vector<const std::string *> used_shader_keys;
+
+	for (const auto &entry_point : effect.module.entry_points)
+	{
+		const std::vector<uint8_t> &bytecode = effect.compiled_entry_points.at(entry_point.first);
+
+		// Different code can still compile to the same byte code (e.g. a vertex shader from a common include file), in which case the existing shader object is shared as well
+		// The byte code itself is the key, so an existing shader object is only reused if its byte code is actually identical
+		std::string bytecode_key(reinterpret_cast<const char *>(bytecode.data()), bytecode.size());
+		if (const auto it = _effect_shaders.find(bytecode_key); it != _effect_shaders.end())
+		{
+			entry_points[entry_point.first] = it->second.value;
+
+			it->second.add_effect(effect.index);
+			used_shader_keys.push_back(&it->first);
+			continue;
+		}
+
 		// Create runtime shader objects from the compiled DX byte code
+		HRESULT hr;
 		if (entry_point.second)
-			hr = _device->CreatePixelShader(d3d_compiled->GetBufferPointer(), d3d_compiled->GetBufferSize(), nullptr, reinterpret_cast<ID3D11PixelShader **>(&entry_points[entry_point.first]));
+			hr = _device->CreatePixelShader(bytecode.data(), bytecode.size(), nullptr, reinterpret_cast<ID3D11PixelShader **>(&entry_points[entry_point.first]));
 		else
-			hr = _device->CreateVertexShader(d3d_compiled->GetBufferPointer(), d3d_compiled->GetBufferSize(), nullptr, reinterpret_cast<ID3D11VertexShader **>(&entry_points[entry_point.first]));
+			hr = _device->CreateVertexShader(bytecode.data(), bytecode.size(), nullptr, reinterpret_cast<ID3D11VertexShader **>(&entry_points[entry_point.first]));
 
 		if (FAILED(hr))
 		{
@@ -676,14 +784,36 @@ bool reshade::d3d11::runtime_d3d11::compile_effect(effect_data &effect)
 				"HRESULT is '" << std::hex << hr << std::dec << "'.";
 			return false;
 		}
+
+		const auto it = _effect_shaders.emplace(std::move(bytecode_key), effect_shader_cache_entry<com_ptr<IUnknown>> { entry_points[entry_point.first] }).first;
+		it->second.add_effect(effect.index);
+		used_shader_keys.push_back(&it->first);
 	}
 
-	if (effect.storage_size != 0)
+	// Release shader objects no effect uses anymore (techniques that still reference them keep them alive until they are destroyed)
+	release_effect_shader_cache_entries(_effect_shaders, effect.index, used_shader_keys, [](auto &) {});
+
+	d3d11_technique_data technique_init;
+
+	// Variables updated every frame are in a separate constant buffer (see 'split_uniform_buffers' code generation option), so the other one is not updated every frame just because of those
+	const size_t per_frame_offset = effect.module.per_frame_uniform_offset != 0 ? effect.module.per_frame_uniform_offset : effect.storage_size;
+
+	// Every effect has two slots in the list of constant buffers, which are reused when the effect is compiled again (e.g. after it was re-specialized), so that the previous buffers are released
+	if (_constant_buffers.size() < (effect.index + 1) * 2)
+		_constant_buffers.resize((effect.index + 1) * 2);
+
+	for (const auto [offset, size] : { std::make_pair(size_t(0), per_frame_offset), std::make_pair(per_frame_offset, effect.storage_size - per_frame_offset) })
 	{
+		const size_t buffer_index = effect.index * 2 + (offset == 0 ? 0 : 1);
+		_constant_buffers[buffer_index].reset();
+
+		if (size == 0)
+			continue;
+
 		com_ptr<ID3D11Buffer> cbuffer;
 
-		const D3D11_BUFFER_DESC desc = { static_cast<UINT>(effect.storage_size), D3D11_USAGE_DYNAMIC, D3D11_BIND_CONSTANT_BUFFER, D3D11_CPU_ACCESS_WRITE };
-		const D3D11_SUBRESOURCE_DATA init_data = { _uniform_data_storage.data() + effect.storage_offset, static_cast<UINT>(effect.storage_size) };
+		const D3D11_BUFFER_DESC desc = { static_cast<UINT>(size), D3D11_USAGE_DYNAMIC, D3D11_BIND_CONSTANT_BUFFER, D3D11_CPU_ACCESS_WRITE };
+		const D3D11_SUBRESOURCE_DATA init_data = { _uniform_data_storage.data() + effect.storage_offset + offset, static_cast<UINT>(size) };
 
 		if (const HRESULT hr = _device->CreateBuffer(&desc, &init_data, &cbuffer); FAILED(hr))
 		{
@@ -692,15 +822,24 @@ bool reshade::d3d11::runtime_d3d11::compile_effect(effect_data &effect)
 			return false;
 		}
 
-		_constant_buffers.push_back(std::move(cbuffer));
+		_constant_buffers[buffer_index] = std::move(cbuffer);
+
+		if (offset == 0)
+		{
+			technique_init.uniform_storage_index = buffer_index;
+			technique_init.uniform_storage_offset = effect.storage_offset;
+			technique_init.uniform_storage_size = size;
+		}
+		else
+		{
+			technique_init.per_frame_uniform_storage_index = buffer_index;
+			technique_init.per_frame_uniform_storage_offset = effect.storage_offset + offset;
+			technique_init.per_frame_uniform_storage_size = size;
+		}
 	}
 
 	bool success = true;
 
-	d3d11_technique_data technique_init;
-	technique_init.uniform_storage_index = _constant_buffers.size() - 1;
-	technique_init.uniform_storage_offset = effect.storage_offset;
-
 	for (const reshadefx::sampler_info &info : effect.module.samplers)
 		success &= add_sampler(info, technique_init);
 
@@ -710,10 +849,27 @@ bool reshade::d3d11::runtime_d3d11::compile_effect(effect_data &effect)
 
 	return success;
 }
+void reshade::d3d11::runtime_d3d11::unload_effect(size_t id)
+{
+	runtime::unload_effect(id);
+
+	// Release the constant buffers of the effect, new ones are created when it is compiled again
+	if (_constant_buffers.size() >= (id + 1) * 2)
+	{
+		_constant_buffers[id * 2 + 0].reset();
+		_constant_buffers[id * 2 + 1].reset();
+	}
+	// Release the shader objects and byte code no other effect uses
+	release_effect_shader_cache_entries(_effect_shaders, id, {}, [](auto &) {});
+	const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+	release_effect_shader_cache_entries(_effect_shader_sources, id, {}, [](auto &) {});
+}
 void reshade::d3d11::runtime_d3d11::unload_effects()
 {
 	runtime::unload_effects();
 
+	_effect_shaders.clear();
+	_effect_shader_sources.clear();
 	_effect_sampler_states.clear();
 	_constant_buffers.clear();
 }
@@ -1025,16 +1181,14 @@ void reshade::d3d11::runtime_d3d11::render_technique(technique &technique)
 	_immediate_context->PSSetSamplers(0, static_cast<UINT>(technique_data.sampler_states.size()), reinterpret_cast<ID3D11SamplerState *const *>(technique_data.sampler_states.data()));
 
 	// Setup shader constants
-	if (technique_data.uniform_storage_index >= 0)
-	{
-		const auto constant_buffer = _constant_buffers[technique_data.uniform_storage_index].get();
+	const auto update_constant_buffer = [this](ID3D11Buffer *constant_buffer, ptrdiff_t storage_offset) {
 		D3D11_MAPPED_SUBRESOURCE mapped;
 
 		const HRESULT hr = _immediate_context->Map(constant_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
 
 		if (SUCCEEDED(hr))
 		{
-			memcpy(mapped.pData, _uniform_data_storage.data() + technique_data.uniform_storage_offset, mapped.RowPitch);
+			memcpy(mapped.pData, _uniform_data_storage.data() + storage_offset, mapped.RowPitch);
 
 			_immediate_context->Unmap(constant_buffer, 0);
 		}
@@ -1043,8 +1197,36 @@ void reshade::d3d11::runtime_d3d11::render_technique(technique &technique)
 			LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
 		}
 
-		_immediate_context->VSSetConstantBuffers(0, 1, &constant_buffer);
-		_immediate_context->PSSetConstantBuffers(0, 1, &constant_buffer);
+		return SUCCEEDED(hr);
+	};
+
+	ID3D11Buffer *constant_buffers[2] = {};
+	bool uploaded = true;
+
+	// Mapping with discard overwrites the whole buffer, so upload all of it, but only if anything in it changed since the last upload
+	if (technique_data.uniform_storage_index >= 0)
+	{
+		constant_buffers[0] = _constant_buffers[technique_data.uniform_storage_index].get();
+
+		if (get_modified_uniform_storage(technique.effect_index, technique_data.uniform_storage_offset, technique_data.uniform_storage_size).second != 0)
+			uploaded &= update_constant_buffer(constant_buffers[0], technique_data.uniform_storage_offset);
+	}
+	if (technique_data.per_frame_uniform_storage_index >= 0)
+	{
+		constant_buffers[1] = _constant_buffers[technique_data.per_frame_uniform_storage_index].get();
+
+		if (get_modified_uniform_storage(technique.effect_index, technique_data.per_frame_uniform_storage_offset, technique_data.per_frame_uniform_storage_size).second != 0)
+			uploaded &= update_constant_buffer(constant_buffers[1], technique_data.per_frame_uniform_storage_offset);
+	}
+
+	// These buffers are shared by all techniques in the effect, so the modified range can be reset as soon as they were updated once
+	if (uploaded)
+		_uniform_storage_modified[technique.effect_index] = {};
+
+	if (constant_buffers[0] != nullptr || constant_buffers[1] != nullptr)
+	{
+		_immediate_context->VSSetConstantBuffers(0, 2, constant_buffers);
+		_immediate_context->PSSetConstantBuffers(0, 2, constant_buffers);
 	}
 
 	// Disable unused pipeline stages
@@ -77,6 +77,9 @@ reshade::d3d12::runtime_d3d12::runtime_d3d12(ID3D12Device *device, ID3D12Command
 
 	_renderer_id = D3D_FEATURE_LEVEL_12_0;
 
+	// Load the compiler up front, so that worker threads compiling effects only ever read the handle
+	_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
+
 	if (com_ptr<IDXGIFactory4> factory;
 		SUCCEEDED(swapchain->GetParent(IID_PPV_ARGS(&factory))))
 	{
@@ -463,6 +466,11 @@ bool reshade::d3d12::runtime_d3d12::init_texture(texture &info)
 		break;
 	}
 
+	// Block-compressed formats cannot be rendered to or written by the mipmap generation shader, so these textures can only be filled with image data
+	const bool compressed = desc.Format >= DXGI_FORMAT_BC1_TYPELESS && desc.Format <= DXGI_FORMAT_BC5_SNORM;
+	if (compressed)
+		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
 	D3D12_HEAP_PROPERTIES props = { D3D12_HEAP_TYPE_DEFAULT };
 
 	// Render targets are always either cleared to zero or not cleared at all (see 'ClearRenderTargets' pass state), so can set the optimized clear value here to zero
@@ -472,7 +480,7 @@ bool reshade::d3d12::runtime_d3d12::init_texture(texture &info)
 	const auto texture_data = info.impl->as<d3d12_tex_data>();
 	texture_data->state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
 
-	if (HRESULT hr = _device->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &desc, texture_data->state, &clear_value, IID_PPV_ARGS(&texture_data->resource)); FAILED(hr))
+	if (HRESULT hr = _device->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &desc, texture_data->state, compressed ? nullptr : &clear_value, IID_PPV_ARGS(&texture_data->resource)); FAILED(hr))
 	{
 		LOG(ERROR) << "Failed to create texture '" << info.unique_name << "' ("
 			"Width = " << desc.Width << ", "
@@ -512,7 +520,7 @@ bool reshade::d3d12::runtime_d3d12::init_texture(texture &info)
 	}
 
 	// Generate UAVs for mipmap generation
-	for (uint32_t level = 1; level < info.levels; ++level, srv_cpu_handle.ptr += _srv_handle_size)
+	for (uint32_t level = 1; level < info.levels && !compressed; ++level, srv_cpu_handle.ptr += _srv_handle_size)
 	{
 		D3D12_UNORDERED_ACCESS_VIEW_DESC uav_desc = {};
 		uav_desc.Format = make_dxgi_format_normal(desc.Format);
@@ -612,6 +620,94 @@ void reshade::d3d12::runtime_d3d12::upload_texture(texture &texture, const uint8
 
 	execute_command_list(cmd_list);
 }
+void reshade::d3d12::runtime_d3d12::upload_texture_compressed(texture &texture, const uint8_t *data)
+{
+	assert(texture.impl_reference == texture_reference::none && data != nullptr);
+
+	uint32_t block_size;
+
+	switch (texture.format)
+	{
+	case reshadefx::texture_format::dxt1:
+		block_size = 8;
+		break;
+	case reshadefx::texture_format::dxt3:
+	case reshadefx::texture_format::dxt5:
+		block_size = 16;
+		break;
+	default:
+		LOG(ERROR) << "Compressed texture upload is not supported for format " << static_cast<unsigned int>(texture.format) << '!';
+		return;
+	}
+
+	const auto texture_impl = texture.impl->as<d3d12_tex_data>();
+	assert(texture_impl != nullptr);
+
+	// Get the layout of every mipmap level in an upload buffer, which requires each row of blocks to be aligned
+	const D3D12_RESOURCE_DESC texture_desc = texture_impl->resource->GetDesc();
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(texture.levels);
+	std::vector<UINT> num_rows(texture.levels);
+	UINT64 total_size = 0;
+	_device->GetCopyableFootprints(&texture_desc, 0, texture.levels, 0, layouts.data(), num_rows.data(), nullptr, &total_size);
+
+	D3D12_RESOURCE_DESC desc = { D3D12_RESOURCE_DIMENSION_BUFFER };
+	desc.Width = total_size;
+	desc.Height = 1;
+	desc.DepthOrArraySize = 1;
+	desc.MipLevels = 1;
+	desc.SampleDesc = { 1, 0 };
+	desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	D3D12_HEAP_PROPERTIES props = { D3D12_HEAP_TYPE_UPLOAD };
+
+	com_ptr<ID3D12Resource> intermediate;
+	if (FAILED(_device->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&intermediate))))
+	{
+		LOG(ERROR) << "Failed to create system memory texture for texture updating!";
+		return;
+	}
+
+#ifdef _DEBUG
+	intermediate->SetName(L"ReShade upload texture");
+#endif
+
+	// Fill upload buffer with the data of all levels
+	uint8_t *mapped_data;
+	if (FAILED(intermediate->Map(0, nullptr, reinterpret_cast<void **>(&mapped_data))))
+		return;
+
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		const uint32_t data_pitch = std::max(1u, ((texture.width >> level) + 3) / 4) * block_size;
+		uint8_t *level_data = mapped_data + layouts[level].Offset;
+
+		for (UINT y = 0; y < num_rows[level]; ++y, level_data += layouts[level].Footprint.RowPitch, data += data_pitch)
+			memcpy(level_data, data, data_pitch);
+	}
+
+	intermediate->Unmap(0, nullptr);
+
+	const com_ptr<ID3D12GraphicsCommandList> cmd_list = create_command_list();
+
+	transition_state(cmd_list, texture_impl->resource, texture_impl->state, D3D12_RESOURCE_STATE_COPY_DEST);
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		D3D12_TEXTURE_COPY_LOCATION src_location = { intermediate.get() };
+		src_location.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		src_location.PlacedFootprint = layouts[level];
+
+		D3D12_TEXTURE_COPY_LOCATION dst_location = { texture_impl->resource.get() };
+		dst_location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		dst_location.SubresourceIndex = level;
+
+		cmd_list->CopyTextureRegion(&dst_location, 0, 0, 0, &src_location, nullptr);
+	}
+	transition_state(cmd_list, texture_impl->resource, D3D12_RESOURCE_STATE_COPY_DEST, texture_impl->state);
+
+	if (FAILED(cmd_list->Close()))
+		return;
+
+	execute_command_list(cmd_list);
+}
 bool reshade::d3d12::runtime_d3d12::update_texture_reference(texture &)
 {
 	// TODO
@@ -684,11 +780,8 @@ void reshade::d3d12::runtime_d3d12::execute_command_list_async(const com_ptr<ID3
 	_commandqueue->ExecuteCommandLists(ARRAYSIZE(cmd_lists), cmd_lists);
 }
 
-bool reshade::d3d12::runtime_d3d12::compile_effect(effect_data &effect)
+bool reshade::d3d12::runtime_d3d12::compile_effect_code(effect_data &effect)
 {
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
-
 	if (_d3d_compiler == nullptr)
 	{
 		LOG(ERROR) << "Unable to load D3DCompiler library.";
@@ -699,12 +792,30 @@ bool reshade::d3d12::runtime_d3d12::compile_effect(effect_data &effect)
 
 	const std::string hlsl = effect.preamble + effect.module.hlsl;
 
-	std::unordered_map<std::string, com_ptr<ID3DBlob>> entry_points;
+	// Keys of the byte code cache entries used by this effect, so that those it used before (e.g. before it was re-specialized) can be released afterwards
+	std::vector<const std::string *> used_source_keys;
 
 	// Compile the generated HLSL source code to DX byte code
 	for (const auto &entry_point : effect.module.entry_points)
 	{
-		com_ptr<ID3DBlob> d3d_errors;
+		// Identical effects (e.g. copies of the same file) generate the same code, so only compile each combination of code, entry point and profile once
+		// The full source is part of the key, so that two different shaders cannot end up with the same byte code just because their hashes collide
+		std::string source_key = std::string(entry_point.second ? "ps_5_0" : "vs_5_0") + ' ' + entry_point.first + '\n' + hlsl;
+		{
+			const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+			if (const auto it = _effect_shader_sources.find(source_key); it != _effect_shader_sources.end())
+			{
+				const auto &[bytecode, warnings] = it->second.value;
+				effect.compiled_entry_points[entry_point.first] = bytecode;
+				effect.errors += warnings; // Report the same warnings as if the code was compiled again
+
+				it->second.add_effect(effect.index);
+				used_source_keys.push_back(&it->first);
+				continue;
+			}
+		}
+
+		com_ptr<ID3DBlob> d3d_compiled, d3d_errors;
 
 		const HRESULT hr = D3DCompile(
 			hlsl.c_str(), hlsl.size(),
@@ -712,20 +823,57 @@ bool reshade::d3d12::runtime_d3d12::compile_effect(effect_data &effect)
 			entry_point.first.c_str(),
 			entry_point.second ? "ps_5_0" : "vs_5_0",
 			D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_ALL_RESOURCES_BOUND, 0,
-			&entry_points[entry_point.first], &d3d_errors);
+			&d3d_compiled, &d3d_errors);
 
+		std::string warnings;
 		if (d3d_errors != nullptr) // Append warnings to the output error string as well
-			effect.errors.append(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+			warnings.assign(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+		effect.errors += warnings;
 
 		// No need to setup resources if any of the shaders failed to compile
 		if (FAILED(hr))
 			return false;
+
+		std::vector<uint8_t> &bytecode = effect.compiled_entry_points[entry_point.first];
+		bytecode.assign(static_cast<const uint8_t *>(d3d_compiled->GetBufferPointer()), static_cast<const uint8_t *>(d3d_compiled->GetBufferPointer()) + d3d_compiled->GetBufferSize());
+
+		const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+		const auto it = _effect_shader_sources.emplace(std::move(source_key), effect_shader_cache_entry<std::pair<std::vector<uint8_t>, std::string>> { std::make_pair(bytecode, std::move(warnings)) }).first;
+		it->second.add_effect(effect.index);
+		used_source_keys.push_back(&it->first);
 	}
 
+	// Release byte code no effect uses anymore
+	const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+	release_effect_shader_cache_entries(_effect_shader_sources, effect.index, used_source_keys, [](auto &) {});
+
+	return true;
+}
+
+bool reshade::d3d12::runtime_d3d12::compile_effect(effect_data &effect)
+{
+	// Compile the code now if that did not happen on a worker thread already
+	if (effect.compiled_entry_points.empty() && !compile_effect_code(effect))
+		return false;
+
+	const std::unordered_map<std::string, std::vector<uint8_t>> &entry_points = effect.compiled_entry_points;
+
 	if (_effect_data.size() <= effect.index)
 		_effect_data.resize(effect.index + 1);
 
 	d3d12_effect_data &effect_data = _effect_data[effect.index];
+
+	// The effect is compiled again without being unloaded first when it was re-specialized, so release the objects created the last time (once the GPU no longer references them)
+	if (effect_data.signature != nullptr || effect_data.cb != nullptr || effect_data.srv_heap != nullptr || effect_data.rtv_heap != nullptr || effect_data.sampler_heap != nullptr)
+	{
+		_screenshot_fence->SetEventOnCompletion(1, _screenshot_event);
+		_commandqueue->Signal(_screenshot_fence.get(), 1);
+		WaitForSingleObject(_screenshot_event, INFINITE);
+		_screenshot_fence->Signal(0);
+
+		effect_data = d3d12_effect_data();
+	}
+
 	effect_data.storage_size = effect.storage_size;
 	effect_data.storage_offset = effect.storage_offset;
 
@@ -891,6 +1039,23 @@ bool reshade::d3d12::runtime_d3d12::compile_effect(effect_data &effect)
 
 	return success;
 }
+void reshade::d3d12::runtime_d3d12::unload_effect(size_t id)
+{
+	// Wait for all GPU operations to finish so resources are no longer referenced
+	_screenshot_fence->SetEventOnCompletion(1, _screenshot_event);
+	_commandqueue->Signal(_screenshot_fence.get(), 1);
+	WaitForSingleObject(_screenshot_event, INFINITE);
+	_screenshot_fence->Signal(0);
+
+	runtime::unload_effect(id);
+
+	// Release the constant buffer, root signature and descriptor heaps of the effect, new ones are created when it is compiled again
+	if (_effect_data.size() > id)
+		_effect_data[id] = d3d12_effect_data();
+	// Release the byte code no other effect uses
+	const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+	release_effect_shader_cache_entries(_effect_shader_sources, id, {}, [](auto &) {});
+}
 void reshade::d3d12::runtime_d3d12::unload_effects()
 {
 	// Wait for all GPU operations to finish so resources are no longer referenced
@@ -902,9 +1067,10 @@ void reshade::d3d12::runtime_d3d12::unload_effects()
 	runtime::unload_effects();
 
 	_effect_data.clear();
+	_effect_shader_sources.clear();
 }
 
-bool reshade::d3d12::runtime_d3d12::init_technique(technique &technique, const d3d12_effect_data &effect_data, const std::unordered_map<std::string, com_ptr<ID3DBlob>> &entry_points)
+bool reshade::d3d12::runtime_d3d12::init_technique(technique &technique, const d3d12_effect_data &effect_data, const std::unordered_map<std::string, std::vector<uint8_t>> &entry_points)
 {
 	technique.impl = std::make_unique<d3d12_technique_data>();
 
@@ -919,9 +1085,9 @@ bool reshade::d3d12::runtime_d3d12::init_technique(technique &technique, const d
 		pso_desc.pRootSignature = _effect_data[technique.effect_index].signature.get();
 
 		const auto &VS = entry_points.at(pass_info.vs_entry_point);
-		pso_desc.VS = { VS->GetBufferPointer(), VS->GetBufferSize() };
+		pso_desc.VS = { VS.data(), VS.size() };
 		const auto &PS = entry_points.at(pass_info.ps_entry_point);
-		pso_desc.PS = { PS->GetBufferPointer(), PS->GetBufferSize() };
+		pso_desc.PS = { PS.data(), PS.size() };
 
 		pass_data.viewport.Width = pass_info.viewport_width ? FLOAT(pass_info.viewport_width) : FLOAT(frame_width());
 		pass_data.viewport.Height = pass_info.viewport_height ? FLOAT(pass_info.viewport_height) : FLOAT(frame_height());
@@ -1067,10 +1233,23 @@ void reshade::d3d12::runtime_d3d12::render_technique(technique &technique)
 	// Setup shader constants
 	if (effect_data.storage_size != 0)
 	{
-		void *mapped;
-		effect_data.cb->Map(0, nullptr, &mapped);
-		memcpy(mapped, _uniform_data_storage.data() + effect_data.storage_offset, effect_data.storage_size);
-		effect_data.cb->Unmap(0, nullptr);
+		// The buffer stays in the upload heap, so only the bytes that changed since the last upload have to be written
+		// It is shared by all techniques in the effect, so the modified range can be reset as soon as it was updated once
+		const size_t storage_offset = static_cast<size_t>(effect_data.storage_offset);
+
+		if (const auto [offset, size] = get_modified_uniform_storage(technique.effect_index, storage_offset, static_cast<size_t>(effect_data.storage_size)); size != 0)
+		{
+			void *mapped;
+			if (SUCCEEDED(effect_data.cb->Map(0, nullptr, &mapped)))
+			{
+				memcpy(static_cast<uint8_t *>(mapped) + (offset - storage_offset), _uniform_data_storage.data() + offset, size);
+
+				const D3D12_RANGE written_range = { offset - storage_offset, offset - storage_offset + size };
+				effect_data.cb->Unmap(0, &written_range);
+
+				_uniform_storage_modified[technique.effect_index] = {};
+			}
+		}
 
 		cmd_list->SetGraphicsRootConstantBufferView(0, effect_data.cbv_gpu_address);
 	}
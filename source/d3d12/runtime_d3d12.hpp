@@ -32,12 +32,15 @@ namespace reshade::d3d12
 
 		bool init_texture(texture &info) override;
 		void upload_texture(texture &texture, const uint8_t *pixels) override;
+		void upload_texture_compressed(texture &texture, const uint8_t *data) override;
 		bool update_texture_reference(texture &texture);
 
+		bool compile_effect_code(effect_data &effect) override;
 		bool compile_effect(effect_data &effect) override;
+		void unload_effect(size_t id) override;
 		void unload_effects() override;
 
-		bool init_technique(technique &technique, const struct d3d12_effect_data &effect_data, const std::unordered_map<std::string, com_ptr<ID3DBlob>> &entry_points);
+		bool init_technique(technique &technique, const struct d3d12_effect_data &effect_data, const std::unordered_map<std::string, std::vector<uint8_t>> &entry_points);
 
 		void render_technique(technique &technique) override;
 
@@ -73,6 +76,8 @@ namespace reshade::d3d12
 		UINT _sampler_handle_size = 0;
 
 		std::vector<struct d3d12_effect_data> _effect_data;
+		std::unordered_map<std::string, effect_shader_cache_entry<std::pair<std::vector<uint8_t>, std::string>>> _effect_shader_sources; // Byte code and compiler warnings by the profile, entry point and code they were compiled from
+		std::mutex _effect_shader_sources_mutex;
 
 		HANDLE _screenshot_event = nullptr;
 		com_ptr<ID3D12Fence> _screenshot_fence;
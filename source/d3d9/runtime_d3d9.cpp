@@ -67,6 +67,11 @@ reshade::d3d9::runtime_d3d9::runtime_d3d9(IDirect3DDevice9 *device, IDirect3DSwa
 	_num_simultaneous_rendertargets = std::min(caps.NumSimultaneousRTs, DWORD(8));
 	_behavior_flags = creation_params.BehaviorFlags;
 
+	// Load the compiler up front, so that worker threads compiling effects only ever read the handle
+	_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
+	if (_d3d_compiler == nullptr)
+		_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
+
 #if RESHADE_GUI
 	subscribe_to_ui("DX9", [this]() { draw_debug_menu(); });
 #endif
@@ -620,6 +625,60 @@ void reshade::d3d9::runtime_d3d9::upload_texture(texture &texture, const uint8_t
 		return;
 	}
 }
+void reshade::d3d9::runtime_d3d9::upload_texture_compressed(texture &texture, const uint8_t *data)
+{
+	assert(texture.impl_reference == texture_reference::none && data != nullptr);
+
+	uint32_t block_size;
+
+	switch (texture.format)
+	{
+	case reshadefx::texture_format::dxt1:
+		block_size = 8;
+		break;
+	case reshadefx::texture_format::dxt3:
+	case reshadefx::texture_format::dxt5:
+		block_size = 16;
+		break;
+	default:
+		LOG(ERROR) << "Compressed texture upload is not supported for format " << static_cast<unsigned int>(texture.format) << '!';
+		return;
+	}
+
+	const auto texture_impl = texture.impl->as<d3d9_tex_data>();
+	assert(texture_impl != nullptr);
+
+	D3DSURFACE_DESC desc; texture_impl->texture->GetLevelDesc(0, &desc); // Get D3D texture format
+	com_ptr<IDirect3DTexture9> intermediate;
+	if (FAILED(_device->CreateTexture(texture.width, texture.height, texture.levels, 0, desc.Format, D3DPOOL_SYSTEMMEM, &intermediate, nullptr)))
+	{
+		LOG(ERROR) << "Failed to create system memory texture for texture updating!";
+		return;
+	}
+
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		const uint32_t data_pitch = std::max(1u, ((texture.width >> level) + 3) / 4) * block_size;
+		const uint32_t num_rows = std::max(1u, ((texture.height >> level) + 3) / 4);
+
+		D3DLOCKED_RECT mapped;
+		if (FAILED(intermediate->LockRect(level, &mapped, nullptr, 0)))
+			return;
+		auto mapped_data = static_cast<uint8_t *>(mapped.pBits);
+
+		// Copy one row of blocks at a time, since the pitch of the locked level may be larger than that of the data
+		for (uint32_t y = 0; y < num_rows; ++y, mapped_data += mapped.Pitch, data += data_pitch)
+			std::memcpy(mapped_data, data, data_pitch);
+
+		intermediate->UnlockRect(level);
+	}
+
+	if (HRESULT hr = _device->UpdateTexture(intermediate.get(), texture_impl->texture.get()); FAILED(hr))
+	{
+		LOG(ERROR) << "Failed to update texture from system memory texture! HRESULT is '" << std::hex << hr << std::dec << "'.";
+		return;
+	}
+}
 bool reshade::d3d9::runtime_d3d9::update_texture_reference(texture &texture)
 {
 	com_ptr<IDirect3DTexture9> new_reference;
@@ -680,13 +739,8 @@ void reshade::d3d9::runtime_d3d9::update_texture_references(texture_reference ty
 			update_texture_reference(tex);
 }
 
-bool reshade::d3d9::runtime_d3d9::compile_effect(effect_data &effect)
+bool reshade::d3d9::runtime_d3d9::compile_effect_code(effect_data &effect)
 {
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
-	if (_d3d_compiler == nullptr)
-		_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
-
 	if (_d3d_compiler == nullptr)
 	{
 		LOG(ERROR) << "Unable to load D3DCompiler library. Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.";
@@ -695,38 +749,101 @@ bool reshade::d3d9::runtime_d3d9::compile_effect(effect_data &effect)
 
 	const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3d_compiler, "D3DCompile"));
 
-	// Add specialization constant defines to source code
-	effect.preamble += "#define COLOR_PIXEL_SIZE " + std::to_string(1.0f / _width) + ", " + std::to_string(1.0f / _height) + "\n"
+	// Add specialization constant defines to source code (without modifying the effect preamble, since the effect may be compiled again when re-specialized)
+	const std::string preamble = effect.preamble +
+		"#define COLOR_PIXEL_SIZE " + std::to_string(1.0f / _width) + ", " + std::to_string(1.0f / _height) + "\n"
 		"#define DEPTH_PIXEL_SIZE COLOR_PIXEL_SIZE\n"
 		"#define SV_TARGET_PIXEL_SIZE COLOR_PIXEL_SIZE\n"
 		"#define SV_DEPTH_PIXEL_SIZE COLOR_PIXEL_SIZE\n";
 
-	const std::string hlsl_vs = effect.preamble + effect.module.hlsl;
-	const std::string hlsl_ps = effect.preamble + "#define POSITION VPOS\n" + effect.module.hlsl;
+	const std::string hlsl_vs = preamble + effect.module.hlsl;
+	const std::string hlsl_ps = preamble + "#define POSITION VPOS\n" + effect.module.hlsl;
 
-	std::unordered_map<std::string, com_ptr<IUnknown>> entry_points;
+	// Keys of the byte code cache entries used by this effect, so that those it used before (e.g. before it was re-specialized) can be released afterwards
+	std::vector<const std::string *> used_source_keys;
 
 	// Compile the generated HLSL source code to DX byte code
 	for (const auto &entry_point : effect.module.entry_points)
 	{
 		const std::string &hlsl = entry_point.second ? hlsl_ps : hlsl_vs;
 
+		// Identical effects (e.g. copies of the same file) generate the same code, so only compile each combination of code, entry point and profile once
+		// The full source is part of the key, so that two different shaders cannot end up with the same byte code just because their hashes collide
+		std::string source_key = std::string(entry_point.second ? "ps_3_0" : "vs_3_0") + ' ' + entry_point.first + '\n' + hlsl;
+		{
+			const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+			if (const auto it = _effect_shader_sources.find(source_key); it != _effect_shader_sources.end())
+			{
+				const auto &[bytecode, warnings] = it->second.value;
+				effect.compiled_entry_points[entry_point.first] = bytecode;
+				effect.errors += warnings; // Report the same warnings as if the code was compiled again
+
+				it->second.add_effect(effect.index);
+				used_source_keys.push_back(&it->first);
+				continue;
+			}
+		}
+
 		com_ptr<ID3DBlob> compiled, d3d_errors;
 
-		HRESULT hr = D3DCompile(hlsl.c_str(), hlsl.size(), nullptr, nullptr, nullptr, entry_point.first.c_str(), entry_point.second ? "ps_3_0" : "vs_3_0", 0, 0, &compiled, &d3d_errors);
+		const HRESULT hr = D3DCompile(hlsl.c_str(), hlsl.size(), nullptr, nullptr, nullptr, entry_point.first.c_str(), entry_point.second ? "ps_3_0" : "vs_3_0", 0, 0, &compiled, &d3d_errors);
 
+		std::string warnings;
 		if (d3d_errors != nullptr) // Append warnings to the output error string as well
-			effect.errors.append(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+			warnings.assign(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+		effect.errors += warnings;
 
 		// No need to setup resources if any of the shaders failed to compile
 		if (FAILED(hr))
 			return false;
 
+		std::vector<uint8_t> &bytecode = effect.compiled_entry_points[entry_point.first];
+		bytecode.assign(static_cast<const uint8_t *>(compiled->GetBufferPointer()), static_cast<const uint8_t *>(compiled->GetBufferPointer()) + compiled->GetBufferSize());
+
+		const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+		const auto it = _effect_shader_sources.emplace(std::move(source_key), effect_shader_cache_entry<std::pair<std::vector<uint8_t>, std::string>> { std::make_pair(bytecode, std::move(warnings)) }).first;
+		it->second.add_effect(effect.index);
+		used_source_keys.push_back(&it->first);
+	}
+
+	// Release byte code no effect uses anymore
+	const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+	release_effect_shader_cache_entries(_effect_shader_sources, effect.index, used_source_keys, [](auto &) {});
+
+	return true;
+}
+
+bool reshade::d3d9::runtime_d3d9::compile_effect(effect_data &effect)
+{
+	// Compile the code now if that did not happen on a worker thread already
+	if (effect.compiled_entry_points.empty() && !compile_effect_code(effect))
+		return false;
+
+	std::unordered_map<std::string, com_ptr<IUnknown>> entry_points;
+	std::vector<const std::string *> used_shader_keys;
+
+	for (const auto &entry_point : effect.module.entry_points)
+	{
+		const std::vector<uint8_t> &bytecode = effect.compiled_entry_points.at(entry_point.first);
+
+		// Different code can still compile to the same byte code (e.g. a vertex shader from a common include file), in which case the existing shader object is shared as well
+		// The byte code itself is the key, so an existing shader object is only reused if its byte code is actually identical
+		std::string bytecode_key(reinterpret_cast<const char *>(bytecode.data()), bytecode.size());
+		if (const auto it = _effect_shaders.find(bytecode_key); it != _effect_shaders.end())
+		{
+			entry_points[entry_point.first] = it->second.value;
+
+			it->second.add_effect(effect.index);
+			used_shader_keys.push_back(&it->first);
+			continue;
+		}
+
 		// Create runtime shader objects from the compiled DX byte code
+		HRESULT hr;
 		if (entry_point.second)
-			hr = _device->CreatePixelShader(static_cast<const DWORD *>(compiled->GetBufferPointer()), reinterpret_cast<IDirect3DPixelShader9 **>(&entry_points[entry_point.first]));
+			hr = _device->CreatePixelShader(reinterpret_cast<const DWORD *>(bytecode.data()), reinterpret_cast<IDirect3DPixelShader9 **>(&entry_points[entry_point.first]));
 		else
-			hr = _device->CreateVertexShader(static_cast<const DWORD *>(compiled->GetBufferPointer()), reinterpret_cast<IDirect3DVertexShader9 **>(&entry_points[entry_point.first]));
+			hr = _device->CreateVertexShader(reinterpret_cast<const DWORD *>(bytecode.data()), reinterpret_cast<IDirect3DVertexShader9 **>(&entry_points[entry_point.first]));
 
 		if (FAILED(hr))
 		{
@@ -734,8 +851,15 @@ bool reshade::d3d9::runtime_d3d9::compile_effect(effect_data &effect)
 				"HRESULT is '" << std::hex << hr << std::dec << "'.";
 			return false;
 		}
+
+		const auto it = _effect_shaders.emplace(std::move(bytecode_key), effect_shader_cache_entry<com_ptr<IUnknown>> { entry_points[entry_point.first] }).first;
+		it->second.add_effect(effect.index);
+		used_shader_keys.push_back(&it->first);
 	}
 
+	// Release shader objects no effect uses anymore (techniques that still reference them keep them alive until they are destroyed)
+	release_effect_shader_cache_entries(_effect_shaders, effect.index, used_shader_keys, [](auto &) {});
+
 	bool success = true;
 
 	d3d9_technique_data technique_init;
@@ -751,6 +875,22 @@ bool reshade::d3d9::runtime_d3d9::compile_effect(effect_data &effect)
 
 	return success;
 }
+void reshade::d3d9::runtime_d3d9::unload_effect(size_t id)
+{
+	runtime::unload_effect(id);
+
+	// Release the shader objects and byte code no other effect uses
+	release_effect_shader_cache_entries(_effect_shaders, id, {}, [](auto &) {});
+	const std::lock_guard<std::mutex> lock(_effect_shader_sources_mutex);
+	release_effect_shader_cache_entries(_effect_shader_sources, id, {}, [](auto &) {});
+}
+void reshade::d3d9::runtime_d3d9::unload_effects()
+{
+	runtime::unload_effects();
+
+	_effect_shaders.clear();
+	_effect_shader_sources.clear();
+}
 
 bool reshade::d3d9::runtime_d3d9::add_sampler(const reshadefx::sampler_info &info, d3d9_technique_data &technique_init)
 {
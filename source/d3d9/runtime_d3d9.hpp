@@ -46,10 +46,14 @@ namespace reshade::d3d9
 
 		bool init_texture(texture &info) override;
 		void upload_texture(texture &texture, const uint8_t *pixels) override;
+		void upload_texture_compressed(texture &texture, const uint8_t *data) override;
 		bool update_texture_reference(texture &texture);
 		void update_texture_references(texture_reference type);
 
+		bool compile_effect_code(effect_data &effect) override;
 		bool compile_effect(effect_data &effect) override;
+		void unload_effect(size_t id) override;
+		void unload_effects() override;
 
 		bool add_sampler(const reshadefx::sampler_info &info, struct d3d9_technique_data &technique_init);
 		bool init_technique(technique &info, const struct d3d9_technique_data &technique_init, const std::unordered_map<std::string, com_ptr<IUnknown>> &entry_points);
@@ -100,6 +104,10 @@ namespace reshade::d3d9
 		std::unordered_map<com_ptr<IDirect3DSurface9>, depth_source_info> _depth_source_table;
 		std::vector<depth_source_info> _depth_buffer_table;
 
+		std::unordered_map<std::string, effect_shader_cache_entry<com_ptr<IUnknown>>> _effect_shaders; // Shader objects by their byte code
+		std::unordered_map<std::string, effect_shader_cache_entry<std::pair<std::vector<uint8_t>, std::string>>> _effect_shader_sources; // Byte code and compiler warnings by the profile, entry point and code they were compiled from
+		std::mutex _effect_shader_sources_mutex;
+
 		com_ptr<IDirect3DVertexBuffer9> _effect_triangle_buffer;
 		com_ptr<IDirect3DVertexDeclaration9> _effect_triangle_layout;
 
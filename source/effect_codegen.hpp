@@ -6,6 +6,7 @@
 #pragma once
 
 #include "effect_lexer.hpp"
+#include <memory>
 #include <algorithm>
 
 namespace reshadefx
@@ -13,7 +14,7 @@ namespace reshadefx
 	/// <summary>
 	/// A SSA code generation back-end interface for the parser to call into.
 	/// </summary>
-	class codegen abstract
+	class codegen
 	{
 	public:
 		/// <summary>
@@ -289,15 +290,207 @@ namespace reshadefx
 				[id](const auto &it) { return it->definition == id; })->get();
 		}
 
+		/// <summary>
+		/// Get the number of SSA IDs allocated so far.
+		/// </summary>
+		id id_count() const { return _next_id - 1; }
+
 	protected:
 		id make_id() { return _next_id++; }
 
+		/// <summary>
+		/// Size and alignment requirements of a uniform variable in the buffer layout of a back-end.
+		/// </summary>
+		struct uniform_layout
+		{
+			uint32_t size = 0;
+			uint32_t alignment = 4;
+			bool within_register = false; // Whether the variable must not cross a 16-byte boundary (HLSL packing rules)
+			bool per_frame = false; // Whether the variable is placed in the separate buffer for variables updated every frame
+		};
+
+		/// <summary>
+		/// Check whether a uniform variable is updated by the runtime every frame (e.g. the frame time or mouse position), which is the case for all variables with a "source" annotation.
+		/// </summary>
+		static bool is_per_frame_uniform(const uniform_info &info)
+		{
+			return info.annotations.find("source") != info.annotations.end();
+		}
+
+		/// <summary>
+		/// Assign offsets to uniform variables, either in declaration order or reordered so that smaller variables fill the padding holes left by larger ones.
+		/// Variables updated every frame are placed after all others, starting at the next 16-byte boundary.
+		/// </summary>
+		/// <param name="layouts">The size and alignment requirements of every variable.</param>
+		/// <param name="offsets">The resulting offset of every variable.</param>
+		/// <param name="reorder">Whether to reorder variables to minimize padding.</param>
+		/// <returns>The total size of the buffer, rounded up to a multiple of 16 bytes.</returns>
+		static uint32_t layout_uniforms(const std::vector<uniform_layout> &layouts, std::vector<uint32_t> &offsets, bool reorder)
+		{
+			std::vector<size_t> order(layouts.size());
+			for (size_t i = 0; i < order.size(); ++i)
+				order[i] = i;
+
+			// Place variables with the largest alignment first, so that the remaining ones can be fitted into the holes in between
+			if (reorder)
+				std::stable_sort(order.begin(), order.end(), [&layouts](size_t lhs, size_t rhs) {
+					if (layouts[lhs].per_frame != layouts[rhs].per_frame)
+						return layouts[rhs].per_frame;
+					return layouts[lhs].alignment > layouts[rhs].alignment || (layouts[lhs].alignment == layouts[rhs].alignment && layouts[lhs].size > layouts[rhs].size); });
+			else
+				std::stable_sort(order.begin(), order.end(), [&layouts](size_t lhs, size_t rhs) {
+					return !layouts[lhs].per_frame && layouts[rhs].per_frame; });
+
+			offsets.assign(layouts.size(), 0);
+
+			uint32_t base = 0;
+			uint32_t total_size = 0;
+			bool in_per_frame_buffer = false;
+			std::vector<std::pair<uint32_t, uint32_t>> occupied;
+
+			for (const size_t index : order)
+			{
+				const uniform_layout &layout = layouts[index];
+
+				// The second buffer starts at a 16-byte boundary after the first one
+				if (layout.per_frame && !in_per_frame_buffer)
+				{
+					in_per_frame_buffer = true;
+					base = total_size = (total_size + 15) & ~15u;
+				}
+
+				// Declaration order never looks back, reordering searches for the first hole that is large enough
+				uint32_t offset = reorder ? base : total_size;
+				for (bool moved = true; moved;)
+				{
+					moved = false;
+
+					if (offset % layout.alignment != 0)
+						offset += layout.alignment - offset % layout.alignment;
+					if (layout.within_register && layout.size <= 16 && offset / 16 != (offset + layout.size - 1) / 16)
+						offset += 16 - offset % 16;
+
+					for (const auto &range : occupied)
+					{
+						if (offset < range.second && range.first < offset + layout.size)
+						{
+							offset = range.second;
+							moved = true;
+							break;
+						}
+					}
+				}
+
+				offsets[index] = offset;
+				occupied.emplace_back(offset, offset + layout.size);
+				total_size = std::max(total_size, offset + layout.size);
+			}
+
+			return (total_size + 15) & ~15u;
+		}
+
+		/// <summary>
+		/// Description of a load or pure intrinsic call, used to find an identical operation earlier in the same basic block whose result can be reused.
+		/// </summary>
+		struct value_key
+		{
+			std::vector<uint32_t> data;
+			std::vector<id> operands; // Variables and values the result depends on, so that it can be invalidated when one of them is modified
+		};
+
+		/// <summary>
+		/// Create the key describing a load through the specified access chain.
+		/// </summary>
+		static value_key make_load_key(const expression &exp)
+		{
+			value_key key;
+			key.data = { 0, exp.base };
+			append_type(key.data, exp.type);
+			key.operands.push_back(exp.base);
+
+			for (const auto &op : exp.chain)
+			{
+				key.data.push_back(op.op);
+				append_type(key.data, op.from);
+				append_type(key.data, op.to);
+				key.data.push_back(op.index);
+				key.data.push_back(static_cast<uint8_t>(op.swizzle[0]) | (static_cast<uint8_t>(op.swizzle[1]) << 8) | (static_cast<uint8_t>(op.swizzle[2]) << 16) | (static_cast<uint8_t>(op.swizzle[3]) << 24));
+
+				if (op.op == expression::operation::op_dynamic_index)
+					key.operands.push_back(op.index);
+			}
+
+			return key;
+		}
+		/// <summary>
+		/// Create the key describing a call to an intrinsic function.
+		/// </summary>
+		static value_key make_intrinsic_key(id intrinsic, const type &res_type, const std::vector<expression> &args)
+		{
+			value_key key;
+			key.data = { 1, intrinsic };
+			append_type(key.data, res_type);
+
+			for (const auto &arg : args)
+			{
+				key.data.push_back(arg.base);
+				key.operands.push_back(arg.base);
+			}
+
+			return key;
+		}
+		static void append_type(std::vector<uint32_t> &data, const type &type)
+		{
+			data.insert(data.end(), { type.base, type.rows, type.cols, type.qualifiers, static_cast<uint32_t>(type.array_length), type.definition });
+		}
+
+		/// <summary>
+		/// Look up the result of an identical operation that was added earlier in the current basic block.
+		/// </summary>
+		/// <param name="key">The description of the operation.</param>
+		/// <returns>SSA ID of the previous result, or zero if there is none.</returns>
+		id find_cached_value(const value_key &key)
+		{
+			// Results are only reused within a single basic block, so forget them whenever the block changes
+			if (_cached_values_block != _current_block)
+			{
+				_cached_values.clear();
+				_cached_values_block = _current_block;
+			}
+
+			const auto it = std::find_if(_cached_values.begin(), _cached_values.end(),
+				[&key](const auto &it) { return it.first.data == key.data; });
+			return it != _cached_values.end() ? it->second : 0;
+		}
+		/// <summary>
+		/// Remember the result of an operation, so that identical ones later in the current basic block can reuse it.
+		/// </summary>
+		/// <param name="key">The description of the operation, previously passed to <see cref="find_cached_value"/>.</param>
+		/// <param name="result">SSA ID of the result.</param>
+		void cache_value(value_key &&key, id result)
+		{
+			// Code outside of functions is not split into basic blocks, so cannot tell which results are reachable there
+			if (is_in_block())
+				_cached_values.emplace_back(std::move(key), result);
+		}
+		/// <summary>
+		/// Forget all cached results that depend on the specified variable, since they are no longer valid after it was modified.
+		/// </summary>
+		/// <param name="modified">The ID of the modified variable, or zero if any variable may have been modified (e.g. by a function call).</param>
+		void invalidate_cached_values(id modified = 0)
+		{
+			_cached_values.erase(std::remove_if(_cached_values.begin(), _cached_values.end(),
+				[modified](const auto &it) { return modified == 0 || std::find(it.first.operands.begin(), it.first.operands.end(), modified) != it.first.operands.end(); }), _cached_values.end());
+		}
+
 		module _module;
 		std::vector<struct_info> _structs;
 		std::vector<std::unique_ptr<function_info>> _functions;
 		id _next_id = 1;
 		id _last_block = 0;
 		id _current_block = 0;
+		id _cached_values_block = 0;
+		std::vector<std::pair<value_key, id>> _cached_values;
 	};
 
 	/// <summary>
@@ -305,18 +498,36 @@ namespace reshadefx
 	/// </summary>
 	/// <param name="debug_info">Whether to append debug information like line directives to the generated code.</param>
 	/// <param name="uniforms_to_spec_constants">Whether to convert uniform variables to specialization constants.</param>
-	codegen *create_codegen_glsl(bool debug_info, bool uniforms_to_spec_constants);
+	/// <param name="optimize_uniform_layout">Whether to reorder uniform variables in the uniform buffer to minimize padding.</param>
+	/// <param name="split_uniform_buffers">Whether to put uniform variables updated every frame into a separate uniform buffer at binding 1.</param>
+	codegen *create_codegen_glsl(bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout, bool split_uniform_buffers);
 	/// <summary>
 	/// Create a back-end implementation for HLSL code generation.
 	/// </summary>
 	/// <param name="shader_model">The HLSL shader model version (e.g. 30, 41, 50, 60, ...)</param>
 	/// <param name="debug_info">Whether to append debug information like line directives to the generated code.</param>
 	/// <param name="uniforms_to_spec_constants">Whether to convert uniform variables to specialization constants.</param>
-	codegen *create_codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants);
+	/// <param name="optimize_uniform_layout">Whether to reorder uniform variables in the uniform buffer to minimize padding.</param>
+	/// <param name="split_uniform_buffers">Whether to put uniform variables updated every frame into a separate constant buffer at register b1 (shader model 4 and up).</param>
+	codegen *create_codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout, bool split_uniform_buffers);
 	/// <summary>
 	/// Create a back-end implementation for SPIR-V code generation.
 	/// </summary>
 	/// <param name="debug_info">Whether to append debug information like line directives to the generated code.</param>
 	/// <param name="uniforms_to_spec_constants">Whether to convert uniform variables to specialization constants.</param>
-	codegen *create_codegen_spirv(bool debug_info, bool uniforms_to_spec_constants);
+	/// <param name="optimize_uniform_layout">Whether to reorder uniform variables in the uniform buffer to minimize padding.</param>
+	codegen *create_codegen_spirv(bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout);
+
+	/// <summary>
+	/// Create a back-end implementation which does not generate any code, but records all operations so that they can later be replayed into one or more other back-ends.
+	/// This makes it possible to parse an effect once and generate code for multiple back-ends from it.
+	/// </summary>
+	codegen *create_codegen_recorder();
+	/// <summary>
+	/// Replay all operations recorded by a back-end created with <see cref="create_codegen_recorder"/> into the specified <paramref name="target"/> back-end.
+	/// The recording is not modified, so multiple replays into different back-ends may run concurrently on different threads.
+	/// </summary>
+	/// <param name="recording">The recording back-end the parser was run with.</param>
+	/// <param name="target">The back-end to generate code with.</param>
+	void replay_codegen(const codegen &recording, codegen &target);
 }
@@ -13,8 +13,8 @@ using namespace reshadefx;
 class codegen_glsl final : public codegen
 {
 public:
-	codegen_glsl(bool debug_info, bool uniforms_to_spec_constants)
-		: _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants)
+	codegen_glsl(bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout, bool split_uniform_buffers)
+		: _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants), _optimize_uniform_layout(optimize_uniform_layout), _split_uniform_buffers(split_uniform_buffers)
 	{
 		// Create default block and reserve a memory block to avoid frequent reallocations
 		std::string &block = _blocks.emplace(0, std::string()).first->second;
@@ -33,15 +33,46 @@ private:
 	};
 
 	std::string _ubo_block;
+	std::string _per_frame_ubo_block;
+	std::vector<std::string> _ubo_declarations;
 	std::unordered_map<id, std::string> _names;
 	std::unordered_map<id, std::string> _blocks;
 	bool _debug_info = false;
 	bool _uniforms_to_spec_constants = false;
+	bool _optimize_uniform_layout = false;
+	bool _split_uniform_buffers = false;
 	unsigned int _current_ubo_offset = 0;
+	unsigned int _current_per_frame_ubo_offset = 0;
+	unsigned int _current_spec_constant_id = 0;
 	std::unordered_map<id, id> _remapped_sampler_variables;
 
 	void write_result(module &module) override
 	{
+		if (_optimize_uniform_layout)
+			optimize_uniform_layout();
+		else
+		{
+			_module.total_uniform_size = (_current_ubo_offset + 15) & ~15;
+
+			if (_split_uniform_buffers)
+			{
+				// The buffer with variables updated every frame follows the other one in the uniform storage
+				_module.per_frame_uniform_offset = _module.total_uniform_size;
+				_module.total_uniform_size += (_current_per_frame_ubo_offset + 15) & ~15;
+
+				for (uniform_info &info : _module.uniforms)
+					if (is_per_frame_uniform(info))
+						info.offset += _module.per_frame_uniform_offset;
+			}
+		}
+
+		// Fall back to a single buffer if there are no variables that are not updated every frame
+		if (_module.per_frame_uniform_offset == 0)
+		{
+			_ubo_block += _per_frame_ubo_block;
+			_per_frame_ubo_block.clear();
+		}
+
 		module = std::move(_module);
 
 		module.hlsl +=
@@ -55,9 +86,85 @@ private:
 
 		if (!_ubo_block.empty())
 			module.hlsl += "layout(std140, binding = 0) uniform _Globals {\n" + _ubo_block + "};\n";
+		if (!_per_frame_ubo_block.empty())
+			module.hlsl += "layout(std140, binding = 1) uniform _PerFrame {\n" + _per_frame_ubo_block + "};\n";
 		module.hlsl += _blocks.at(0);
 	}
 
+	void optimize_uniform_layout()
+	{
+		std::vector<uniform_layout> layouts;
+		layouts.reserve(_module.uniforms.size());
+
+		// GLSL specification on std140 layout:
+		// 1. If the member is a scalar consuming N basic machine units, the base alignment is N.
+		// 2. If the member is a two- or four-component vector with components consuming N basic machine units, the base alignment is 2N or 4N, respectively.
+		// 3. If the member is a three-component vector with components consuming N basic machine units, the base alignment is 4N.
+		// 4. If the member is an array of scalars or vectors, the base alignment and array stride are set to match the base alignment of a single array element, according to rules (1), (2), and (3), and rounded up to the base alignment of a vec4.
+		// 5. If the member is a column-major matrix with C columns and R rows, the matrix is stored identically to an array of C column vectors with R components each, according to rule (4).
+		for (const uniform_info &info : _module.uniforms)
+		{
+			uniform_layout &layout = layouts.emplace_back();
+
+			if (info.type.is_matrix())
+			{
+				// Matrices are declared as 'matRxC', which GLSL interprets as R columns with C components each
+				layout.size = 16 * info.type.rows;
+				layout.alignment = 16;
+			}
+			else
+			{
+				layout.size = 4 * info.type.rows;
+				layout.alignment = 4 * (info.type.rows == 3 ? 4 : info.type.rows);
+			}
+
+			if (info.type.is_array())
+			{
+				layout.size = ((layout.size + 15) & ~15) * info.type.array_length;
+				layout.alignment = 16;
+			}
+
+			layout.per_frame = _split_uniform_buffers && is_per_frame_uniform(info);
+		}
+
+		std::vector<uint32_t> offsets, packed_offsets;
+		const uint32_t unpacked_size = layout_uniforms(layouts, offsets, false);
+		const uint32_t packed_size = layout_uniforms(layouts, packed_offsets, true);
+
+		// Only use the reordered layout if it actually is smaller
+		if (packed_size < unpacked_size)
+		{
+			offsets = std::move(packed_offsets);
+			_module.uniform_bytes_saved = unpacked_size - packed_size;
+		}
+
+		_module.total_uniform_size = std::min(packed_size, unpacked_size);
+
+		if (_split_uniform_buffers)
+		{
+			_module.per_frame_uniform_offset = _module.total_uniform_size;
+			for (size_t i = 0; i < _module.uniforms.size(); ++i)
+				if (layouts[i].per_frame)
+					_module.per_frame_uniform_offset = std::min(_module.per_frame_uniform_offset, offsets[i]);
+		}
+
+		std::vector<size_t> order(_module.uniforms.size());
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+			_module.uniforms[i].offset = offsets[i];
+		}
+
+		// Declare members in the order of their offsets, so that the implicit std140 layout matches the chosen one
+		std::sort(order.begin(), order.end(), [&offsets](size_t lhs, size_t rhs) { return offsets[lhs] < offsets[rhs]; });
+
+		for (const size_t index : order)
+			if (layouts[index].per_frame && _module.per_frame_uniform_offset != 0)
+				_per_frame_ubo_block += _ubo_declarations[index];
+			else
+				_ubo_block += _ubo_declarations[index];
+	}
+
 	template <bool is_param = false, bool is_decl = true, bool is_interface = false>
 	void write_type(std::string &s, const type &type) const
 	{
@@ -184,8 +291,8 @@ private:
 				s += std::to_string(data.as_uint[i]) + 'u';
 				break;
 			case type::t_float:
-				std::string temp(_scprintf("%.8f", data.as_float[i]), '\0');
-				sprintf_s(temp.data(), temp.size() + 1, "%.8f", data.as_float[i]);
+				std::string temp(std::snprintf(nullptr, 0, "%.8f", data.as_float[i]), '\0');
+				std::snprintf(temp.data(), temp.size() + 1, "%.8f", data.as_float[i]);
 				s += temp;
 				break;
 			}
@@ -220,12 +327,12 @@ private:
 		return '_' + std::to_string(id);
 	}
 
-	template <naming naming = naming::general>
+	template <naming naming_type = naming::general>
 	void define_name(const id id, std::string name)
 	{
-		if constexpr (naming != naming::reserved)
+		if constexpr (naming_type != naming::reserved)
 			escape_name(name);
-		if constexpr (naming == naming::general)
+		if constexpr (naming_type == naming::general)
 			if (std::find_if(_names.begin(), _names.end(), [&name](const auto &it) { return it.second == name; }) != _names.end())
 				name += '_' + std::to_string(id);
 		// Remove double underscore symbols from name which can occur due to namespaces but are not allowed in GLSL
@@ -324,8 +431,13 @@ private:
 
 		define_name<naming::unique>(res, "_Globals_" + info.name);
 
-		if (_uniforms_to_spec_constants && info.has_initializer_value)
+		if (_uniforms_to_spec_constants && !info.type.is_array() && info.has_initializer_value)
 		{
+			// Keep specialization constant IDs consistent with the SPIR-V code generation, where every component gets its own ID
+			info.size = 4 * info.type.components();
+			info.offset = _current_spec_constant_id;
+			_current_spec_constant_id += info.type.components();
+
 			std::string &code = _blocks.at(_current_block);
 
 			write_location(code, loc);
@@ -348,15 +460,25 @@ private:
 			const unsigned int size = 4 * info.type.rows * info.type.cols * std::max(1, info.type.array_length);
 			const unsigned int alignment = 4 * (info.type.rows == 3 ? 4 : info.type.rows) * info.type.cols * std::max(1, info.type.array_length);
 
+			// Variables updated every frame are laid out in a separate buffer (offsets are adjusted in 'write_result')
+			const bool per_frame = _split_uniform_buffers && is_per_frame_uniform(info);
+			unsigned int &ubo_offset = per_frame ? _current_per_frame_ubo_offset : _current_ubo_offset;
+
 			info.size = size;
-			info.offset = (_current_ubo_offset % alignment != 0) ? _current_ubo_offset + alignment - _current_ubo_offset % alignment : _current_ubo_offset;
-			_current_ubo_offset = info.offset + info.size;
+			info.offset = (ubo_offset % alignment != 0) ? ubo_offset + alignment - ubo_offset % alignment : ubo_offset;
+			ubo_offset = info.offset + info.size;
+
+			// Defer writing the declaration when optimizing the layout, since the final member order is only known after all variables were added (see 'optimize_uniform_layout')
+			std::string &declaration = _optimize_uniform_layout ? _ubo_declarations.emplace_back() : per_frame ? _per_frame_ubo_block : _ubo_block;
 
-			write_location(_ubo_block, loc);
+			write_location(declaration, loc);
 
-			_ubo_block += '\t';
-			write_type(_ubo_block, info.type);
-			_ubo_block += ' ' + id_to_name(res) + ";\n";
+			declaration += '\t';
+			write_type(declaration, info.type);
+			declaration += ' ' + id_to_name(res);
+			if (_optimize_uniform_layout && info.type.is_array()) // The optimized layout accounts for the array element padding, so can declare the full array
+				declaration += '[' + std::to_string(info.type.array_length) + ']';
+			declaration += ";\n";
 
 			_module.uniforms.push_back(info);
 		}
@@ -622,6 +744,11 @@ private:
 		else if (exp.chain.empty()) // Can refer to values without access chain directly
 			return exp.base;
 
+		// Reuse the result of an identical load earlier in the same block
+		value_key key = make_load_key(exp);
+		if (const id cached = find_cached_value(key))
+			return cached;
+
 		const id res = make_id();
 
 		std::string &code = _blocks.at(_current_block);
@@ -686,10 +813,14 @@ private:
 		code += newcode;
 		code += ";\n";
 
+		cache_value(std::move(key), res);
+
 		return res;
 	}
 	void emit_store(const expression &exp, id value) override
 	{
+		invalidate_cached_values(exp.base);
+
 		if (const auto it = _remapped_sampler_variables.find(exp.base); it != _remapped_sampler_variables.end())
 		{
 			assert(it->second == 0);
@@ -962,6 +1093,9 @@ private:
 		for (const auto &arg : args)
 			assert(arg.chain.empty() && arg.base != 0);
 
+		// The called function may modify global variables, so cannot reuse any results loaded before
+		invalidate_cached_values();
+
 		const id res = make_id();
 
 		std::string &code = _blocks.at(_current_block);
@@ -1000,6 +1134,15 @@ private:
 		for (const auto &arg : args)
 			assert(arg.chain.empty() && arg.base != 0);
 
+		// Intrinsics without output parameters have no side effects, so can reuse the result of an identical call earlier in the same block
+		const bool is_pure = std::none_of(args.begin(), args.end(), [](const expression &arg) { return arg.is_lvalue; });
+
+		value_key key = make_intrinsic_key(intrinsic, res_type, args);
+		if (!is_pure)
+			invalidate_cached_values();
+		else if (const id cached = find_cached_value(key))
+			return cached;
+
 		const id res = make_id();
 
 		std::string &code = _blocks.at(_current_block);
@@ -1030,6 +1173,9 @@ private:
 
 		code += ";\n";
 
+		if (is_pure)
+			cache_value(std::move(key), res);
+
 		return res;
 	}
 	id   emit_construct(const location &loc, const type &type, const std::vector<expression> &args) override
@@ -1359,7 +1505,7 @@ private:
 	}
 };
 
-codegen *reshadefx::create_codegen_glsl(bool debug_info, bool uniforms_to_spec_constants)
+codegen *reshadefx::create_codegen_glsl(bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout, bool split_uniform_buffers)
 {
-	return new codegen_glsl(debug_info, uniforms_to_spec_constants);
+	return new codegen_glsl(debug_info, uniforms_to_spec_constants, optimize_uniform_layout, split_uniform_buffers);
 }
@@ -12,8 +12,8 @@ using namespace reshadefx;
 class codegen_hlsl final : public codegen
 {
 public:
-	codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants)
-		: _shader_model(shader_model), _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants)
+	codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout, bool split_uniform_buffers)
+		: _shader_model(shader_model), _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants), _optimize_uniform_layout(optimize_uniform_layout && shader_model >= 40), _split_uniform_buffers(split_uniform_buffers && shader_model >= 40)
 	{
 		// Create default block and reserve a memory block to avoid frequent reallocations
 		std::string &block = _blocks.emplace(0, std::string()).first->second;
@@ -30,16 +30,47 @@ private:
 	};
 
 	std::string _cbuffer_block;
+	std::string _per_frame_cbuffer_block;
+	std::vector<std::string> _cbuffer_declarations;
 	std::string _current_location;
 	std::unordered_map<id, std::string> _names;
 	std::unordered_map<id, std::string> _blocks;
 	bool _debug_info = false;
 	bool _uniforms_to_spec_constants = false;
+	bool _optimize_uniform_layout = false;
+	bool _split_uniform_buffers = false;
 	unsigned int _shader_model = 0;
 	unsigned int _current_cbuffer_size = 0;
+	unsigned int _current_per_frame_cbuffer_size = 0;
+	unsigned int _current_spec_constant_id = 0;
 
 	void write_result(module &module) override
 	{
+		if (_optimize_uniform_layout)
+			optimize_uniform_layout();
+		else
+		{
+			_module.total_uniform_size = (_current_cbuffer_size + 15) & ~15;
+
+			if (_split_uniform_buffers)
+			{
+				// The buffer with variables updated every frame follows the other one in the uniform storage
+				_module.per_frame_uniform_offset = _module.total_uniform_size;
+				_module.total_uniform_size += (_current_per_frame_cbuffer_size + 15) & ~15;
+
+				for (uniform_info &info : _module.uniforms)
+					if (is_per_frame_uniform(info))
+						info.offset += _module.per_frame_uniform_offset;
+			}
+		}
+
+		// Fall back to a single buffer if there are no variables that are not updated every frame
+		if (_module.per_frame_uniform_offset == 0)
+		{
+			_cbuffer_block += _per_frame_cbuffer_block;
+			_per_frame_cbuffer_block.clear();
+		}
+
 		module = std::move(_module);
 
 		if (_shader_model >= 40)
@@ -47,7 +78,9 @@ private:
 			module.hlsl += "struct __sampler2D { Texture2D t; SamplerState s; };\n";
 
 			if (!_cbuffer_block.empty())
-				module.hlsl += "cbuffer _Globals {\n" + _cbuffer_block + "};\n";
+				module.hlsl += (_per_frame_cbuffer_block.empty() ? "cbuffer _Globals {\n" : "cbuffer _Globals : register(b0) {\n") + _cbuffer_block + "};\n";
+			if (!_per_frame_cbuffer_block.empty())
+				module.hlsl += "cbuffer _PerFrame : register(b1) {\n" + _per_frame_cbuffer_block + "};\n";
 		}
 		else
 		{
@@ -60,6 +93,76 @@ private:
 		module.hlsl += _blocks.at(0);
 	}
 
+	void optimize_uniform_layout()
+	{
+		std::vector<uniform_layout> layouts;
+		layouts.reserve(_module.uniforms.size());
+
+		for (const uniform_info &info : _module.uniforms)
+		{
+			uniform_layout &layout = layouts.emplace_back();
+
+			if (info.type.is_matrix())
+			{
+				// Every matrix row or column (depending on packing order) starts in a new constant register
+				layout.size = 16 * std::max(info.type.rows, info.type.cols);
+				layout.alignment = 16;
+			}
+			else
+			{
+				layout.size = 4 * info.type.rows;
+				layout.within_register = true;
+			}
+
+			if (info.type.is_array())
+			{
+				// Every array element starts in a new constant register too
+				layout.size = ((layout.size + 15) & ~15) * (info.type.array_length - 1) + layout.size;
+				layout.alignment = 16;
+				layout.within_register = false;
+			}
+
+			layout.per_frame = _split_uniform_buffers && is_per_frame_uniform(info);
+		}
+
+		std::vector<uint32_t> offsets, packed_offsets;
+		const uint32_t unpacked_size = layout_uniforms(layouts, offsets, false);
+		const uint32_t packed_size = layout_uniforms(layouts, packed_offsets, true);
+
+		// Only use the reordered layout if it actually is smaller
+		if (packed_size < unpacked_size)
+		{
+			offsets = std::move(packed_offsets);
+			_module.uniform_bytes_saved = unpacked_size - packed_size;
+		}
+
+		_module.total_uniform_size = std::min(packed_size, unpacked_size);
+
+		if (_split_uniform_buffers)
+		{
+			_module.per_frame_uniform_offset = _module.total_uniform_size;
+			for (size_t i = 0; i < _module.uniforms.size(); ++i)
+				if (layouts[i].per_frame)
+					_module.per_frame_uniform_offset = std::min(_module.per_frame_uniform_offset, offsets[i]);
+		}
+
+		// Offsets are explicit, so the declaration order no longer matters
+		for (size_t i = 0; i < _module.uniforms.size(); ++i)
+		{
+			_module.uniforms[i].offset = offsets[i];
+
+			// Pack offsets are relative to the start of the buffer the variable is declared in
+			const bool per_frame = layouts[i].per_frame && _module.per_frame_uniform_offset != 0;
+			const uint32_t offset = per_frame ? offsets[i] - _module.per_frame_uniform_offset : offsets[i];
+			std::string &block = per_frame ? _per_frame_cbuffer_block : _cbuffer_block;
+
+			block += _cbuffer_declarations[i] + " : packoffset(c" + std::to_string(offset / 16);
+			if (offset % 16 != 0)
+				block += std::string(1, '.') + "xyzw"[(offset % 16) / 4];
+			block += ");\n";
+		}
+	}
+
 	template <bool is_param = false, bool is_decl = true>
 	void write_type(std::string &s, const type &type) const
 	{
@@ -173,8 +276,8 @@ private:
 				s += std::to_string(data.as_uint[i]);
 				break;
 			case type::t_float:
-				std::string temp(_scprintf("%.8f", data.as_float[i]), '\0');
-				sprintf_s(temp.data(), temp.size() + 1, "%.8f", data.as_float[i]);
+				std::string temp(std::snprintf(nullptr, 0, "%.8f", data.as_float[i]), '\0');
+				std::snprintf(temp.data(), temp.size() + 1, "%.8f", data.as_float[i]);
 				s += temp;
 				break;
 			}
@@ -246,10 +349,10 @@ private:
 		return '_' + std::to_string(id);
 	}
 
-	template <naming naming = naming::general>
+	template <naming naming_type = naming::general>
 	void define_name(const id id, std::string name)
 	{
-		if constexpr (naming == naming::general)
+		if constexpr (naming_type == naming::general)
 			if (std::find_if(_names.begin(), _names.end(), [&name](const auto &it) { return it.second == name; }) != _names.end())
 				name += '_' + std::to_string(id);
 		_names[id] = std::move(name);
@@ -380,8 +483,13 @@ private:
 
 		define_name<naming::unique>(res, "_Globals_" + info.name);
 
-		if (_uniforms_to_spec_constants && info.has_initializer_value)
+		if (_uniforms_to_spec_constants && !info.type.is_array() && info.has_initializer_value)
 		{
+			// Keep specialization constant IDs consistent with the SPIR-V code generation, where every component gets its own ID
+			info.size = 4 * info.type.components();
+			info.offset = _current_spec_constant_id;
+			_current_spec_constant_id += info.type.components();
+
 			std::string &code = _blocks.at(_current_block);
 
 			write_location(code, loc);
@@ -397,15 +505,22 @@ private:
 		}
 		else
 		{
+			// Variables updated every frame are laid out in a separate buffer (offsets are adjusted in 'write_result')
+			const bool per_frame = _split_uniform_buffers && is_per_frame_uniform(info);
+			unsigned int &cbuffer_size = per_frame ? _current_per_frame_cbuffer_size : _current_cbuffer_size;
+
 			const unsigned int size = info.type.rows * info.type.cols * std::max(1, info.type.array_length) * 4;
-			const unsigned int alignment = 16 - (_current_cbuffer_size % 16);
+			const unsigned int alignment = 16 - (cbuffer_size % 16);
 
-			_current_cbuffer_size += (size > alignment && (alignment != 16 || size <= 16)) ? size + alignment : size;
+			cbuffer_size += (size > alignment && (alignment != 16 || size <= 16)) ? size + alignment : size;
 
 			info.size = size;
-			info.offset = _current_cbuffer_size - size;
+			info.offset = cbuffer_size - size;
+
+			// Defer writing the declaration when optimizing the layout, since the final offset is only known after all variables were added (see 'optimize_uniform_layout')
+			std::string &declaration = _optimize_uniform_layout ? _cbuffer_declarations.emplace_back() : per_frame ? _per_frame_cbuffer_block : _cbuffer_block;
 
-			write_location<true>(_cbuffer_block, loc);
+			write_location<true>(declaration, loc);
 
 			if (_shader_model < 40)
 			{
@@ -418,14 +533,19 @@ private:
 				info.offset *= 4;
 
 				// Every constant register is 16 bytes wide, so divide memory offset by 16 to get the constant register index
-				write_type(_cbuffer_block, type);
-				_cbuffer_block += ' ' + id_to_name(res) + " : register(c" + std::to_string(info.offset / 16) + ");\n";
+				write_type(declaration, type);
+				declaration += ' ' + id_to_name(res) + " : register(c" + std::to_string(info.offset / 16) + ");\n";
 			}
 			else
 			{
-				_cbuffer_block += '\t';
-				write_type(_cbuffer_block, info.type);
-				_cbuffer_block += ' ' + id_to_name(res) + ";\n";
+				declaration += '\t';
+				write_type(declaration, info.type);
+				declaration += ' ' + id_to_name(res);
+
+				if (!_optimize_uniform_layout)
+					declaration += ";\n";
+				else if (info.type.is_array()) // The optimized layout accounts for the array element padding, so can declare the full array
+					declaration += '[' + std::to_string(info.type.array_length) + ']';
 			}
 
 			_module.uniforms.push_back(info);
@@ -617,6 +737,11 @@ private:
 		else if (exp.chain.empty()) // Can refer to values without access chain directly
 			return exp.base;
 
+		// Reuse the result of an identical load earlier in the same block
+		value_key key = make_load_key(exp);
+		if (const id cached = find_cached_value(key))
+			return cached;
+
 		const id res = make_id();
 
 		std::string &code = _blocks.at(_current_block);
@@ -673,10 +798,14 @@ private:
 		code += newcode;
 		code += ";\n";
 
+		cache_value(std::move(key), res);
+
 		return res;
 	}
 	void emit_store(const expression &exp, id value) override
 	{
+		invalidate_cached_values(exp.base);
+
 		std::string &code = _blocks.at(_current_block);
 
 		write_location(code, exp.location);
@@ -894,6 +1023,9 @@ private:
 		for (const auto &arg : args)
 			assert(arg.chain.empty() && arg.base != 0);
 
+		// The called function may modify global variables, so cannot reuse any results loaded before
+		invalidate_cached_values();
+
 		const id res = make_id();
 
 		std::string &code = _blocks.at(_current_block);
@@ -932,6 +1064,15 @@ private:
 		for (const auto &arg : args)
 			assert(arg.chain.empty() && arg.base != 0);
 
+		// Intrinsics without output parameters have no side effects, so can reuse the result of an identical call earlier in the same block
+		const bool is_pure = std::none_of(args.begin(), args.end(), [](const expression &arg) { return arg.is_lvalue; });
+
+		value_key key = make_intrinsic_key(intrinsic, res_type, args);
+		if (!is_pure)
+			invalidate_cached_values();
+		else if (const id cached = find_cached_value(key))
+			return cached;
+
 		const id res = make_id();
 
 		std::string &code = _blocks.at(_current_block);
@@ -968,6 +1109,9 @@ private:
 
 		code += ";\n";
 
+		if (is_pure)
+			cache_value(std::move(key), res);
+
 		return res;
 	}
 	id   emit_construct(const location &loc, const type &type, const std::vector<expression> &args) override
@@ -1349,7 +1493,7 @@ private:
 	}
 };
 
-codegen *reshadefx::create_codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants)
+codegen *reshadefx::create_codegen_hlsl(unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout, bool split_uniform_buffers)
 {
-	return new codegen_hlsl(shader_model, debug_info, uniforms_to_spec_constants);
+	return new codegen_hlsl(shader_model, debug_info, uniforms_to_spec_constants, optimize_uniform_layout, split_uniform_buffers);
 }
@@ -0,0 +1,432 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include <assert.h>
+#include <functional>
+
+using namespace reshadefx;
+
+/// <summary>
+/// State of a replay into a single target back-end, which translates IDs of the recording to the IDs the target returned for the same operation.
+/// </summary>
+struct replay_context
+{
+	explicit replay_context(codegen &target, size_t num_ids) : target(target), ids(num_ids, 0) {}
+
+	codegen::id operator[](codegen::id id) const
+	{
+		assert(id < ids.size());
+		return ids[id];
+	}
+
+	void map(codegen::id recorded, codegen::id actual)
+	{
+		assert(recorded < ids.size());
+		ids[recorded] = actual;
+	}
+
+	type translate(type type) const
+	{
+		type.definition = operator[](type.definition);
+		return type;
+	}
+	expression translate(expression exp) const
+	{
+		exp.type = translate(exp.type);
+		exp.base = operator[](exp.base);
+
+		for (auto &op : exp.chain)
+		{
+			op.from = translate(op.from);
+			op.to = translate(op.to);
+
+			if (op.op == expression::operation::op_dynamic_index)
+				op.index = operator[](op.index);
+		}
+
+		return exp;
+	}
+	std::vector<expression> translate(std::vector<expression> args) const
+	{
+		for (auto &arg : args)
+			arg = translate(std::move(arg));
+		return args;
+	}
+
+	codegen &target;
+	std::vector<codegen::id> ids;
+};
+
+class codegen_recorder final : public codegen
+{
+public:
+	/// <summary>
+	/// Execute all recorded operations on the specified <paramref name="target"/> back-end, in the order the parser issued them.
+	/// This does not modify the recording, so it is safe to replay into several back-ends at the same time.
+	/// </summary>
+	void replay(codegen &target) const
+	{
+		replay_context context(target, _next_id);
+
+		for (const auto &operation : _operations)
+			operation(context);
+
+		// Techniques only reference entry points by name, so they can be copied as is
+		for (technique_info info : _module.techniques)
+			target.define_technique(info);
+	}
+
+private:
+	void write_result(module &module) override
+	{
+		// There is no code to write, but the effect description is still useful to e.g. enumerate techniques without generating code
+		module = _module;
+	}
+
+	void record(std::function<void(replay_context &)> &&operation)
+	{
+		_operations.push_back(std::move(operation));
+	}
+
+	id   define_struct(const location &loc, struct_info &info) override
+	{
+		info.definition = make_id();
+
+		_structs.push_back(info);
+
+		record([loc, info](replay_context &context) {
+			struct_info target_info = info;
+			for (auto &member : target_info.member_list)
+				member.type = context.translate(member.type);
+			context.map(info.definition, context.target.define_struct(loc, target_info));
+		});
+
+		return info.definition;
+	}
+	id   define_texture(const location &loc, texture_info &info) override
+	{
+		info.id = make_id();
+
+		_module.textures.push_back(info);
+
+		record([loc, info](replay_context &context) {
+			texture_info target_info = info;
+			context.map(info.id, context.target.define_texture(loc, target_info));
+		});
+
+		return info.id;
+	}
+	id   define_sampler(const location &loc, sampler_info &info) override
+	{
+		info.id = make_id();
+
+		_module.samplers.push_back(info);
+
+		record([loc, info](replay_context &context) {
+			sampler_info target_info = info;
+			context.map(info.id, context.target.define_sampler(loc, target_info));
+		});
+
+		return info.id;
+	}
+	id   define_uniform(const location &loc, uniform_info &info) override
+	{
+		const id res = make_id();
+
+		_module.uniforms.push_back(info);
+
+		record([loc, info, res](replay_context &context) {
+			uniform_info target_info = info;
+			target_info.type = context.translate(info.type);
+			context.map(res, context.target.define_uniform(loc, target_info));
+		});
+
+		return res;
+	}
+	id   define_variable(const location &loc, const type &type, std::string name, bool global, id initializer_value) override
+	{
+		const id res = make_id();
+
+		record([loc, type, name = std::move(name), global, initializer_value, res](replay_context &context) {
+			context.map(res, context.target.define_variable(loc, context.translate(type), name, global, context[initializer_value]));
+		});
+
+		return res;
+	}
+	id   define_function(const location &loc, function_info &info) override
+	{
+		info.definition = make_id();
+
+		for (auto &param : info.parameter_list)
+			param.definition = make_id();
+
+		_functions.push_back(std::make_unique<function_info>(info));
+
+		record([loc, info](replay_context &context) {
+			function_info target_info = info;
+			target_info.return_type = context.translate(info.return_type);
+			for (auto &param : target_info.parameter_list)
+				param.type = context.translate(param.type);
+
+			context.map(info.definition, context.target.define_function(loc, target_info));
+
+			for (size_t i = 0; i < info.parameter_list.size(); ++i)
+				context.map(info.parameter_list[i].definition, target_info.parameter_list[i].definition);
+		});
+
+		return info.definition;
+	}
+
+	void define_entry_point(const function_info &func, bool is_ps) override
+	{
+		record([definition = func.definition, is_ps](replay_context &context) {
+			context.target.define_entry_point(context.target.find_function(context[definition]), is_ps);
+		});
+	}
+
+	id   emit_load(const expression &exp) override
+	{
+		const id res = make_id();
+
+		record([exp, res](replay_context &context) {
+			context.map(res, context.target.emit_load(context.translate(exp)));
+		});
+
+		return res;
+	}
+	void emit_store(const expression &exp, id value) override
+	{
+		record([exp, value](replay_context &context) {
+			context.target.emit_store(context.translate(exp), context[value]);
+		});
+	}
+
+	id   emit_constant(const type &type, const constant &data) override
+	{
+		const id res = make_id();
+
+		record([type, data, res](replay_context &context) {
+			context.map(res, context.target.emit_constant(context.translate(type), data));
+		});
+
+		return res;
+	}
+
+	id   emit_unary_op(const location &loc, tokenid op, const type &type, id val) override
+	{
+		const id res = make_id();
+
+		record([loc, op, type, val, res](replay_context &context) {
+			context.map(res, context.target.emit_unary_op(loc, op, context.translate(type), context[val]));
+		});
+
+		return res;
+	}
+	id   emit_binary_op(const location &loc, tokenid op, const type &res_type, const type &type, id lhs, id rhs) override
+	{
+		const id res = make_id();
+
+		record([loc, op, res_type, type, lhs, rhs, res](replay_context &context) {
+			context.map(res, context.target.emit_binary_op(loc, op, context.translate(res_type), context.translate(type), context[lhs], context[rhs]));
+		});
+
+		return res;
+	}
+	id   emit_ternary_op(const location &loc, tokenid op, const type &type, id condition, id true_value, id false_value) override
+	{
+		const id res = make_id();
+
+		record([loc, op, type, condition, true_value, false_value, res](replay_context &context) {
+			context.map(res, context.target.emit_ternary_op(loc, op, context.translate(type), context[condition], context[true_value], context[false_value]));
+		});
+
+		return res;
+	}
+	id   emit_call(const location &loc, id function, const type &res_type, const std::vector<expression> &args) override
+	{
+		const id res = make_id();
+
+		record([loc, function, res_type, args, res](replay_context &context) {
+			context.map(res, context.target.emit_call(loc, context[function], context.translate(res_type), context.translate(args)));
+		});
+
+		return res;
+	}
+	id   emit_call_intrinsic(const location &loc, id intrinsic, const type &res_type, const std::vector<expression> &args) override
+	{
+		const id res = make_id();
+
+		// The intrinsic is an index into the intrinsic table and not an SSA ID, so it is passed on unchanged
+		record([loc, intrinsic, res_type, args, res](replay_context &context) {
+			context.map(res, context.target.emit_call_intrinsic(loc, intrinsic, context.translate(res_type), context.translate(args)));
+		});
+
+		return res;
+	}
+	id   emit_construct(const location &loc, const type &type, const std::vector<expression> &args) override
+	{
+		const id res = make_id();
+
+		record([loc, type, args, res](replay_context &context) {
+			context.map(res, context.target.emit_construct(loc, context.translate(type), context.translate(args)));
+		});
+
+		return res;
+	}
+
+	void emit_if(const location &loc, id condition_value, id condition_block, id true_statement_block, id false_statement_block, unsigned int flags) override
+	{
+		record([loc, condition_value, condition_block, true_statement_block, false_statement_block, flags](replay_context &context) {
+			context.target.emit_if(loc, context[condition_value], context[condition_block], context[true_statement_block], context[false_statement_block], flags);
+		});
+	}
+	id   emit_phi(const location &loc, id condition_value, id condition_block, id true_value, id true_statement_block, id false_value, id false_statement_block, const type &type) override
+	{
+		const id res = make_id();
+
+		record([loc, condition_value, condition_block, true_value, true_statement_block, false_value, false_statement_block, type, res](replay_context &context) {
+			context.map(res, context.target.emit_phi(loc, context[condition_value], context[condition_block], context[true_value], context[true_statement_block], context[false_value], context[false_statement_block], context.translate(type)));
+		});
+
+		return res;
+	}
+	void emit_loop(const location &loc, id condition_value, id prev_block, id header_block, id condition_block, id loop_block, id continue_block, unsigned int flags) override
+	{
+		record([loc, condition_value, prev_block, header_block, condition_block, loop_block, continue_block, flags](replay_context &context) {
+			context.target.emit_loop(loc, context[condition_value], context[prev_block], context[header_block], context[condition_block], context[loop_block], context[continue_block], flags);
+		});
+	}
+	void emit_switch(const location &loc, id selector_value, id selector_block, id default_label, const std::vector<id> &case_literal_and_labels, unsigned int flags) override
+	{
+		record([loc, selector_value, selector_block, default_label, case_literal_and_labels, flags](replay_context &context) {
+			// Only every second entry is a block label, the others are case literals
+			std::vector<id> target_case_literal_and_labels = case_literal_and_labels;
+			for (size_t i = 1; i < target_case_literal_and_labels.size(); i += 2)
+				target_case_literal_and_labels[i] = context[target_case_literal_and_labels[i]];
+
+			context.target.emit_switch(loc, context[selector_value], context[selector_block], context[default_label], target_case_literal_and_labels, flags);
+		});
+	}
+
+	id   create_block() override
+	{
+		const id res = make_id();
+
+		record([res](replay_context &context) {
+			context.map(res, context.target.create_block());
+		});
+
+		return res;
+	}
+	id   set_block(id id) override
+	{
+		record([id](replay_context &context) {
+			context.target.set_block(context[id]);
+		});
+
+		_last_block = _current_block;
+		_current_block = id;
+
+		return _last_block;
+	}
+	void enter_block(id id) override
+	{
+		record([id](replay_context &context) {
+			context.target.enter_block(context[id]);
+		});
+
+		_current_block = id;
+	}
+	id   leave_block_and_kill() override
+	{
+		record([](replay_context &context) {
+			context.target.leave_block_and_kill();
+		});
+
+		if (!is_in_block())
+			return 0;
+
+		_last_block = _current_block;
+		_current_block = 0;
+
+		return _last_block;
+	}
+	id   leave_block_and_return(id value) override
+	{
+		record([value](replay_context &context) {
+			context.target.leave_block_and_return(context[value]);
+		});
+
+		if (!is_in_block())
+			return 0;
+
+		_last_block = _current_block;
+		_current_block = 0;
+
+		return _last_block;
+	}
+	id   leave_block_and_switch(id value, id default_target) override
+	{
+		record([value, default_target](replay_context &context) {
+			context.target.leave_block_and_switch(context[value], context[default_target]);
+		});
+
+		if (!is_in_block())
+			return _last_block;
+
+		_last_block = _current_block;
+		_current_block = 0;
+
+		return _last_block;
+	}
+	id   leave_block_and_branch(id target, unsigned int loop_flow) override
+	{
+		record([target, loop_flow](replay_context &context) {
+			context.target.leave_block_and_branch(context[target], loop_flow);
+		});
+
+		if (!is_in_block())
+			return _last_block;
+
+		_last_block = _current_block;
+		_current_block = 0;
+
+		return _last_block;
+	}
+	id   leave_block_and_branch_conditional(id condition, id true_target, id false_target) override
+	{
+		record([condition, true_target, false_target](replay_context &context) {
+			context.target.leave_block_and_branch_conditional(context[condition], context[true_target], context[false_target]);
+		});
+
+		if (!is_in_block())
+			return _last_block;
+
+		_last_block = _current_block;
+		_current_block = 0;
+
+		return _last_block;
+	}
+	void leave_function() override
+	{
+		record([](replay_context &context) {
+			context.target.leave_function();
+		});
+	}
+
+	std::vector<std::function<void(replay_context &)>> _operations;
+};
+
+codegen *reshadefx::create_codegen_recorder()
+{
+	return new codegen_recorder();
+}
+
+void reshadefx::replay_codegen(const codegen &recording, codegen &target)
+{
+	static_cast<const codegen_recorder &>(recording).replay(target);
+}
@@ -7,6 +7,7 @@
 #include "effect_codegen.hpp"
 #include <assert.h>
 #include <algorithm>
+#include <cstring>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -114,8 +115,8 @@ struct spirv_basic_block
 class codegen_spirv final : public codegen
 {
 public:
-	codegen_spirv(bool debug_info, bool uniforms_to_spec_constants)
-		: _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants)
+	codegen_spirv(bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout)
+		: _debug_info(debug_info), _uniforms_to_spec_constants(uniforms_to_spec_constants), _optimize_uniform_layout(optimize_uniform_layout)
 	{
 		_glsl_ext = make_id();
 	}
@@ -123,7 +124,7 @@ public:
 private:
 	struct type_lookup
 	{
-		type type;
+		reshadefx::type type;
 		spv::StorageClass storage;
 		bool is_ptr;
 		spv::Id id;
@@ -163,6 +164,7 @@ private:
 	std::unordered_map<std::string, spv::Id> _string_lookup;
 	std::unordered_map<spv::Id, spv::StorageClass> _storage_lookup;
 	uint32_t _current_semantic_location = 10;
+	uint32_t _current_spec_constant_id = 0;
 	std::unordered_set<spv::Id> _spec_constants;
 
 	std::vector<function_blocks> _functions2;
@@ -171,12 +173,100 @@ private:
 
 	bool _debug_info = false;
 	bool _uniforms_to_spec_constants = false;
+	bool _optimize_uniform_layout = false;
 	id _glsl_ext = 0;
 	struct_info _global_ubo_type;
 	id _global_ubo_variable = 0;
 	uint32_t _global_ubo_offset = 0;
+	std::vector<spv::Id> _global_ubo_member_indices;
 	function_blocks *_current_function = nullptr;
 
+	void optimize_uniform_layout()
+	{
+		std::vector<uniform_layout> layouts;
+		layouts.reserve(_module.uniforms.size());
+
+		// GLSL specification on std140 layout (see 'codegen_glsl::optimize_uniform_layout')
+		for (const uniform_info &info : _module.uniforms)
+		{
+			uniform_layout &layout = layouts.emplace_back();
+
+			if (info.type.is_matrix())
+			{
+				// Matrices are translated to 'OpTypeMatrix' with one column per row of the source type
+				layout.size = 16 * info.type.rows;
+				layout.alignment = 16;
+			}
+			else
+			{
+				layout.size = 4 * info.type.rows;
+				layout.alignment = 4 * (info.type.rows == 3 ? 4 : info.type.rows);
+			}
+
+			if (info.type.is_array())
+			{
+				layout.size = ((layout.size + 15) & ~15) * info.type.array_length;
+				layout.alignment = 16;
+			}
+		}
+
+		std::vector<uint32_t> offsets, packed_offsets;
+		const uint32_t unpacked_size = layout_uniforms(layouts, offsets, false);
+		const uint32_t packed_size = layout_uniforms(layouts, packed_offsets, true);
+
+		// Only use the reordered layout if it actually is smaller
+		if (packed_size < unpacked_size)
+		{
+			offsets = std::move(packed_offsets);
+			_module.uniform_bytes_saved = unpacked_size - packed_size;
+		}
+
+		_module.total_uniform_size = std::min(packed_size, unpacked_size);
+
+		std::vector<uint32_t> order(_module.uniforms.size());
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+			_module.uniforms[i].offset = offsets[i];
+		}
+
+		// Struct members have to be in the order of their offsets
+		std::sort(order.begin(), order.end(), [&offsets](uint32_t lhs, uint32_t rhs) { return offsets[lhs] < offsets[rhs]; });
+
+		std::vector<struct_member_info> member_list;
+		member_list.reserve(order.size());
+
+		for (uint32_t member_index = 0; member_index < order.size(); ++member_index)
+		{
+			const uint32_t uniform_index = order[member_index];
+			member_list.push_back(std::move(_global_ubo_type.member_list[uniform_index]));
+
+			add_member_decoration(_global_ubo_type.definition, member_index, spv::DecorationOffset, { offsets[uniform_index] });
+
+			// Now that the final member index is known, define the constant that all access chains into the UBO referenced (see 'emit_global_ubo_member_index')
+			if (const spv::Id constant = _global_ubo_member_indices[uniform_index]; constant != 0)
+			{
+				const spv::Id uint_type = convert_type({ type::t_uint, 1, 1 });
+				_types_and_constants.instructions.emplace_back(spv::OpConstant, uint_type, constant).add(member_index);
+			}
+		}
+
+		_global_ubo_type.member_list = std::move(member_list);
+	}
+
+	spv::Id emit_global_ubo_member_index(uint32_t uniform_index)
+	{
+		if (!_optimize_uniform_layout)
+			return emit_constant(uniform_index);
+
+		// The member order is only decided after all uniform variables were added, so reference a constant that is defined later (see 'optimize_uniform_layout')
+		spv::Id &constant = _global_ubo_member_indices[uniform_index];
+		if (constant == 0)
+			constant = make_id();
+
+		return constant;
+	}
+
 	inline void add_location(const location &loc, spirv_basic_block &block)
 	{
 		if (loc.source.empty() || !_debug_info)
@@ -223,6 +313,11 @@ private:
 		// First create the UBO struct type now that all member types are known
 		if (_global_ubo_type.definition != 0)
 		{
+			if (_optimize_uniform_layout)
+				optimize_uniform_layout();
+			else
+				_module.total_uniform_size = (_global_ubo_offset + 15) & ~15;
+
 			define_struct({}, _global_ubo_type);
 
 			define_variable(_global_ubo_variable, {}, { type::t_struct, 0, 0, type::q_uniform, 0, _global_ubo_type.definition }, "$Globals", spv::StorageClassUniform);
@@ -597,9 +692,13 @@ private:
 	}
 	id   define_uniform(const location &, uniform_info &info) override
 	{
-		if (_uniforms_to_spec_constants && info.type.is_scalar() && info.has_initializer_value)
+		if (_uniforms_to_spec_constants && !info.type.is_array() && info.has_initializer_value)
 		{
-			const id res = emit_constant(info.type, info.initializer_value, true);
+			// Every component gets its own specialization constant ID, so store the first one in the offset field
+			info.size = 4 * info.type.components();
+			info.offset = _current_spec_constant_id;
+
+			const id res = emit_spec_constant(info.type, info.initializer_value);
 
 			add_name(res, info.name.c_str());
 
@@ -645,7 +744,11 @@ private:
 
 			const uint32_t member_index = static_cast<uint32_t>(member_list.size() - 1);
 
-			add_member_decoration(_global_ubo_type.definition, member_index, spv::DecorationOffset, { info.offset });
+			// The offset is only final after the layout was optimized, in which case the decoration is added during 'write_result'
+			if (_optimize_uniform_layout)
+				_global_ubo_member_indices.push_back(0);
+			else
+				add_member_decoration(_global_ubo_type.definition, member_index, spv::DecorationOffset, { info.offset });
 
 			return 0xF0000000 | member_index;
 		}
@@ -989,6 +1092,13 @@ private:
 	{
 		if (exp.is_constant) // Constant expressions do not have a complex access chain
 			return emit_constant(exp.type, exp.constant);
+		else if (!exp.is_lvalue && exp.chain.empty()) // Can refer to values without access chain directly
+			return exp.base;
+
+		// Reuse the result of an identical load earlier in the same block
+		value_key key = make_load_key(exp);
+		if (const id cached = find_cached_value(key))
+			return cached;
 
 		size_t i = 0;
 		spv::Id result = exp.base;
@@ -1021,7 +1131,7 @@ private:
 
 				result = add_instruction(spv::OpAccessChain, convert_type(base_type, true, spv::StorageClassUniform))
 					.add(_global_ubo_variable)
-					.add(emit_constant(member_index))
+					.add(emit_global_ubo_member_index(member_index))
 					.result;
 
 				storage = spv::StorageClassUniform;
@@ -1228,6 +1338,8 @@ private:
 			}
 		}
 
+		cache_value(std::move(key), result);
+
 		return result;
 	}
 	void emit_store(const expression &exp, id value) override
@@ -1235,6 +1347,8 @@ private:
 		assert(value != 0);
 		assert(exp.is_lvalue && !exp.is_constant);
 
+		invalidate_cached_values(exp.base);
+
 		add_location(exp.location, *_current_block_data);
 
 		size_t i = 0;
@@ -1342,13 +1456,13 @@ private:
 
 	id   emit_constant(uint32_t value)
 	{
-		constant data;
+		constant data = {};
 		data.as_uint[0] = value;
 		return emit_constant({ type::t_uint, 1, 1 }, data, false);
 	}
 	id   emit_constant(const type &type, uint32_t value)
 	{
-		constant data;
+		constant data = {};
 		for (unsigned int i = 0; i < type.components(); ++i)
 			if (type.is_integral())
 				data.as_uint[i] = value;
@@ -1480,6 +1594,58 @@ private:
 
 		return result;
 	}
+	id   emit_spec_constant(const type &type, const constant &data)
+	{
+		assert(!type.is_array() && !type.is_struct());
+
+		if (type.is_matrix() || type.is_vector())
+		{
+			// Build composite out of individually specializable scalar components, so that every value can be changed without recompiling
+			spv::Id elements[4] = {};
+
+			for (unsigned int i = 0; i < type.rows; ++i)
+			{
+				auto elem_type = type;
+				constant elem_data = {};
+
+				if (type.is_matrix())
+				{
+					elem_type.rows = type.cols;
+					elem_type.cols = 1;
+					for (unsigned int k = 0; k < type.cols; ++k)
+						elem_data.as_uint[k] = data.as_uint[i * type.cols + k];
+				}
+				else
+				{
+					elem_type.rows = 1;
+					elem_data.as_uint[0] = data.as_uint[i];
+				}
+
+				elements[i] = emit_spec_constant(elem_type, elem_data);
+			}
+
+			if (type.is_matrix() && type.rows == 1)
+				return elements[0];
+
+			spirv_instruction &node = add_instruction(spv::OpSpecConstantComposite, convert_type(type), _types_and_constants);
+
+			for (unsigned int i = 0; i < type.rows; ++i)
+				node.add(elements[i]);
+
+			return node.result;
+		}
+
+		spv::Id result;
+		if (type.is_boolean())
+			result = add_instruction(data.as_uint[0] ? spv::OpSpecConstantTrue : spv::OpSpecConstantFalse, convert_type(type), _types_and_constants).result;
+		else
+			result = add_instruction(spv::OpSpecConstant, convert_type(type), _types_and_constants).add(data.as_uint[0]).result;
+
+		// https://www.khronos.org/registry/spir-v/specs/unified1/SPIRV.html#Decoration
+		add_decoration(result, spv::DecorationSpecId, { _current_spec_constant_id++ });
+
+		return result;
+	}
 
 	id   emit_unary_op(const location &loc, tokenid op, const type &type, id val) override
 	{
@@ -1621,6 +1787,9 @@ private:
 		for (const auto &arg : args)
 			assert(arg.chain.empty() && arg.base != 0);
 
+		// The called function may modify global variables, so cannot reuse any results loaded before
+		invalidate_cached_values();
+
 		add_location(loc, *_current_block_data);
 
 		// https://www.khronos.org/registry/spir-v/specs/unified1/SPIRV.html#OpFunctionCall
@@ -1636,6 +1805,15 @@ private:
 		for (const auto &arg : args)
 			assert(arg.chain.empty() && arg.base != 0);
 
+		// Intrinsics without output parameters have no side effects, so can reuse the result of an identical call earlier in the same block
+		const bool is_pure = std::none_of(args.begin(), args.end(), [](const expression &arg) { return arg.is_lvalue; });
+
+		value_key key = make_intrinsic_key(intrinsic, res_type, args);
+		if (!is_pure)
+			invalidate_cached_values();
+		else if (const id cached = find_cached_value(key))
+			return cached;
+
 		add_location(loc, *_current_block_data);
 
 		enum
@@ -1644,13 +1822,21 @@ private:
 #include "effect_symbol_table_intrinsics.inl"
 		};
 
-		switch (intrinsic)
-		{
+		// The intrinsic implementations return their result directly, so wrap them to be able to cache it
+		const id res = [&]() -> id {
+			switch (intrinsic)
+			{
 #define IMPLEMENT_INTRINSIC_SPIRV(name, i, code) case name##i: code
 #include "effect_symbol_table_intrinsics.inl"
-		default:
-			return 0;
-		}
+			default:
+				return 0;
+			}
+		}();
+
+		if (is_pure && res != 0)
+			cache_value(std::move(key), res);
+
+		return res;
 	}
 	id   emit_construct(const location &loc, const type &type, const std::vector<expression> &args) override
 	{
@@ -1926,7 +2112,7 @@ private:
 	}
 };
 
-codegen *reshadefx::create_codegen_spirv(bool debug_info, bool uniforms_to_spec_constants)
+codegen *reshadefx::create_codegen_spirv(bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout)
 {
-	return new codegen_spirv(debug_info, uniforms_to_spec_constants);
+	return new codegen_spirv(debug_info, uniforms_to_spec_constants, optimize_uniform_layout);
 }
@@ -6,6 +6,8 @@
 #include "effect_expression.hpp"
 #include "effect_lexer.hpp"
 #include "effect_codegen.hpp"
+#include <cmath>
+#include <cstring>
 #include <assert.h>
 
 reshadefx::type reshadefx::type::merge(const type &lhs, const type &rhs)
@@ -8,9 +8,12 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <cfloat>
 
 namespace reshadefx
 {
+	enum class tokenid;
+
 	/// <summary>
 	/// Structure which keeps track of a code location
 	/// </summary>
@@ -144,12 +147,12 @@ namespace reshadefx
 			signed char swizzle[4];
 		};
 
-		type type = {};
+		reshadefx::type type = {};
 		uint32_t base = 0;
-		constant constant = {};
+		reshadefx::constant constant = {};
 		bool is_lvalue = false;
 		bool is_constant = false;
-		location location;
+		reshadefx::location location;
 		std::vector<operation> chain;
 
 		/// <summary>
@@ -211,13 +214,13 @@ namespace reshadefx
 		/// Apply an unary operation to this constant expression.
 		/// </summary>
 		/// <param name="op">The unary operator to apply.</param>
-		bool evaluate_constant_expression(enum class tokenid op);
+		bool evaluate_constant_expression(tokenid op);
 		/// <summary>
 		/// Apply a binary operation to this constant expression.
 		/// </summary>
 		/// <param name="op">The binary operator to apply.</param>
 		/// <param name="rhs">The constant to use as right-hand side of the binary operation.</param>
-		bool evaluate_constant_expression(enum class tokenid op, const reshadefx::constant &rhs);
+		bool evaluate_constant_expression(tokenid op, const reshadefx::constant &rhs);
 	};
 
 
@@ -231,19 +234,19 @@ namespace reshadefx
 
 	struct struct_member_info
 	{
-		type type;
+		reshadefx::type type;
 		std::string name;
 		std::string semantic;
-		location location;
+		reshadefx::location location;
 		uint32_t definition = 0;
 	};
 
 	struct uniform_info
 	{
 		std::string name;
-		type type;
+		reshadefx::type type;
 		uint32_t size = 0;
-		uint32_t offset = 0;
+		uint32_t offset = 0; // Byte offset in the uniform buffer, or the first specialization constant ID for specialization constants
 		std::unordered_map<std::string, std::pair<reshadefx::type, constant>> annotations;
 		bool has_initializer_value = false;
 		constant initializer_value;
@@ -382,5 +385,8 @@ namespace reshadefx
 		std::vector<std::pair<std::string, bool>> entry_points;
 		uint32_t num_sampler_bindings = 0;
 		uint32_t num_texture_bindings = 0;
+		uint32_t total_uniform_size = 0;
+		uint32_t uniform_bytes_saved = 0; // Padding removed by the uniform layout optimization compared to declaration order
+		uint32_t per_frame_uniform_offset = 0; // Start of the separate buffer with the variables updated every frame, or zero if all variables are in a single buffer
 	};
 }
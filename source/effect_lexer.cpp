@@ -399,7 +399,7 @@ reshadefx::token reshadefx::lexer::lex()
 next_token:
 	// Reset token data
 	tok.location = _cur_location;
-	tok.offset = _cur - _input.data();
+	tok.offset = _cur - _input->data();
 	tok.length = 1;
 	tok.literal_as_double = 0;
 
@@ -414,7 +414,7 @@ next_token:
 		if (_ignore_whitespace || is_at_line_begin || *_cur == '\n')
 			goto next_token;
 		tok.id = tokenid::space;
-		tok.length = _cur - _input.data() - tok.offset;
+		tok.length = _cur - _input->data() - tok.offset;
 		return tok;
 	case '\n':
 		_cur++;
@@ -528,7 +528,7 @@ next_token:
 			if (_ignore_comments)
 				goto next_token;
 			tok.id = tokenid::single_line_comment;
-			tok.length = _cur - _input.data() - tok.offset;
+			tok.length = _cur - _input->data() - tok.offset;
 			return tok;
 		}
 		else if (_cur[1] == '*')
@@ -550,7 +550,7 @@ next_token:
 			if (_ignore_comments)
 				goto next_token;
 			tok.id = tokenid::multi_line_comment;
-			tok.length = _cur - _input.data() - tok.offset;
+			tok.length = _cur - _input->data() - tok.offset;
 			return tok;
 		}
 		else if (_cur[1] == '=')
@@ -681,7 +681,7 @@ void reshadefx::lexer::parse_identifier(token &tok) const
 	do end++; while (type_lookup[*end] == IDENT || type_lookup[*end] == DIGIT);
 
 	tok.id = tokenid::identifier;
-	tok.offset = begin - _input.data();
+	tok.offset = begin - _input->data();
 	tok.length = end - begin;
 	tok.literal_as_string.assign(begin, end);
 
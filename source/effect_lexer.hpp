@@ -6,6 +6,7 @@
 #pragma once
 
 #include "effect_expression.hpp"
+#include <memory>
 
 namespace reshadefx
 {
@@ -176,7 +177,7 @@ namespace reshadefx
 	struct token
 	{
 		tokenid id;
-		location location;
+		reshadefx::location location;
 		size_t offset, length;
 		union
 		{
@@ -206,7 +207,7 @@ namespace reshadefx
 			bool ignore_line_directives = false,
 			bool ignore_keywords = false,
 			bool escape_string_literals = true) :
-			_input(std::move(input)),
+			_input(std::make_shared<const std::string>(std::move(input))),
 			_ignore_comments(ignore_comments),
 			_ignore_whitespace(ignore_whitespace),
 			_ignore_pp_directives(ignore_pp_directives),
@@ -214,17 +215,18 @@ namespace reshadefx
 			_ignore_keywords(ignore_keywords),
 			_escape_string_literals(escape_string_literals)
 		{
-			_cur = _input.data();
-			_end = _cur + _input.size();
+			_cur = _input->data();
+			_end = _cur + _input->size();
 		}
 
 		lexer(const lexer &lexer) { operator=(lexer); }
 		lexer &operator=(const lexer &lexer)
 		{
+			// The input string is immutable and shared between copies, so that backing up the lexer state is cheap
 			_input = lexer._input;
 			_cur_location = lexer._cur_location;
-			_cur = _input.data() + (lexer._cur - lexer._input.data());
-			_end = _input.data() + _input.size();
+			_cur = lexer._cur;
+			_end = lexer._end;
 			_ignore_comments = lexer._ignore_comments;
 			_ignore_whitespace = lexer._ignore_whitespace;
 			_ignore_pp_directives = lexer._ignore_pp_directives;
@@ -239,7 +241,7 @@ namespace reshadefx
 		/// Get the input string this lexical analyzer works on.
 		/// </summary>
 		/// <returns>A constant reference to the input string.</returns>
-		const std::string &input_string() const { return _input; }
+		const std::string &input_string() const { return *_input; }
 
 		/// <summary>
 		/// Perform lexical analysis on the input string and return the next token in sequence.
@@ -268,7 +270,7 @@ namespace reshadefx
 		void parse_string_literal(token &tok, bool escape) const;
 		void parse_numeric_literal(token &tok) const;
 
-		std::string _input;
+		std::shared_ptr<const std::string> _input;
 		location _cur_location;
 		const std::string::value_type *_cur, *_end;
 		bool _ignore_comments;
@@ -0,0 +1,501 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_module_cache.hpp"
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+using namespace reshadefx;
+
+static const uint32_t s_cache_magic = 0x43584652; // "RFXC"
+// Increase this whenever the layout of the serialized data changes
+static const uint32_t s_cache_format_version = 1;
+
+/// <summary>
+/// Helper which appends values to a byte buffer in little-endian order.
+/// </summary>
+struct cache_writer
+{
+	std::vector<uint8_t> &data;
+
+	void write(uint32_t value)
+	{
+		for (unsigned int i = 0; i < 4; ++i)
+			data.push_back(static_cast<uint8_t>(value >> (i * 8)));
+	}
+	void write(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		write(bits);
+	}
+	void write(uint64_t value)
+	{
+		write(static_cast<uint32_t>(value));
+		write(static_cast<uint32_t>(value >> 32));
+	}
+	void write(const std::string &value)
+	{
+		write(static_cast<uint32_t>(value.size()));
+		data.insert(data.end(), value.begin(), value.end());
+	}
+	void write(const type &value)
+	{
+		write(static_cast<uint32_t>(value.base));
+		write(static_cast<uint32_t>(value.rows));
+		write(static_cast<uint32_t>(value.cols));
+		write(static_cast<uint32_t>(value.qualifiers));
+		write(static_cast<uint32_t>(value.array_length));
+		write(static_cast<uint32_t>(value.definition));
+	}
+	void write(const constant &value)
+	{
+		for (unsigned int i = 0; i < 16; ++i)
+			write(value.as_uint[i]);
+		write(value.string_data);
+		write(static_cast<uint32_t>(value.array_data.size()));
+		for (const constant &element : value.array_data)
+			write(element);
+	}
+	void write(const std::unordered_map<std::string, std::pair<type, constant>> &annotations)
+	{
+		// Sort by name, so that the output does not depend on the hash map iteration order
+		std::vector<const std::pair<const std::string, std::pair<type, constant>> *> sorted;
+		for (const auto &annotation : annotations)
+			sorted.push_back(&annotation);
+		std::sort(sorted.begin(), sorted.end(), [](auto lhs, auto rhs) { return lhs->first < rhs->first; });
+
+		write(static_cast<uint32_t>(sorted.size()));
+		for (const auto annotation : sorted)
+		{
+			write(annotation->first);
+			write(annotation->second.first);
+			write(annotation->second.second);
+		}
+	}
+	void write(const uniform_info &value)
+	{
+		write(value.name);
+		write(value.type);
+		write(value.size);
+		write(value.offset);
+		write(value.annotations);
+		write(static_cast<uint32_t>(value.has_initializer_value));
+		write(value.initializer_value);
+	}
+	void write(const texture_info &value)
+	{
+		write(value.id);
+		write(value.binding);
+		write(value.semantic);
+		write(value.unique_name);
+		write(value.annotations);
+		write(value.width);
+		write(value.height);
+		write(value.levels);
+		write(static_cast<uint32_t>(value.format));
+	}
+	void write(const sampler_info &value)
+	{
+		write(value.id);
+		write(value.binding);
+		write(value.texture_binding);
+		write(value.unique_name);
+		write(value.texture_name);
+		write(value.annotations);
+		write(static_cast<uint32_t>(value.filter));
+		write(static_cast<uint32_t>(value.address_u));
+		write(static_cast<uint32_t>(value.address_v));
+		write(static_cast<uint32_t>(value.address_w));
+		write(value.min_lod);
+		write(value.max_lod);
+		write(value.lod_bias);
+		write(static_cast<uint32_t>(value.srgb));
+	}
+	void write(const pass_info &value)
+	{
+		for (const std::string &name : value.render_target_names)
+			write(name);
+		write(value.vs_entry_point);
+		write(value.ps_entry_point);
+		write(static_cast<uint32_t>(value.clear_render_targets));
+		write(static_cast<uint32_t>(value.srgb_write_enable));
+		write(static_cast<uint32_t>(value.blend_enable));
+		write(static_cast<uint32_t>(value.stencil_enable));
+		write(static_cast<uint32_t>(value.color_write_mask));
+		write(static_cast<uint32_t>(value.stencil_read_mask));
+		write(static_cast<uint32_t>(value.stencil_write_mask));
+		write(value.blend_op);
+		write(value.blend_op_alpha);
+		write(value.src_blend);
+		write(value.dest_blend);
+		write(value.src_blend_alpha);
+		write(value.dest_blend_alpha);
+		write(value.stencil_comparison_func);
+		write(value.stencil_reference_value);
+		write(value.stencil_op_pass);
+		write(value.stencil_op_fail);
+		write(value.stencil_op_depth_fail);
+		write(value.viewport_width);
+		write(value.viewport_height);
+	}
+	void write(const technique_info &value)
+	{
+		write(value.name);
+		write(static_cast<uint32_t>(value.passes.size()));
+		for (const pass_info &pass : value.passes)
+			write(pass);
+		write(value.annotations);
+	}
+	template <typename T>
+	void write(const std::vector<T> &values)
+	{
+		write(static_cast<uint32_t>(values.size()));
+		for (const T &value : values)
+			write(value);
+	}
+};
+
+/// <summary>
+/// Helper which reads values written by <see cref="cache_writer"/> and keeps track of whether the data ended prematurely.
+/// </summary>
+struct cache_reader
+{
+	const std::vector<uint8_t> &data;
+	size_t offset = 0;
+	bool failed = false;
+
+	void read(uint32_t &value)
+	{
+		value = 0;
+		if (offset + 4 > data.size())
+		{
+			failed = true;
+			return;
+		}
+
+		for (unsigned int i = 0; i < 4; ++i)
+			value |= static_cast<uint32_t>(data[offset++]) << (i * 8);
+	}
+	void read(float &value)
+	{
+		uint32_t bits = 0;
+		read(bits);
+		std::memcpy(&value, &bits, sizeof(value));
+	}
+	void read(uint64_t &value)
+	{
+		uint32_t low = 0, high = 0;
+		read(low);
+		read(high);
+		value = low | (static_cast<uint64_t>(high) << 32);
+	}
+	void read(std::string &value)
+	{
+		uint32_t size = 0;
+		read(size);
+		if (size > data.size() - offset)
+		{
+			failed = true;
+			return;
+		}
+
+		value.assign(reinterpret_cast<const char *>(data.data() + offset), size);
+		offset += size;
+	}
+	void read(uint8_t &value)
+	{
+		uint32_t temp = 0;
+		read(temp);
+		value = static_cast<uint8_t>(temp);
+	}
+	template <typename T>
+	void read_enum(T &value)
+	{
+		uint32_t temp = 0;
+		read(temp);
+		value = static_cast<T>(temp);
+	}
+	void read(type &value)
+	{
+		read_enum(value.base);
+		read(value.rows);
+		read(value.cols);
+		read(value.qualifiers);
+		read_enum(value.array_length);
+		read(value.definition);
+	}
+	void read(constant &value)
+	{
+		for (unsigned int i = 0; i < 16; ++i)
+			read(value.as_uint[i]);
+		read(value.string_data);
+		read(value.array_data);
+	}
+	void read(std::unordered_map<std::string, std::pair<type, constant>> &annotations)
+	{
+		uint32_t count = 0;
+		read(count);
+
+		for (uint32_t i = 0; i < count && !failed; ++i)
+		{
+			std::string name;
+			read(name);
+			auto &annotation = annotations[name];
+			read(annotation.first);
+			read(annotation.second);
+		}
+	}
+	void read(uniform_info &value)
+	{
+		read(value.name);
+		read(value.type);
+		read(value.size);
+		read(value.offset);
+		read(value.annotations);
+		uint32_t has_initializer_value = 0;
+		read(has_initializer_value);
+		value.has_initializer_value = has_initializer_value != 0;
+		read(value.initializer_value);
+	}
+	void read(texture_info &value)
+	{
+		read(value.id);
+		read(value.binding);
+		read(value.semantic);
+		read(value.unique_name);
+		read(value.annotations);
+		read(value.width);
+		read(value.height);
+		read(value.levels);
+		read_enum(value.format);
+	}
+	void read(sampler_info &value)
+	{
+		read(value.id);
+		read(value.binding);
+		read(value.texture_binding);
+		read(value.unique_name);
+		read(value.texture_name);
+		read(value.annotations);
+		read_enum(value.filter);
+		read_enum(value.address_u);
+		read_enum(value.address_v);
+		read_enum(value.address_w);
+		read(value.min_lod);
+		read(value.max_lod);
+		read(value.lod_bias);
+		read(value.srgb);
+	}
+	void read(pass_info &value)
+	{
+		for (std::string &name : value.render_target_names)
+			read(name);
+		read(value.vs_entry_point);
+		read(value.ps_entry_point);
+		read(value.clear_render_targets);
+		read(value.srgb_write_enable);
+		read(value.blend_enable);
+		read(value.stencil_enable);
+		read(value.color_write_mask);
+		read(value.stencil_read_mask);
+		read(value.stencil_write_mask);
+		read(value.blend_op);
+		read(value.blend_op_alpha);
+		read(value.src_blend);
+		read(value.dest_blend);
+		read(value.src_blend_alpha);
+		read(value.dest_blend_alpha);
+		read(value.stencil_comparison_func);
+		read(value.stencil_reference_value);
+		read(value.stencil_op_pass);
+		read(value.stencil_op_fail);
+		read(value.stencil_op_depth_fail);
+		read(value.viewport_width);
+		read(value.viewport_height);
+	}
+	void read(technique_info &value)
+	{
+		read(value.name);
+		read(value.passes);
+		read(value.annotations);
+	}
+	template <typename T>
+	void read(std::vector<T> &values)
+	{
+		uint32_t count = 0;
+		read(count);
+
+		// Every element takes at least four bytes, which protects against huge allocations from corrupted counts
+		if (count > (data.size() - offset) / 4)
+		{
+			failed = true;
+			return;
+		}
+
+		values.resize(count);
+		for (uint32_t i = 0; i < count && !failed; ++i)
+			read(values[i]);
+	}
+};
+
+std::string reshadefx::make_codegen_key(const char *language, unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout, bool split_uniform_buffers)
+{
+	std::string key = language;
+	if (shader_model != 0)
+		key += std::to_string(shader_model);
+	if (debug_info)
+		key += " debug_info";
+	if (uniforms_to_spec_constants)
+		key += " uniforms_to_spec_constants";
+	if (optimize_uniform_layout)
+		key += " optimize_uniform_layout";
+	if (split_uniform_buffers)
+		key += " split_uniform_buffers";
+	return key;
+}
+
+bool reshadefx::hash_file(const std::filesystem::path &path, uint64_t &hash)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	// 64-bit FNV-1a, which is fast and good enough to detect changes
+	hash = 14695981039346656037ull;
+
+	char buffer[4096];
+	while (file.read(buffer, sizeof(buffer)), file.gcount() > 0)
+		for (std::streamsize i = 0; i < file.gcount(); ++i)
+			hash = (hash ^ static_cast<uint8_t>(buffer[i])) * 1099511628211ull;
+
+	return true;
+}
+
+void reshadefx::write_module_cache(const module &module, const module_cache_info &info, std::vector<uint8_t> &data)
+{
+	cache_writer writer { data };
+
+	writer.write(s_cache_magic);
+	writer.write(s_cache_format_version);
+
+	writer.write(info.compiler_version);
+	writer.write(info.codegen_key);
+	writer.write(static_cast<uint32_t>(info.macros.size()));
+	for (const auto &macro : info.macros)
+	{
+		writer.write(macro.first);
+		writer.write(static_cast<uint32_t>(macro.second.first));
+		writer.write(macro.second.second);
+	}
+	writer.write(static_cast<uint32_t>(info.files.size()));
+	for (const auto &file : info.files)
+	{
+		writer.write(file.first);
+		writer.write(file.second);
+	}
+
+	writer.write(module.hlsl);
+	writer.write(module.spirv);
+	writer.write(module.textures);
+	writer.write(module.samplers);
+	writer.write(module.uniforms);
+	writer.write(module.spec_constants);
+	writer.write(module.techniques);
+	writer.write(static_cast<uint32_t>(module.entry_points.size()));
+	for (const auto &entry_point : module.entry_points)
+	{
+		writer.write(entry_point.first);
+		writer.write(static_cast<uint32_t>(entry_point.second));
+	}
+	writer.write(module.num_sampler_bindings);
+	writer.write(module.num_texture_bindings);
+	writer.write(module.total_uniform_size);
+	writer.write(module.uniform_bytes_saved);
+	writer.write(module.per_frame_uniform_offset);
+}
+
+static bool read_info(cache_reader &reader, module_cache_info &info)
+{
+	uint32_t magic = 0, format_version = 0;
+	reader.read(magic);
+	reader.read(format_version);
+	if (reader.failed || magic != s_cache_magic || format_version != s_cache_format_version)
+		return false;
+
+	reader.read(info.compiler_version);
+	reader.read(info.codegen_key);
+
+	uint32_t count = 0;
+	reader.read(count);
+	info.macros.clear();
+	for (uint32_t i = 0; i < count && !reader.failed; ++i)
+	{
+		std::pair<std::string, std::pair<bool, std::string>> macro;
+		reader.read(macro.first);
+		uint32_t defined = 0;
+		reader.read(defined);
+		macro.second.first = defined != 0;
+		reader.read(macro.second.second);
+		info.macros.push_back(std::move(macro));
+	}
+
+	reader.read(count);
+	info.files.clear();
+	for (uint32_t i = 0; i < count && !reader.failed; ++i)
+	{
+		std::pair<std::string, uint64_t> file;
+		reader.read(file.first);
+		reader.read(file.second);
+		info.files.push_back(std::move(file));
+	}
+
+	return !reader.failed;
+}
+
+bool reshadefx::read_module_cache_info(const std::vector<uint8_t> &data, module_cache_info &info)
+{
+	cache_reader reader { data };
+
+	return read_info(reader, info);
+}
+
+bool reshadefx::read_module_cache(const std::vector<uint8_t> &data, module_cache_info &info, module &module)
+{
+	cache_reader reader { data };
+
+	if (!read_info(reader, info))
+		return false;
+
+	reader.read(module.hlsl);
+	reader.read(module.spirv);
+	reader.read(module.textures);
+	reader.read(module.samplers);
+	reader.read(module.uniforms);
+	reader.read(module.spec_constants);
+	reader.read(module.techniques);
+
+	uint32_t count = 0;
+	reader.read(count);
+	module.entry_points.clear();
+	for (uint32_t i = 0; i < count && !reader.failed; ++i)
+	{
+		std::pair<std::string, bool> entry_point;
+		reader.read(entry_point.first);
+		uint32_t is_ps = 0;
+		reader.read(is_ps);
+		entry_point.second = is_ps != 0;
+		module.entry_points.push_back(std::move(entry_point));
+	}
+
+	reader.read(module.num_sampler_bindings);
+	reader.read(module.num_texture_bindings);
+	reader.read(module.total_uniform_size);
+	reader.read(module.uniform_bytes_saved);
+	reader.read(module.per_frame_uniform_offset);
+
+	return !reader.failed && reader.offset == data.size();
+}
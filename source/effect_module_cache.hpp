@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "effect_expression.hpp"
+#include <filesystem>
+
+namespace reshadefx
+{
+	/// <summary>
+	/// Information stored alongside a compiled module, which is used to decide whether the module can be used in place of compiling the effect again.
+	/// </summary>
+	struct module_cache_info
+	{
+		// Version of the compiler the module was generated with
+		uint32_t compiler_version = 0;
+		// Code generation back-end and its options, as returned by <see cref="make_codegen_key"/>
+		std::string codegen_key;
+		// Macros referenced by the effect that were defined outside of it, with their replacement list (or an undefined flag)
+		std::vector<std::pair<std::string, std::pair<bool, std::string>>> macros;
+		// The effect file and all files it included, relative to the directory of the effect file, with a hash of their contents
+		std::vector<std::pair<std::string, uint64_t>> files;
+	};
+
+	/// <summary>
+	/// Build a string describing a code generation back-end and its options, so that modules generated with different options can be told apart.
+	/// </summary>
+	/// <param name="language">The target language, "hlsl", "glsl" or "spirv".</param>
+	std::string make_codegen_key(const char *language, unsigned int shader_model, bool debug_info, bool uniforms_to_spec_constants, bool optimize_uniform_layout, bool split_uniform_buffers);
+
+	/// <summary>
+	/// Calculate a hash of the contents of a file, to detect whether it changed since a module was generated.
+	/// </summary>
+	/// <param name="path">The path to the file.</param>
+	/// <param name="hash">Receives the hash of the file contents.</param>
+	/// <returns><c>true</c> if the file could be read, <c>false</c> otherwise.</returns>
+	bool hash_file(const std::filesystem::path &path, uint64_t &hash);
+
+	/// <summary>
+	/// Serialize a compiled module (generated code, uniforms, textures, samplers, techniques and entry points) into a binary cache format.
+	/// </summary>
+	/// <param name="module">The module to serialize.</param>
+	/// <param name="info">The information to store alongside the module.</param>
+	/// <param name="data">Receives the serialized data.</param>
+	void write_module_cache(const module &module, const module_cache_info &info, std::vector<uint8_t> &data);
+	/// <summary>
+	/// Deserialize the information stored alongside a module, without reading the module itself.
+	/// </summary>
+	/// <returns><c>true</c> if the data is a valid module cache of the current format version, <c>false</c> otherwise.</returns>
+	bool read_module_cache_info(const std::vector<uint8_t> &data, module_cache_info &info);
+	/// <summary>
+	/// Deserialize a module previously serialized with <see cref="write_module_cache"/>.
+	/// </summary>
+	/// <param name="data">The serialized data.</param>
+	/// <param name="info">Receives the information stored alongside the module.</param>
+	/// <param name="module">Receives the deserialized module.</param>
+	/// <returns><c>true</c> if the data is a valid module cache of the current format version, <c>false</c> otherwise.</returns>
+	bool read_module_cache(const std::vector<uint8_t> &data, module_cache_info &info, module &module);
+}
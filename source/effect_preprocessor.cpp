@@ -5,6 +5,7 @@
 
 #include "effect_preprocessor.hpp"
 #include <fstream>
+#include <algorithm>
 #include <assert.h>
 
 enum macro_replacement
@@ -41,7 +42,9 @@ bool reshadefx::preprocessor::add_macro_definition(const std::string &name, std:
 bool reshadefx::preprocessor::append_file(const std::filesystem::path &path)
 {
 	std::ifstream file(path);
+#ifdef _WIN32
 	file.imbue(std::locale("en-us.UTF-8"));
+#endif
 
 	if (!file.is_open())
 		return false;
@@ -76,6 +79,16 @@ bool reshadefx::preprocessor::append_string(const std::string &source_code)
 	return _success;
 }
 
+std::vector<std::filesystem::path> reshadefx::preprocessor::included_files() const
+{
+	// Every included file is read into the cache exactly once, so it doubles as the list of dependencies
+	std::vector<std::filesystem::path> files;
+	files.reserve(_filecache.size());
+	for (const auto &file : _filecache)
+		files.push_back(std::filesystem::u8path(file.first));
+	return files;
+}
+
 void reshadefx::preprocessor::error(const location &location, const std::string &message)
 {
 	_errors += location.source + '(' + std::to_string(location.line) + ", " + std::to_string(location.column) + ')' + ": preprocessor error: " + message + '\n';
@@ -353,6 +366,8 @@ void reshadefx::preprocessor::parse_def()
 
 	create_macro_replacement_list(m);
 
+	_source_macros.insert(macro_name);
+
 	if (!add_macro_definition(macro_name, m))
 		return error(location, "redefinition of '" + macro_name + "'");
 }
@@ -386,7 +401,7 @@ void reshadefx::preprocessor::parse_ifdef()
 	if (!expect(tokenid::identifier))
 		return;
 
-	level.value = _macros.find(_token.literal_as_string) != _macros.end();
+	level.value = is_defined(_token.literal_as_string);
 	level.parent = current_if_stack().empty() ? nullptr : &current_if_stack().top();
 	level.skipping = (level.parent != nullptr && level.parent->skipping) || !level.value;
 
@@ -400,7 +415,7 @@ void reshadefx::preprocessor::parse_ifndef()
 	if (!expect(tokenid::identifier))
 		return;
 
-	level.value = _macros.find(_token.literal_as_string) == _macros.end();
+	level.value = !is_defined(_token.literal_as_string);
 	level.parent = current_if_stack().empty() ? nullptr : &current_if_stack().top();
 	level.skipping = (level.parent != nullptr && level.parent->skipping) || !level.value;
 
@@ -527,6 +542,16 @@ void reshadefx::preprocessor::parse_include()
 
 	auto it = _filecache.find(filepath.u8string());
 
+	if (it == _filecache.end() && _shared_filecache != nullptr)
+	{
+		const auto last_write_time = std::filesystem::last_write_time(filepath, ec);
+
+		const std::lock_guard<std::mutex> lock(_shared_filecache->mutex);
+
+		if (const auto shared_it = _shared_filecache->files.find(filepath.u8string()); shared_it != _shared_filecache->files.end() && shared_it->second.last_write_time == last_write_time)
+			it = _filecache.emplace(shared_it->first, shared_it->second.data).first;
+	}
+
 	if (it == _filecache.end())
 	{
 		std::ifstream file(filepath);
@@ -538,11 +563,21 @@ void reshadefx::preprocessor::parse_include()
 			return;
 		}
 
+		// Query the modification time before reading, so that a change while reading invalidates the cache entry again
+		const auto last_write_time = std::filesystem::last_write_time(filepath, ec);
+
 		std::string filedata(std::istreambuf_iterator<char>(file.rdbuf()), std::istreambuf_iterator<char>());
 		filedata.push_back('\n');
 
 		file.close();
 
+		if (_shared_filecache != nullptr)
+		{
+			const std::lock_guard<std::mutex> lock(_shared_filecache->mutex);
+
+			_shared_filecache->files[filepath.u8string()] = { filedata, last_write_time };
+		}
+
 		it = _filecache.emplace(filepath.u8string(), std::move(filedata)).first;
 	}
 
@@ -594,7 +629,7 @@ bool reshadefx::preprocessor::evaluate_expression()
 	// Run shunting-yard algorithm
 	while (!peek(tokenid::end_of_line))
 	{
-		if (stack_count >= _countof(stack) || rpn_count >= _countof(rpn))
+		if (stack_count >= std::size(stack) || rpn_count >= std::size(rpn))
 		{
 			error(_token.location, "expression evaluator ran out of stack space");
 			return false;
@@ -765,7 +800,7 @@ bool reshadefx::preprocessor::evaluate_expression()
 					if (!expect(tokenid::identifier))
 						return false;
 
-					const bool is_macro_defined = _macros.find(_token.literal_as_string) != _macros.end();
+					const bool is_macro_defined = is_defined(_token.literal_as_string);
 
 					if (has_parentheses && !expect(tokenid::parenthesis_close))
 						return false;
@@ -776,6 +811,9 @@ bool reshadefx::preprocessor::evaluate_expression()
 				}
 
 				// An identifier that cannot be replaced with a number becomes zero
+				// Undefined identifiers evaluate to zero, but defining them from outside would change the result
+				is_defined(_token.literal_as_string);
+
 				rpn[rpn_count].is_op = false;
 				rpn[rpn_count++].value = 0;
 				break;
@@ -896,6 +934,17 @@ bool reshadefx::preprocessor::evaluate_expression()
 
 	return stack[0] != 0;
 }
+bool reshadefx::preprocessor::is_defined(const std::string &name)
+{
+	const auto it = _macros.find(name);
+	const bool defined = it != _macros.end();
+
+	// Only the first reference matters, since the source code cannot change the definition of a macro before that
+	if (_source_macros.find(name) == _source_macros.end())
+		_used_macros.emplace(name, defined ? std::make_pair(true, it->second.replacement_list) : std::make_pair(false, std::string()));
+
+	return defined;
+}
 bool reshadefx::preprocessor::evaluate_identifier_as_macro()
 {
 	if (_recursion_count++ >= 256)
@@ -907,7 +956,15 @@ bool reshadefx::preprocessor::evaluate_identifier_as_macro()
 	const auto it = _macros.find(_token.literal_as_string);
 
 	if (it == _macros.end())
+	{
+		// Any identifier may become a macro when it is defined from outside the source code, which changes the output, so record it as used but not defined
+		if (_source_macros.find(_token.literal_as_string) == _source_macros.end())
+			_used_macros.emplace(_token.literal_as_string, std::make_pair(false, std::string()));
 		return false;
+	}
+
+	if (_source_macros.find(it->first) == _source_macros.end())
+		_used_macros.emplace(it->first, std::make_pair(true, it->second.replacement_list));
 
 	const auto &macro = it->second;
 	std::vector<std::string> arguments;
@@ -8,6 +8,8 @@
 #include <stack>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <mutex>
 #include <memory>
 #include <filesystem>
 #include "effect_lexer.hpp"
@@ -27,11 +29,33 @@ namespace reshadefx
 			std::vector<std::string> parameters;
 		};
 
+		/// <summary>
+		/// Cache of included file contents which can be shared between multiple preprocessor instances running on different threads.
+		/// Entries are only used as long as the modification time of the file on disk matches, so the cache can be kept alive across file changes.
+		/// </summary>
+		struct file_cache
+		{
+			struct file
+			{
+				std::string data;
+				std::filesystem::file_time_type last_write_time;
+			};
+
+			std::mutex mutex;
+			std::unordered_map<std::string, file> files;
+		};
+
 		/// <summary>
 		/// Add an include directory to the list of search paths used when resolving #include directives.
 		/// </summary>
 		/// <param name="path">The path to the directory to add.</param>
 		void add_include_path(const std::filesystem::path &path);
+		/// <summary>
+		/// Look up included files in the specified cache before reading them from disk, and add them to it after doing so.
+		/// This avoids reading common headers again for every effect when compiling many effects in a row.
+		/// </summary>
+		/// <param name="cache">The cache to share with other preprocessor instances.</param>
+		void set_shared_file_cache(std::shared_ptr<file_cache> cache) { _shared_filecache = std::move(cache); }
 
 		/// <summary>
 		/// Add a new macro definition. This is equal to appending '#define name macro' to this preprocessor instance.
@@ -72,17 +96,28 @@ namespace reshadefx
 		std::string &output() { return _output; }
 		const std::string &output() const { return _output; }
 
+		/// <summary>
+		/// Get the list of all files that were included by #include directives so far.
+		/// </summary>
+		std::vector<std::filesystem::path> included_files() const;
+		/// <summary>
+		/// Get all macros that were referenced so far and were not defined in the source code itself (e.g. those added with <see cref="add_macro_definition"/>), together with their replacement list.
+		/// Identifiers that were not defined as a macro when they were encountered (whether tested with "defined", "#ifdef" or "#ifndef", used in an "#if" expression or just appearing in the code) are included too, with the first value set to false.
+		/// The output only depends on these, so it can be reused as long as they have the same definitions.
+		/// </summary>
+		const std::unordered_map<std::string, std::pair<bool, std::string>> &used_macro_definitions() const { return _used_macros; }
+
 	private:
 		struct if_level
 		{
-			token token;
+			reshadefx::token token;
 			bool value, skipping;
 			if_level *parent;
 		};
 		struct input_level
 		{
 			std::string name;
-			std::unique_ptr<lexer> lexer;
+			std::unique_ptr<reshadefx::lexer> lexer;
 			token next_token;
 			std::stack<if_level> if_stack;
 			input_level *parent;
@@ -118,6 +153,7 @@ namespace reshadefx
 
 		bool evaluate_expression();
 		bool evaluate_identifier_as_macro();
+		bool is_defined(const std::string &name);
 
 		void expand_macro(const macro &macro, const std::vector<std::string> &arguments, std::string &out);
 		void create_macro_replacement_list(macro &macro);
@@ -129,7 +165,10 @@ namespace reshadefx
 		std::string _output, _errors, _current_token_raw_data;
 		int _recursion_count = 0;
 		std::unordered_map<std::string, macro> _macros;
+		std::unordered_map<std::string, std::pair<bool, std::string>> _used_macros;
+		std::unordered_set<std::string> _source_macros;
 		std::vector<std::filesystem::path> _include_paths;
 		std::unordered_map<std::string, std::string> _filecache;
+		std::shared_ptr<file_cache> _shared_filecache;
 	};
 }
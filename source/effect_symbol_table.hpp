@@ -38,8 +38,8 @@ namespace reshadefx
 	{
 		symbol_type op = symbol_type::invalid;
 		uint32_t id = 0;
-		type type = {};
-		constant constant = {};
+		reshadefx::type type = {};
+		reshadefx::constant constant = {};
 		const function_info *function = nullptr;
 	};
 
@@ -92,7 +92,7 @@ namespace reshadefx
 
 	private:
 		struct scoped_symbol : symbol {
-			scope scope; // Store scope with symbol data
+			reshadefx::scope scope; // Store scope with symbol data
 		};
 
 		scope _current_scope;
@@ -738,14 +738,14 @@ void reshade::runtime::draw_overlay_menu_home()
 			{
 				// Reset visibility state
 				for (technique &technique : _techniques)
-					technique.hidden = technique.annotation_as_int("hidden") != 0;
+					technique.hidden = technique.force_hidden;
 			}
 			else
 			{
 				const std::string filter = _effect_filter_buffer;
 
 				for (technique &technique : _techniques)
-					technique.hidden = technique.annotation_as_int("hidden") != 0 ||
+					technique.hidden = technique.force_hidden ||
 						std::search(technique.name.begin(), technique.name.end(), filter.begin(), filter.end(),
 							[](auto c1, auto c2) { return tolower(c1) == tolower(c2); }) == technique.name.end() && _loaded_effects[technique.effect_index].source_file.filename().u8string().find(filter) == std::string::npos;
 			}
@@ -764,7 +764,7 @@ void reshade::runtime::draw_overlay_menu_home()
 			strcpy(_effect_filter_buffer, "Search");
 			// Reset visibility state
 			for (technique &technique : _techniques)
-				technique.hidden = technique.annotation_as_int("hidden") != 0;
+				technique.hidden = technique.force_hidden;
 		}
 
 		ImGui::SameLine();
@@ -793,11 +793,8 @@ void reshade::runtime::draw_overlay_menu_home()
 					{
 						if (!k->enabled && k->toggle_key_data[0] == 0)
 						{
-							// Using static to avoid allocate std::string in loop
-							static const std::string ui_label("ui_label");
-
-							const auto &a = i->annotations.find(ui_label) == i->annotations.end() ? i->name : i->annotations[ui_label].second.string_data;
-							const auto &b = k->annotations.find(ui_label) == k->annotations.end() ? k->name : k->annotations[ui_label].second.string_data;
+							const std::string &a = i->ui_label.empty() ? i->name : i->ui_label;
+							const std::string &b = k->ui_label.empty() ? k->name : k->ui_label;
 
 							if (a.compare(b) > 0)
 							{
@@ -1527,6 +1524,8 @@ void reshade::runtime::draw_code_editor()
 		_reload_remaining_effects = 1;
 		unload_effect(_selected_effect);
 		load_effect(source_file, _selected_effect);
+		init_effect(_selected_effect);
+		build_special_uniform_updates();
 		assert(_reload_remaining_effects == 0);
 
 		parse_errors(_loaded_effects[_selected_effect].errors);
@@ -1743,7 +1742,7 @@ void reshade::runtime::draw_overlay_variable_editor()
 		uniform &variable = _uniforms[index];
 
 		// Skip hidden and special variables
-		if (variable.annotation_as_int("hidden") || variable.special != special_uniform::none)
+		if (variable.hidden || variable.special != special_uniform::none)
 			continue;
 
 		// Hide variables that are not currently used in any of the active effects
@@ -1812,7 +1811,7 @@ void reshade::runtime::draw_overlay_variable_editor()
 		if (!current_tree_is_open)
 			continue;
 
-		if (const std::string_view category = variable.annotation_as_string("ui_category");
+		if (const std::string_view category = variable.ui_category;
 			category != current_category)
 		{
 			current_category = category;
@@ -1837,9 +1836,9 @@ void reshade::runtime::draw_overlay_variable_editor()
 			continue;
 
 		bool modified = false;
-		std::string_view label = variable.annotation_as_string("ui_label");
+		std::string_view label = variable.ui_label;
 		if (label.empty()) label = variable.name;
-		const std::string_view ui_type = variable.annotation_as_string("ui_type");
+		const std::string_view ui_type = variable.ui_type;
 
 		ImGui::PushID(static_cast<int>(index));
 
@@ -1868,18 +1867,18 @@ void reshade::runtime::draw_overlay_variable_editor()
 			int data[4];
 			get_uniform_value(variable, data, 4);
 
-			const auto ui_min_val = variable.annotation_as_int("ui_min");
-			const auto ui_max_val = variable.annotation_as_int("ui_max");
-			const auto ui_stp_val = std::max(1, variable.annotation_as_int("ui_step"));
+			const auto ui_min_val = variable.ui_min_int;
+			const auto ui_max_val = variable.ui_max_int;
+			const auto ui_stp_val = std::max(1, variable.ui_step_int);
 
 			if (ui_type == "slider")
 				modified = imgui_slider_with_buttons(label.data(), variable.type.is_signed() ? ImGuiDataType_S32 : ImGuiDataType_U32, data, variable.type.rows, &ui_stp_val, &ui_min_val, &ui_max_val);
 			else if (ui_type == "drag")
 				modified = ImGui::DragScalarN(label.data(), variable.type.is_signed() ? ImGuiDataType_S32 : ImGuiDataType_U32, data, variable.type.rows, static_cast<float>(ui_stp_val), &ui_min_val, &ui_max_val);
 			else if (ui_type == "list")
-				modified = imgui_list_with_buttons(label.data(), variable.annotation_as_string("ui_items"), data[0]);
+				modified = imgui_list_with_buttons(label.data(), variable.ui_items, data[0]);
 			else if (ui_type == "combo") {
-				const std::string_view ui_items = variable.annotation_as_string("ui_items");
+				const std::string_view ui_items = variable.ui_items;
 				std::string items(ui_items.data(), ui_items.size());
 				// Make sure list is terminated with a zero in case user forgot so no invalid memory is read accidentally
 				if (ui_items.empty() || ui_items.back() != '\0')
@@ -1888,7 +1887,7 @@ void reshade::runtime::draw_overlay_variable_editor()
 				modified = ImGui::Combo(label.data(), data, items.c_str());
 			}
 			else if (ui_type == "radio") {
-				const std::string_view ui_items = variable.annotation_as_string("ui_items");
+				const std::string_view ui_items = variable.ui_items;
 				ImGui::BeginGroup();
 				for (size_t offset = 0, next, i = 0; (next = ui_items.find('\0', offset)) != std::string::npos; offset = next + 1, ++i)
 					modified |= ImGui::RadioButton(ui_items.data() + offset, data, static_cast<int>(i));
@@ -1904,9 +1903,9 @@ void reshade::runtime::draw_overlay_variable_editor()
 			float data[4];
 			get_uniform_value(variable, data, 4);
 
-			const auto ui_min_val = variable.annotation_as_float("ui_min");
-			const auto ui_max_val = variable.annotation_as_float("ui_max");
-			const auto ui_stp_val = std::max(0.001f, variable.annotation_as_float("ui_step"));
+			const auto ui_min_val = variable.ui_min_float;
+			const auto ui_max_val = variable.ui_max_float;
+			const auto ui_stp_val = std::max(0.001f, variable.ui_step_float);
 
 			if (ui_type == "slider")
 				modified = imgui_slider_with_buttons(label.data(), ImGuiDataType_Float, data, variable.type.rows, &ui_stp_val, &ui_min_val, &ui_max_val, "%.3f");
@@ -1927,7 +1926,7 @@ void reshade::runtime::draw_overlay_variable_editor()
 		}
 
 		// Display tooltip
-		if (const std::string_view tooltip = variable.annotation_as_string("ui_tooltip");
+		if (const std::string_view tooltip = variable.ui_tooltip;
 			!tooltip.empty() && ImGui::IsItemHovered())
 			ImGui::SetTooltip("%s", tooltip.data());
 
@@ -1997,7 +1996,7 @@ void reshade::runtime::draw_overlay_technique_editor()
 		// Gray out disabled techniques and mark techniques which failed to compile red
 		ImGui::PushStyleColor(ImGuiCol_Text, compile_success ? _imgui_context->Style.Colors[technique.enabled ? ImGuiCol_Text : ImGuiCol_TextDisabled] : COLOR_RED);
 
-		std::string_view ui_label = technique.annotation_as_string("ui_label");
+		std::string_view ui_label = technique.ui_label;
 		if (ui_label.empty() || !compile_success) ui_label = technique.name;
 		std::string label(ui_label.data(), ui_label.size());
 		label += " [" + _loaded_effects[technique.effect_index].source_file.filename().u8string() + ']' + (!compile_success ? " (failed to compile)" : "");
@@ -2022,7 +2021,7 @@ void reshade::runtime::draw_overlay_technique_editor()
 			hovered_technique_index = index;
 
 		// Display tooltip
-		if (const std::string_view tooltip = technique.annotation_as_string("ui_tooltip");
+		if (const std::string_view tooltip = technique.ui_tooltip;
 			!tooltip.empty() && ImGui::IsItemHovered())
 			ImGui::SetTooltip("%s", tooltip.data());
 
@@ -69,7 +69,34 @@ namespace reshade::opengl
 		std::vector<opengl_sampler_data> samplers;
 		ptrdiff_t uniform_storage_index = -1;
 		ptrdiff_t uniform_storage_offset = 0;
+		ptrdiff_t per_frame_uniform_storage_index = -1;
+		ptrdiff_t per_frame_uniform_storage_offset = 0;
 	};
+
+	static void flip_compressed_block(uint8_t *block, reshadefx::texture_format format, uint32_t rows)
+	{
+		// Color data uses one byte of two bit indices per row of pixels
+		uint8_t *const color_block = block + (format == reshadefx::texture_format::dxt1 ? 0 : 8);
+		std::reverse(color_block + 4, color_block + 4 + rows);
+
+		if (format == reshadefx::texture_format::dxt3)
+		{
+			// Explicit alpha uses two bytes of four bit values per row of pixels
+			uint16_t alpha_rows[4];
+			std::memcpy(alpha_rows, block, sizeof(alpha_rows));
+			std::reverse(alpha_rows, alpha_rows + rows);
+			std::memcpy(block, alpha_rows, sizeof(alpha_rows));
+		}
+		else if (format == reshadefx::texture_format::dxt5)
+		{
+			// Interpolated alpha uses twelve bits of three bit indices per row of pixels, stored after the two alpha endpoints
+			uint64_t indices = 0, flipped_indices = 0;
+			std::memcpy(&indices, block + 2, 6);
+			for (uint32_t y = 0; y < 4; ++y)
+				flipped_indices |= ((indices >> (12 * (y < rows ? rows - 1 - y : y))) & 0xFFF) << (12 * y);
+			std::memcpy(block + 2, &flipped_indices, 6);
+		}
+	}
 }
 
 reshade::opengl::runtime_opengl::runtime_opengl()
@@ -79,6 +106,8 @@ reshade::opengl::runtime_opengl::runtime_opengl()
 	glGetIntegerv(GL_MAJOR_VERSION, &minor);
 	_renderer_id = 0x10000 | (major << 12) | (minor << 8);
 
+	_split_uniform_buffers = true;
+
 	// Query vendor and device ID from Windows assuming we are running on the primary display device
 	// This is done because the information reported by OpenGL is not always reflecting the actual rendering device (e.g. on NVIDIA Optimus laptops)
 	DISPLAY_DEVICEA dd = { sizeof(dd) };
@@ -419,14 +448,18 @@ bool reshade::opengl::runtime_opengl::init_texture(texture &texture)
 	glTexStorage2D(GL_TEXTURE_2D, texture.levels, internalformat, texture.width, texture.height);
 	glTextureView(texture_data->id[1], GL_TEXTURE_2D, texture_data->id[0], internalformat_srgb, 0, texture.levels, 0, 1);
 
-	// Clear texture to black since by default its contents are undefined
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo[FBO_BLIT]);
-	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, texture_data->id[0], 0);
-	assert(glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
-	glDrawBuffer(GL_COLOR_ATTACHMENT1);
-	const GLuint clear_color[4] = { 0, 0, 0, 0 };
-	glClearBufferuiv(GL_COLOR, 0, clear_color);
-	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, 0, 0);
+	// Clear texture to black since by default its contents are undefined (block-compressed textures cannot be attached to a framebuffer, those are filled with image data instead)
+	if (const bool compressed = texture.format == reshadefx::texture_format::dxt1 || texture.format == reshadefx::texture_format::dxt3 || texture.format == reshadefx::texture_format::dxt5 || texture.format == reshadefx::texture_format::latc1 || texture.format == reshadefx::texture_format::latc2;
+		!compressed)
+	{
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _fbo[FBO_BLIT]);
+		glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, texture_data->id[0], 0);
+		assert(glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+		glDrawBuffer(GL_COLOR_ATTACHMENT1);
+		const GLuint clear_color[4] = { 0, 0, 0, 0 };
+		glClearBufferuiv(GL_COLOR, 0, clear_color);
+		glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, 0, 0);
+	}
 
 	// Apply previous state from application
 	glBindTexture(GL_TEXTURE_2D, previous_tex);
@@ -475,6 +508,70 @@ void reshade::opengl::runtime_opengl::upload_texture(texture &texture, const uin
 	// Apply previous state from application
 	glBindTexture(GL_TEXTURE_2D, previous_tex);
 }
+void reshade::opengl::runtime_opengl::upload_texture_compressed(texture &texture, const uint8_t *data)
+{
+	assert(texture.impl_reference == texture_reference::none && data != nullptr);
+
+	uint32_t block_size;
+	GLenum internalformat;
+
+	switch (texture.format)
+	{
+	case reshadefx::texture_format::dxt1:
+		block_size = 8;
+		internalformat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		break;
+	case reshadefx::texture_format::dxt3:
+		block_size = 16;
+		internalformat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+		break;
+	case reshadefx::texture_format::dxt5:
+		block_size = 16;
+		internalformat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		break;
+	default:
+		LOG(ERROR) << "Compressed texture upload is not supported for format " << static_cast<unsigned int>(texture.format) << '!';
+		return;
+	}
+
+	GLint previous_tex = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_tex);
+
+	const auto texture_impl = texture.impl->as<opengl_tex_data>();
+	assert(texture_impl != nullptr);
+
+	glBindTexture(GL_TEXTURE_2D, texture_impl->id[0]);
+
+	std::vector<uint8_t> data_flipped;
+
+	for (uint32_t level = 0; level < texture.levels; ++level)
+	{
+		const uint32_t width = std::max(1u, texture.width >> level);
+		const uint32_t height = std::max(1u, texture.height >> level);
+		const uint32_t pitch = ((width + 3) / 4) * block_size;
+		const uint32_t num_rows = (height + 3) / 4;
+
+		// Flip image data horizontally, which means reversing the order of the rows of blocks and the rows of pixels inside each block
+		// Levels with a height that is not a multiple of four end up shifted by the padding rows of the last block, which cannot be avoided without decoding
+		data_flipped.resize(pitch * num_rows);
+
+		for (uint32_t y = 0; y < num_rows; ++y)
+		{
+			uint8_t *const line = data_flipped.data() + pitch * (num_rows - 1 - y);
+			std::memcpy(line, data + pitch * y, pitch);
+
+			for (uint32_t x = 0; x < pitch; x += block_size)
+				flip_compressed_block(line + x, texture.format, std::min(height, 4u));
+		}
+
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, internalformat, pitch * num_rows, data_flipped.data());
+
+		data += pitch * num_rows;
+	}
+
+	// Apply previous state from application
+	glBindTexture(GL_TEXTURE_2D, previous_tex);
+}
 bool reshade::opengl::runtime_opengl::update_texture_reference(texture &texture)
 {
 	GLuint new_reference[2] = {};
@@ -520,32 +617,13 @@ bool reshade::opengl::runtime_opengl::compile_effect(effect_data &effect)
 {
 	assert(_app_state.has_state); // Make sure all binds below are reset later when application state is restored
 
-	// Add specialization constant defines to source code
-#if 0
-	std::vector<GLuint> spec_constants;
-	std::vector<GLuint> spec_constant_values;
-	for (const auto &constant : module.spec_constants)
-	{
-		spec_constants.push_back(constant.offset);
-		spec_constant_values.push_back(constant.initializer_value.as_uint[0]);
-	}
-#else
-	effect.preamble = "#version 430\n" + effect.preamble;
-#endif
-
 	std::unordered_map<std::string, GLuint> entry_points;
+	std::vector<const std::string *> used_shader_keys;
 
 	// Compile all entry points
 	for (const auto &entry_point : effect.module.entry_points)
 	{
-		GLuint shader_id = glCreateShader(entry_point.second ? GL_FRAGMENT_SHADER : GL_VERTEX_SHADER);
-		entry_points[entry_point.first] = shader_id;
-
-#if 0
-		glShaderBinary(1, &shader_id, GL_SHADER_BINARY_FORMAT_SPIR_V, module.spirv.data(), module.spirv.size() * sizeof(uint32_t));
-		glSpecializeShader(shader_id, entry_point.first.c_str(), GLuint(spec_constants.size()), spec_constants.data(), spec_constant_values.data());
-#else
-		std::string defines = effect.preamble;
+		std::string defines = "#version 430\n" + effect.preamble;
 		defines += "#define ENTRY_POINT_" + entry_point.first + " 1\n";
 		if (!entry_point.second) // OpenGL does not allow using 'discard' in the vertex shader profile
 			defines += "#define discard\n"
@@ -553,11 +631,25 @@ bool reshade::opengl::runtime_opengl::compile_effect(effect_data &effect)
 				"#define dFdy(y) y\n"
 				"#define fwidth(p) p\n";
 
+		// Identical effects (e.g. copies of the same file) generate the same code, so only compile each combination of code and entry point once
+		// The full source is part of the key, so that two different shaders cannot end up sharing a shader object just because their hashes collide
+		std::string source_key = defines + effect.module.hlsl;
+		if (const auto it = _effect_shaders.find(source_key); it != _effect_shaders.end())
+		{
+			entry_points[entry_point.first] = it->second.value;
+
+			it->second.add_effect(effect.index);
+			used_shader_keys.push_back(&it->first);
+			continue;
+		}
+
+		GLuint shader_id = glCreateShader(entry_point.second ? GL_FRAGMENT_SHADER : GL_VERTEX_SHADER);
+
+		// Specialization constants are passed in as macro definitions in the preamble (see 'update_effect_spec_constants')
 		GLsizei lengths[] = { static_cast<GLsizei>(defines.size()), static_cast<GLsizei>(effect.module.hlsl.size()) };
 		const GLchar *sources[] = { defines.c_str(), effect.module.hlsl.c_str() };
 		glShaderSource(shader_id, 2, sources, lengths);
 		glCompileShader(shader_id);
-#endif
 
 		GLint status = GL_FALSE;
 		glGetShaderiv(shader_id, GL_COMPILE_STATUS, &status);
@@ -570,30 +662,62 @@ bool reshade::opengl::runtime_opengl::compile_effect(effect_data &effect)
 
 			effect.errors += log;
 
-			for (auto &it : entry_points)
-				glDeleteShader(it.second);
+			glDeleteShader(shader_id);
 
 			// No need to setup resources if any of the shaders failed to compile
 			return false;
 		}
+
+		// Shader objects are kept around as long as any effect uses them, so that other effects can link them into their programs too
+		entry_points[entry_point.first] = shader_id;
+		const auto it = _effect_shaders.emplace(std::move(source_key), effect_shader_cache_entry<GLuint> { shader_id }).first;
+		it->second.add_effect(effect.index);
+		used_shader_keys.push_back(&it->first);
 	}
 
-	if (effect.storage_size != 0)
+	// Delete shader objects no effect uses anymore (programs they were linked into are not affected by this)
+	release_effect_shader_cache_entries(_effect_shaders, effect.index, used_shader_keys, [](GLuint shader_id) { glDeleteShader(shader_id); });
+
+	opengl_technique_data technique_init;
+
+	// Variables updated every frame are in a separate uniform buffer (see 'split_uniform_buffers' code generation option), so the other one is not updated every frame just because of those
+	const size_t per_frame_offset = effect.module.per_frame_uniform_offset != 0 ? effect.module.per_frame_uniform_offset : effect.storage_size;
+
+	// Every effect has two slots in the list of uniform buffers, which are reused when the effect is compiled again (e.g. after it was re-specialized), so that the previous buffers are deleted
+	if (_effect_ubos.size() < (effect.index + 1) * 2)
+		_effect_ubos.resize((effect.index + 1) * 2);
+
+	for (const auto [offset, size] : { std::make_pair(size_t(0), per_frame_offset), std::make_pair(per_frame_offset, effect.storage_size - per_frame_offset) })
 	{
+		const size_t buffer_index = effect.index * 2 + (offset == 0 ? 0 : 1);
+		if (_effect_ubos[buffer_index].first != 0)
+			glDeleteBuffers(1, &_effect_ubos[buffer_index].first);
+		_effect_ubos[buffer_index] = { 0, 0 };
+
+		if (size == 0)
+			continue;
+
 		GLuint ubo = 0;
 		glGenBuffers(1, &ubo);
 		glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-		glBufferData(GL_UNIFORM_BUFFER, effect.storage_size, _uniform_data_storage.data() + effect.storage_offset, GL_DYNAMIC_DRAW);
+		glBufferData(GL_UNIFORM_BUFFER, size, _uniform_data_storage.data() + effect.storage_offset + offset, GL_DYNAMIC_DRAW);
 
-		_effect_ubos.emplace_back(ubo, effect.storage_size);
+		_effect_ubos[buffer_index] = { ubo, size };
+
+		if (offset == 0)
+		{
+			technique_init.uniform_storage_index = buffer_index;
+			technique_init.uniform_storage_offset = effect.storage_offset;
+		}
+		else
+		{
+			technique_init.per_frame_uniform_storage_index = buffer_index;
+			technique_init.per_frame_uniform_storage_offset = effect.storage_offset + offset;
+		}
 	}
 
 	bool success = true;
 
-	opengl_technique_data technique_init;
-	technique_init.uniform_storage_index = _effect_ubos.size() - 1;
-	technique_init.uniform_storage_offset = effect.storage_offset;
-
 	for (const reshadefx::sampler_info &info : effect.module.samplers)
 		success &= add_sampler(info, technique_init);
 
@@ -601,22 +725,39 @@ bool reshade::opengl::runtime_opengl::compile_effect(effect_data &effect)
 		if (technique.impl == nullptr && technique.effect_index == effect.index)
 			success &= init_technique(technique, technique_init, entry_points, effect.errors);
 
-	for (auto &it : entry_points)
-		glDeleteShader(it.second);
-
 	return success;
 }
+void reshade::opengl::runtime_opengl::unload_effect(size_t id)
+{
+	runtime::unload_effect(id);
+
+	// Delete the uniform buffers of the effect, new ones are created when it is compiled again
+	for (size_t buffer_index = id * 2; buffer_index < (id + 1) * 2 && buffer_index < _effect_ubos.size(); ++buffer_index)
+	{
+		if (_effect_ubos[buffer_index].first != 0)
+			glDeleteBuffers(1, &_effect_ubos[buffer_index].first);
+		_effect_ubos[buffer_index] = { 0, 0 };
+	}
+
+	// Delete the shader objects no other effect uses
+	release_effect_shader_cache_entries(_effect_shaders, id, {}, [](GLuint shader_id) { glDeleteShader(shader_id); });
+}
 void reshade::opengl::runtime_opengl::unload_effects()
 {
 	runtime::unload_effects();
 
 	for (const auto &info : _effect_ubos)
-		glDeleteBuffers(1, &info.first);
+		if (info.first != 0)
+			glDeleteBuffers(1, &info.first);
 	_effect_ubos.clear();
 
 	for (const auto &info : _effect_sampler_states)
 		glDeleteSamplers(1, &info.second);
 	_effect_sampler_states.clear();
+
+	for (const auto &info : _effect_shaders)
+		glDeleteShader(info.second.value);
+	_effect_shaders.clear();
 }
 
 bool reshade::opengl::runtime_opengl::add_sampler(const reshadefx::sampler_info &info, opengl_technique_data &technique_init)
@@ -915,13 +1056,25 @@ void reshade::opengl::runtime_opengl::render_technique(technique &technique)
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	glBindVertexArray(_vao[VAO_FX]); // This is an empty vertex array object
 
-	// Set up shader constants
+	// Set up shader constants (only uploading the bytes that changed since the last upload)
 	if (technique_data.uniform_storage_index >= 0)
 	{
 		glBindBufferBase(GL_UNIFORM_BUFFER, 0, _effect_ubos[technique_data.uniform_storage_index].first);
-		glBufferSubData(GL_UNIFORM_BUFFER, 0, _effect_ubos[technique_data.uniform_storage_index].second, _uniform_data_storage.data() + technique_data.uniform_storage_offset);
+
+		if (const auto [offset, size] = get_modified_uniform_storage(technique.effect_index, technique_data.uniform_storage_offset, _effect_ubos[technique_data.uniform_storage_index].second); size != 0)
+			glBufferSubData(GL_UNIFORM_BUFFER, offset - technique_data.uniform_storage_offset, size, _uniform_data_storage.data() + offset);
+	}
+	if (technique_data.per_frame_uniform_storage_index >= 0)
+	{
+		glBindBufferBase(GL_UNIFORM_BUFFER, 1, _effect_ubos[technique_data.per_frame_uniform_storage_index].first);
+
+		if (const auto [offset, size] = get_modified_uniform_storage(technique.effect_index, technique_data.per_frame_uniform_storage_offset, _effect_ubos[technique_data.per_frame_uniform_storage_index].second); size != 0)
+			glBufferSubData(GL_UNIFORM_BUFFER, offset - technique_data.per_frame_uniform_storage_offset, size, _uniform_data_storage.data() + offset);
 	}
 
+	// These buffers are shared by all techniques in the effect, so the modified range can be reset as soon as they were updated once
+	_uniform_storage_modified[technique.effect_index] = {};
+
 	// Set up shader resources
 	for (size_t i = 0; i < technique_data.samplers.size(); i++)
 	{
@@ -41,10 +41,12 @@ namespace reshade::opengl
 
 		bool init_texture(texture &info) override;
 		void upload_texture(texture &texture, const uint8_t *data) override;
+		void upload_texture_compressed(texture &texture, const uint8_t *data) override;
 		bool update_texture_reference(texture &texture);
 		void update_texture_references(texture_reference type);
 
 		bool compile_effect(effect_data &effect) override;
+		void unload_effect(size_t id) override;
 		void unload_effects() override;
 
 		bool add_sampler(const reshadefx::sampler_info &info, struct opengl_technique_data &technique_init);
@@ -111,6 +113,7 @@ namespace reshade::opengl
 		int _imgui_uniform_proj = 0;
 #endif
 		std::unordered_map<size_t, GLuint> _effect_sampler_states;
-		std::vector<std::pair<GLuint, GLsizeiptr>> _effect_ubos;
+		std::unordered_map<std::string, effect_shader_cache_entry<GLuint>> _effect_shaders; // Shader objects by the defines and code they were compiled from
+		std::vector<std::pair<GLuint, GLsizeiptr>> _effect_ubos; // Two per effect (the second one for variables updated every frame), by effect ID
 	};
 }
@@ -10,10 +10,13 @@
 #include "effect_parser.hpp"
 #include "effect_codegen.hpp"
 #include "effect_preprocessor.hpp"
+#include "effect_module_cache.hpp"
 #include "input.hpp"
 #include "ini_file.hpp"
 #include <assert.h>
+#include <Windows.h>
 #include <thread>
+#include <fstream>
 #include <algorithm>
 #include <stb_image.h>
 #include <stb_image_dds.h>
@@ -65,6 +68,217 @@ static std::vector<std::filesystem::path> find_files(const std::vector<std::file
 	return files;
 }
 
+static bool read_dds_compressed_data(const uint8_t *filedata, size_t filesize, reshade::texture_load_task &task)
+{
+	// See https://docs.microsoft.com/windows/win32/direct3ddds/dds-header for the layout of the header
+	const auto read_uint32 = [filedata](size_t offset) { uint32_t value; std::memcpy(&value, filedata + offset, sizeof(value)); return value; };
+
+	if (filesize < 128 || read_uint32(0) != MAKEFOURCC('D', 'D', 'S', ' ') || read_uint32(4) != 124)
+		return false;
+
+	const uint32_t height = read_uint32(12), width = read_uint32(16), depth = read_uint32(24);
+	const uint32_t levels = (read_uint32(8) & 0x20000 /* DDSD_MIPMAPCOUNT */) ? std::max(read_uint32(28), 1u) : 1u;
+	// Only plain 2D textures can be passed through, not cube maps or volume textures
+	if ((read_uint32(112) & 0x200 /* DDSCAPS2_CUBEMAP */) != 0 || depth > 1)
+		return false;
+
+	reshadefx::texture_format format = reshadefx::texture_format::unknown;
+	size_t data_offset = 128;
+
+	switch ((read_uint32(80) & 0x4 /* DDPF_FOURCC */) ? read_uint32(84) : 0)
+	{
+	case MAKEFOURCC('D', 'X', 'T', '1'):
+		format = reshadefx::texture_format::dxt1;
+		break;
+	case MAKEFOURCC('D', 'X', 'T', '2'):
+	case MAKEFOURCC('D', 'X', 'T', '3'):
+		format = reshadefx::texture_format::dxt3;
+		break;
+	case MAKEFOURCC('D', 'X', 'T', '4'):
+	case MAKEFOURCC('D', 'X', 'T', '5'):
+		format = reshadefx::texture_format::dxt5;
+		break;
+	case MAKEFOURCC('D', 'X', '1', '0'):
+		// Extended header with a DXGI format, followed by the resource dimension, flags and array size
+		if (filesize < 148 || read_uint32(132) != 3 /* D3D10_RESOURCE_DIMENSION_TEXTURE2D */ || (read_uint32(136) & 0x4 /* D3D10_RESOURCE_MISC_TEXTURECUBE */) != 0 || read_uint32(140) > 1)
+			return false;
+		switch (read_uint32(128))
+		{
+		case 70: // DXGI_FORMAT_BC1_TYPELESS
+		case 71: // DXGI_FORMAT_BC1_UNORM
+		case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+			format = reshadefx::texture_format::dxt1;
+			break;
+		case 73: // DXGI_FORMAT_BC2_TYPELESS
+		case 74: // DXGI_FORMAT_BC2_UNORM
+		case 75: // DXGI_FORMAT_BC2_UNORM_SRGB
+			format = reshadefx::texture_format::dxt3;
+			break;
+		case 76: // DXGI_FORMAT_BC3_TYPELESS
+		case 77: // DXGI_FORMAT_BC3_UNORM
+		case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+			format = reshadefx::texture_format::dxt5;
+			break;
+		}
+		data_offset = 148;
+		break;
+	}
+
+	// The data can only be used as is if it matches the texture exactly and provides all of its mipmap levels
+	if (format != task.format || width != task.width || height != task.height || levels < task.levels)
+		return false;
+
+	const size_t block_size = format == reshadefx::texture_format::dxt1 ? 8 : 16;
+
+	size_t data_size = 0;
+	for (uint32_t level = 0; level < task.levels; ++level)
+		data_size += std::max(1u, ((width >> level) + 3) / 4) * std::max(1u, ((height >> level) + 3) / 4) * block_size;
+
+	if (filesize - data_offset < data_size)
+		return false;
+
+	task.pixels.assign(filedata + data_offset, filedata + data_offset + data_size);
+	task.compressed = true;
+
+	return true;
+}
+
+static void load_image_file(reshade::texture_load_task &task)
+{
+	unsigned char *filedata = nullptr;
+	int width = 0, height = 0, channels = 0;
+
+	// Map the file into memory instead of reading it into a buffer first, so that its contents are only copied by the decoder
+	if (const HANDLE file = CreateFileW(task.source_path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		file != INVALID_HANDLE_VALUE)
+	{
+		if (LARGE_INTEGER filesize = {}; GetFileSizeEx(file, &filesize) && filesize.QuadPart > 0 && filesize.QuadPart <= INT_MAX)
+		{
+			if (const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				mapping != nullptr)
+			{
+				if (const auto mapped_data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+					mapped_data != nullptr)
+				{
+					const int mapped_size = static_cast<int>(filesize.QuadPart);
+
+					if (stbi_dds_test_memory(mapped_data, mapped_size))
+					{
+						// Pass block-compressed data through as is if it is already in the format of the texture
+						if (!read_dds_compressed_data(mapped_data, mapped_size, task))
+							filedata = stbi_dds_load_from_memory(mapped_data, mapped_size, &width, &height, &channels, STBI_rgb_alpha);
+					}
+					else
+					{
+						filedata = stbi_load_from_memory(mapped_data, mapped_size, &width, &height, &channels, STBI_rgb_alpha);
+					}
+
+					UnmapViewOfFile(mapped_data);
+				}
+
+				CloseHandle(mapping);
+			}
+		}
+
+		CloseHandle(file);
+	}
+
+	if (task.compressed || filedata == nullptr)
+		return;
+
+	task.pixels.resize(task.width * task.height * 4);
+
+	if (task.width != uint32_t(width) || task.height != uint32_t(height))
+	{
+		LOG(INFO) << "> Resizing image data of " << task.source_path << " from " << width << "x" << height << " to " << task.width << "x" << task.height << " ...";
+
+		stbir_resize_uint8(filedata, width, height, 0, task.pixels.data(), task.width, task.height, 0, 4);
+	}
+	else
+	{
+		std::memcpy(task.pixels.data(), filedata, task.pixels.size());
+	}
+
+	stbi_image_free(filedata);
+}
+
+static unsigned int shader_model_from_renderer_id(unsigned int renderer_id)
+{
+	if (renderer_id == 0x9000)
+		return 30;
+	else if (renderer_id < 0xa100)
+		return 40;
+	else if (renderer_id < 0xb000)
+		return 41;
+	else if (renderer_id < 0xc000)
+		return 50;
+	else
+		return 60;
+}
+static reshadefx::codegen *create_codegen(unsigned int renderer_id, bool performance_mode, bool split_uniform_buffers)
+{
+	if ((renderer_id & 0xF0000) == 0)
+		return reshadefx::create_codegen_hlsl(shader_model_from_renderer_id(renderer_id), true, performance_mode, true, split_uniform_buffers);
+	else if (renderer_id < 0x20000)
+		return reshadefx::create_codegen_glsl(true, performance_mode, true, split_uniform_buffers);
+	else // Vulkan uses SPIR-V input
+		return reshadefx::create_codegen_spirv(true, performance_mode, true);
+}
+
+static bool used_macros_unchanged(const std::vector<std::pair<std::string, std::pair<bool, std::string>>> &used_macros, const std::vector<std::pair<std::string, std::string>> &macros)
+{
+	// Every macro the effect referenced has to have the same definition it had when the effect was compiled (the first definition wins, same as in the preprocessor)
+	for (const auto &macro : used_macros)
+	{
+		const auto it = std::find_if(macros.begin(), macros.end(),
+			[&name = macro.first](const auto &definition) { return definition.first == name; });
+		if (macro.second.first != (it != macros.end()) || (it != macros.end() && macro.second.second != it->second))
+			return false;
+	}
+
+	return true;
+}
+
+static bool load_effect_cache(const std::filesystem::path &cache_path, const std::filesystem::path &effect_path, const std::string &codegen_key, const std::vector<std::pair<std::string, std::string>> &macros, reshadefx::module &module, std::vector<std::pair<std::string, std::pair<bool, std::string>>> &used_macros)
+{
+	std::error_code ec;
+	if (!std::filesystem::exists(cache_path, ec))
+		return false;
+
+	std::ifstream file(cache_path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	reshadefx::module_cache_info info;
+	if (!reshadefx::read_module_cache_info(data, info))
+	{
+		LOG(WARN) << "Ignoring invalid module cache " << cache_path << '.';
+		return false;
+	}
+
+	if (info.compiler_version != VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION || info.codegen_key != codegen_key)
+		return false;
+
+	// Every macro the effect referenced has to have the same definition it had when the module was generated
+	if (!used_macros_unchanged(info.macros, macros))
+		return false;
+
+	// And none of the source files may have changed since
+	for (const auto &source_file : info.files)
+	{
+		uint64_t hash = 0;
+		if (!reshadefx::hash_file(effect_path.parent_path() / std::filesystem::u8path(source_file.first), hash) || hash != source_file.second)
+			return false;
+	}
+
+	if (!reshadefx::read_module_cache(data, info, module))
+		return false;
+
+	used_macros = std::move(info.macros);
+	return true;
+}
+
 reshade::runtime::runtime() :
 	_start_time(std::chrono::high_resolution_clock::now()),
 	_last_present_time(std::chrono::high_resolution_clock::now()),
@@ -195,13 +409,72 @@ void reshade::runtime::on_present()
 	_drawcalls = _vertices = 0;
 }
 
-void reshade::runtime::load_effect(const std::filesystem::path &path, size_t &out_id)
+std::vector<std::pair<std::string, std::string>> reshade::runtime::build_macro_definitions() const
 {
-	effect_data effect;
+	std::vector<std::pair<std::string, std::string>> macros = {
+		{ "__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION) },
+		{ "__RESHADE_PERFORMANCE_MODE__", _performance_mode ? "1" : "0" },
+		{ "__VENDOR__", std::to_string(_vendor_id) },
+		{ "__DEVICE__", std::to_string(_device_id) },
+		{ "__RENDERER__", std::to_string(_renderer_id) },
+		{ "__APPLICATION__", std::to_string(std::hash<std::string>()(g_target_executable_path.stem().u8string())) },
+		{ "BUFFER_WIDTH", std::to_string(_width) },
+		{ "BUFFER_HEIGHT", std::to_string(_height) },
+		{ "BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)" },
+		{ "BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)" },
+	};
+
+	std::vector<std::string> preprocessor_definitions = _global_preprocessor_definitions;
+	preprocessor_definitions.insert(preprocessor_definitions.end(), _preset_preprocessor_definitions.begin(), _preset_preprocessor_definitions.end());
+
+	for (const auto &definition : preprocessor_definitions)
+	{
+		if (definition.empty())
+			continue; // Skip invalid definitions
+
+		const size_t equals_index = definition.find('=');
+		if (equals_index != std::string::npos)
+			macros.emplace_back(
+				definition.substr(0, equals_index),
+				definition.substr(equals_index + 1));
+		else
+			macros.emplace_back(definition, "1");
+	}
+
+	return macros;
+}
+void reshade::runtime::load_effect(const std::filesystem::path &path, size_t index)
+{
+	effect_data &effect = _loaded_effects[index];
+	// Keep the space the effect had in the uniform storage area if it is loaded again after 'unload_effect', so that 'init_effect' can reuse it
+	const size_t previous_storage_offset = effect.storage_offset;
+	const size_t previous_storage_size = effect.storage_size;
+	effect = effect_data();
+	effect.index = index;
+	effect.storage_offset = previous_storage_offset;
+	effect.storage_size = previous_storage_size;
 	effect.source_file = path;
 	effect.compile_sucess = true;
 
+	const std::vector<std::pair<std::string, std::string>> macros = build_macro_definitions();
+
+	std::string codegen_key;
+	if ((_renderer_id & 0xF0000) == 0)
+		codegen_key = reshadefx::make_codegen_key("hlsl", shader_model_from_renderer_id(_renderer_id), true, _performance_mode, true, _split_uniform_buffers);
+	else if (_renderer_id < 0x20000)
+		codegen_key = reshadefx::make_codegen_key("glsl", 0, true, _performance_mode, true, _split_uniform_buffers);
+	else
+		codegen_key = reshadefx::make_codegen_key("spirv", 0, true, _performance_mode, true, false);
+
+	// Use a module precompiled with fxc if there is one next to the effect file and it was generated for the current configuration
+	if (load_effect_cache(std::filesystem::path(path).replace_extension(".fxcache"), path, codegen_key, macros, effect.module, effect.used_macros))
+	{
+		LOG(INFO) << "Using precompiled module for " << path << '.';
+	}
+	else
 	{ // Load, pre-process and compile the source file
+		effect.module = reshadefx::module();
+
 		reshadefx::preprocessor pp;
 		if (path.is_absolute())
 			pp.add_include_path(path.parent_path());
@@ -217,33 +490,8 @@ void reshade::runtime::load_effect(const std::filesystem::path &path, size_t &ou
 				pp.add_include_path(canonical_include_path);
 		}
 
-		pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
-		pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", _performance_mode ? "1" : "0");
-		pp.add_macro_definition("__VENDOR__", std::to_string(_vendor_id));
-		pp.add_macro_definition("__DEVICE__", std::to_string(_device_id));
-		pp.add_macro_definition("__RENDERER__", std::to_string(_renderer_id));
-		pp.add_macro_definition("__APPLICATION__", std::to_string(std::hash<std::string>()(g_target_executable_path.stem().u8string())));
-		pp.add_macro_definition("BUFFER_WIDTH", std::to_string(_width));
-		pp.add_macro_definition("BUFFER_HEIGHT", std::to_string(_height));
-		pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
-		pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
-
-		std::vector<std::string> preprocessor_definitions = _global_preprocessor_definitions;
-		preprocessor_definitions.insert(preprocessor_definitions.end(), _preset_preprocessor_definitions.begin(), _preset_preprocessor_definitions.end());
-
-		for (const auto &definition : preprocessor_definitions)
-		{
-			if (definition.empty())
-				continue; // Skip invalid definitions
-
-			const size_t equals_index = definition.find('=');
-			if (equals_index != std::string::npos)
-				pp.add_macro_definition(
-					definition.substr(0, equals_index),
-					definition.substr(equals_index + 1));
-			else
-				pp.add_macro_definition(definition);
-		}
+		for (const auto &macro : macros)
+			pp.add_macro_definition(macro.first, macro.second);
 
 		if (!pp.append_file(path))
 		{
@@ -251,25 +499,12 @@ void reshade::runtime::load_effect(const std::filesystem::path &path, size_t &ou
 			effect.compile_sucess = false;
 		}
 
-		unsigned shader_model;
-		if (_renderer_id == 0x9000)
-			shader_model = 30;
-		else if (_renderer_id < 0xa100)
-			shader_model = 40;
-		else if (_renderer_id < 0xb000)
-			shader_model = 41;
-		else if (_renderer_id < 0xc000)
-			shader_model = 50;
-		else
-			shader_model = 60;
+		// Only record what the parser does when code generation is deferred, which is enough to describe the effect in the user interface
+		// This is not done in performance mode, since the code is needed right away to know which uniform variables become specialization constants
+		const bool defer_code_generation = _lazy_effect_compilation && !_performance_mode;
 
-		std::unique_ptr<reshadefx::codegen> codegen;
-		if ((_renderer_id & 0xF0000) == 0)
-			codegen.reset(reshadefx::create_codegen_hlsl(shader_model, true, _performance_mode));
-		else if (_renderer_id < 0x20000)
-			codegen.reset(reshadefx::create_codegen_glsl(true, _performance_mode));
-		else // Vulkan uses SPIR-V input
-			codegen.reset(reshadefx::create_codegen_spirv(true, _performance_mode));
+		std::unique_ptr<reshadefx::codegen> codegen(defer_code_generation ?
+			reshadefx::create_codegen_recorder() : create_codegen(_renderer_id, _performance_mode, _split_uniform_buffers));
 
 		reshadefx::parser parser;
 
@@ -283,105 +518,64 @@ void reshade::runtime::load_effect(const std::filesystem::path &path, size_t &ou
 		// Append preprocessor and parser errors to the error list
 		effect.errors = std::move(pp.errors()) + std::move(parser.errors());
 
+		// Remember which macros the result depends on, so that the effect only needs to be loaded again when one of those changes
+		effect.used_macros.assign(pp.used_macro_definitions().begin(), pp.used_macro_definitions().end());
+
 		// Write result to effect module
 		codegen->write_result(effect.module);
-	}
 
-	// Fill all specialization constants with values from the current preset
-	if (_performance_mode && _current_preset < _preset_files.size() && effect.compile_sucess)
-	{
-		const ini_file preset(_preset_files[_current_preset]);
-		const std::string section(path.filename().u8string());
-
-		for (reshadefx::uniform_info &constant : effect.module.spec_constants)
+		if (defer_code_generation)
 		{
-			effect.preamble += "#define SPEC_CONSTANT_" + constant.name + ' ';
-
-			switch (constant.type.base)
+			// Pack uniform variables tightly until the back-end decides on the actual layout, so that they can already be edited
+			uint32_t offset = 0;
+			for (reshadefx::uniform_info &info : effect.module.uniforms)
 			{
-			case reshadefx::type::t_int:
-				preset.get(section, constant.name, constant.initializer_value.as_int);
-				break;
-			case reshadefx::type::t_bool:
-			case reshadefx::type::t_uint:
-				preset.get(section, constant.name, constant.initializer_value.as_uint);
-				break;
-			case reshadefx::type::t_float:
-				preset.get(section, constant.name, constant.initializer_value.as_float);
-				break;
-			}
-
-			for (unsigned int i = 0; i < constant.type.components(); ++i)
-			{
-				switch (constant.type.base)
-				{
-				case reshadefx::type::t_bool:
-					effect.preamble += constant.initializer_value.as_uint[i] ? "true" : "false";
-					break;
-				case reshadefx::type::t_int:
-					effect.preamble += std::to_string(constant.initializer_value.as_int[i]);
-					break;
-				case reshadefx::type::t_uint:
-					effect.preamble += std::to_string(constant.initializer_value.as_uint[i]);
-					break;
-				case reshadefx::type::t_float:
-					effect.preamble += std::to_string(constant.initializer_value.as_float[i]);
-					break;
-				}
-
-				if (i + 1 < constant.type.components())
-					effect.preamble += ", ";
+				info.size = info.type.rows * info.type.cols * std::max(1, info.type.array_length) * 4;
+				info.offset = offset;
+				offset += info.size;
 			}
 
-			effect.preamble += '\n';
+			effect.module.total_uniform_size = offset;
+			effect.recording = std::move(codegen);
 		}
 	}
 
-	// Guard access to shared variables
-	const std::lock_guard<std::mutex> lock(_reload_mutex);
+	// Fill all specialization constants with values from the current preset
+	if (_performance_mode && _current_preset < _preset_files.size() && effect.compile_sucess)
+		update_effect_spec_constants(effect, ini_file(_preset_files[_current_preset]));
+
+	_reload_remaining_effects--;
+}
+void reshade::runtime::init_effect(size_t index)
+{
+	effect_data &effect = _loaded_effects[index];
+
+	// The buffer layout may need more space than the uniform data itself (e.g. padding between array elements)
+	size_t storage_size = effect.module.total_uniform_size;
+	for (const reshadefx::uniform_info &info : effect.module.uniforms)
+		storage_size = std::max<size_t>(storage_size, info.offset + info.size);
+	storage_size = (storage_size + 15) & ~15;
+
+	// Reuse the space the effect had before it was unloaded if possible, otherwise the effect moves to the end of the storage area
+	if (effect.storage_size == 0 || storage_size > effect.storage_size)
+	{
+		effect.storage_offset = _uniform_data_storage.size();
+		_uniform_data_storage.resize(effect.storage_offset + storage_size);
+	}
 
-	effect.index = out_id = _loaded_effects.size();
-	effect.storage_offset = _uniform_data_storage.size();
+	effect.storage_size = storage_size;
+	std::memset(_uniform_data_storage.data() + effect.storage_offset, 0, storage_size);
 
 	for (const reshadefx::uniform_info &info : effect.module.uniforms)
 	{
 		uniform &variable = _uniforms.emplace_back(info);
 		variable.effect_index = effect.index;
-
 		variable.storage_offset = effect.storage_offset + variable.offset;
-		// Create space for the new variable in the storage area and fill it with the initializer value
-		_uniform_data_storage.resize(variable.storage_offset + variable.size);
 
 		// Copy initial data into uniform storage area
 		reset_uniform_value(variable);
-
-		const std::string_view special = variable.annotation_as_string("source");
-		if (special.empty()) /* Ignore if annotation is missing */;
-		else if (special == "frametime")
-			variable.special = special_uniform::frame_time;
-		else if (special == "framecount")
-			variable.special = special_uniform::frame_count;
-		else if (special == "random")
-			variable.special = special_uniform::random;
-		else if (special == "pingpong")
-			variable.special = special_uniform::ping_pong;
-		else if (special == "date")
-			variable.special = special_uniform::date;
-		else if (special == "timer")
-			variable.special = special_uniform::timer;
-		else if (special == "key")
-			variable.special = special_uniform::key;
-		else if (special == "mousepoint")
-			variable.special = special_uniform::mouse_point;
-		else if (special == "mousedelta")
-			variable.special = special_uniform::mouse_delta;
-		else if (special == "mousebutton")
-			variable.special = special_uniform::mouse_button;
 	}
 
-	effect.storage_size = (_uniform_data_storage.size() - effect.storage_offset + 15) & ~15;
-	_uniform_data_storage.resize(effect.storage_offset + effect.storage_size);
-
 	for (const reshadefx::texture_info &info : effect.module.textures)
 	{
 		// Try to share textures with the same name across effects
@@ -413,34 +607,142 @@ void reshade::runtime::load_effect(const std::filesystem::path &path, size_t &ou
 			effect.errors += "warning: " + info.unique_name + ": unknown semantic '" + info.semantic + "'\n";
 	}
 
-	_loaded_effects.push_back(effect); // The 'enable_technique' call below needs to access this, so append the effect now
+	mark_uniform_storage_modified(effect.index, effect.storage_offset, effect.storage_size);
 
 	for (const reshadefx::technique_info &info : effect.module.techniques)
 	{
 		technique &technique = _techniques.emplace_back(info);
 		technique.effect_index = effect.index;
 
-		technique.hidden = technique.annotation_as_int("hidden") != 0;
-		technique.timeout = technique.annotation_as_int("timeout");
-		technique.timeleft = technique.timeout;
-		technique.toggle_key_data[0] = technique.annotation_as_int("toggle");
-		technique.toggle_key_data[1] = technique.annotation_as_int("togglectrl");
-		technique.toggle_key_data[2] = technique.annotation_as_int("toggleshift");
-		technique.toggle_key_data[3] = technique.annotation_as_int("togglealt");
-
-		if (technique.annotation_as_int("enabled"))
+		if (technique.force_enabled)
 			enable_technique(technique);
 	}
 
 	if (effect.compile_sucess)
 		if (effect.errors.empty())
-			LOG(INFO) << "Successfully loaded " << path << '.';
+			LOG(INFO) << "Successfully loaded " << effect.source_file << '.';
 		else
-			LOG(WARN) << "Successfully loaded " << path << " with warnings:\n" << effect.errors;
+			LOG(WARN) << "Successfully loaded " << effect.source_file << " with warnings:\n" << effect.errors;
 
-	_reload_remaining_effects--;
 	_last_reload_successful &= effect.compile_sucess;
 }
+void reshade::runtime::generate_effect_code(effect_data &effect) const
+{
+	const std::unique_ptr<reshadefx::codegen> codegen(create_codegen(_renderer_id, _performance_mode, _split_uniform_buffers));
+
+	reshadefx::replay_codegen(*effect.recording, *codegen);
+
+	codegen->write_result(effect.module);
+
+	effect.recording.reset();
+}
+void reshade::runtime::init_effect_code(size_t index, reshadefx::module &&module)
+{
+	effect_data &effect = _loaded_effects[index];
+
+	// Keep the current values of all variables, since they are moved to different offsets below
+	const std::vector<uint8_t> previous_storage(
+		_uniform_data_storage.begin() + effect.storage_offset,
+		_uniform_data_storage.begin() + effect.storage_offset + effect.storage_size);
+	const size_t previous_storage_offset = effect.storage_offset;
+
+	effect.module = std::move(module);
+	effect.recording.reset();
+
+	size_t storage_size = effect.module.total_uniform_size;
+	for (const reshadefx::uniform_info &info : effect.module.uniforms)
+		storage_size = std::max<size_t>(storage_size, info.offset + info.size);
+	storage_size = (storage_size + 15) & ~15;
+
+	// Reuse the space of the packed layout if possible, otherwise the effect moves to the end of the storage area
+	if (storage_size > effect.storage_size)
+	{
+		effect.storage_offset = _uniform_data_storage.size();
+		_uniform_data_storage.resize(effect.storage_offset + storage_size);
+	}
+
+	effect.storage_size = storage_size;
+	std::memset(_uniform_data_storage.data() + effect.storage_offset, 0, storage_size);
+
+	for (uniform &variable : _uniforms)
+	{
+		if (variable.effect_index != index)
+			continue;
+
+		const auto info = std::find_if(effect.module.uniforms.begin(), effect.module.uniforms.end(),
+			[&variable](const reshadefx::uniform_info &info) { return info.name == variable.name; });
+		assert(info != effect.module.uniforms.end() && info->size == variable.size);
+
+		std::memcpy(_uniform_data_storage.data() + effect.storage_offset + info->offset, previous_storage.data() + (variable.storage_offset - previous_storage_offset), variable.size);
+
+		variable.offset = info->offset;
+		variable.storage_offset = effect.storage_offset + info->offset;
+	}
+
+	mark_uniform_storage_modified(index, effect.storage_offset, effect.storage_size);
+
+	if (effect.module.uniform_bytes_saved != 0)
+		LOG(INFO) << "> Reordered uniform variables in " << effect.source_file << " to save " << effect.module.uniform_bytes_saved << " bytes of padding (" << effect.module.total_uniform_size << " bytes total).";
+}
+bool reshade::runtime::update_effect_spec_constants(effect_data &effect, const ini_file &preset)
+{
+	const std::string section(effect.source_file.filename().u8string());
+
+	// The generated code references the specialization constants via macros, so specializing the effect only requires a new preamble and not another run through preprocessor, parser and code generation
+	std::string preamble;
+
+	for (const reshadefx::uniform_info &constant : effect.module.spec_constants)
+	{
+		// Start with the default value, so that values missing from the preset are reset
+		reshadefx::constant values = constant.initializer_value;
+
+		switch (constant.type.base)
+		{
+		case reshadefx::type::t_int:
+			preset.get(section, constant.name, values.as_int);
+			break;
+		case reshadefx::type::t_bool:
+		case reshadefx::type::t_uint:
+			preset.get(section, constant.name, values.as_uint);
+			break;
+		case reshadefx::type::t_float:
+			preset.get(section, constant.name, values.as_float);
+			break;
+		}
+
+		preamble += "#define SPEC_CONSTANT_" + constant.name + ' ';
+
+		for (unsigned int i = 0; i < constant.type.components(); ++i)
+		{
+			switch (constant.type.base)
+			{
+			case reshadefx::type::t_bool:
+				preamble += values.as_uint[i] ? "true" : "false";
+				break;
+			case reshadefx::type::t_int:
+				preamble += std::to_string(values.as_int[i]);
+				break;
+			case reshadefx::type::t_uint:
+				preamble += std::to_string(values.as_uint[i]);
+				break;
+			case reshadefx::type::t_float:
+				preamble += std::to_string(values.as_float[i]);
+				break;
+			}
+
+			if (i + 1 < constant.type.components())
+				preamble += ", ";
+		}
+
+		preamble += '\n';
+	}
+
+	if (preamble == effect.preamble)
+		return false;
+
+	effect.preamble = std::move(preamble);
+	return true;
+}
 void reshade::runtime::load_effects()
 {
 	// Clear out any previous effects
@@ -460,105 +762,296 @@ void reshade::runtime::load_effects()
 	const std::vector<std::filesystem::path> effect_files =
 		find_files(_effect_search_paths, { ".fx" });
 
-	_reload_total_effects = effect_files.size();
+	// Every effect gets a slot up front, so that the effect index only depends on the position in the list and workers never have to synchronize with each other
+	_loaded_effects.resize(effect_files.size());
+	_uniform_storage_modified.resize(effect_files.size());
+
+	for (size_t index = 0; index < effect_files.size(); ++index)
+		_reload_queue.emplace_back(index, effect_files[index]);
+
+	start_loading_effects();
+}
+void reshade::runtime::start_loading_effects()
+{
+	// The threads of a previous load have exited already, but still need to be joined
+	for (std::thread &thread : _worker_threads)
+		thread.join();
+	_worker_threads.clear();
+
+	std::vector<uintmax_t> file_sizes(_loaded_effects.size());
+	for (const auto &entry : _reload_queue)
+	{
+		std::error_code ec;
+		file_sizes[entry.first] = std::filesystem::file_size(entry.second, ec);
+	}
+
+	// Load the largest effects first, since they usually take the longest and would delay the end of the reload if they were started last
+	std::stable_sort(_reload_queue.begin(), _reload_queue.end(),
+		[&file_sizes](const auto &lhs, const auto &rhs) { return file_sizes[lhs.first] > file_sizes[rhs.first]; });
+
+	_reload_queue_index = 0;
+	_reload_cancelled = false;
+
+	_reload_total_effects = _reload_queue.size();
 	_reload_remaining_effects = _reload_total_effects;
 
-	// Now that we have a list of files, load them in parallel
-	for (const std::filesystem::path &file : effect_files)
-		_worker_threads.emplace_back([this, file]() { size_t id; load_effect(file, id); }); // Keep track of the spawned threads, so the runtime cannot be destroyed while they are still running
+	// Now that we have a list of files, load them in parallel on a fixed number of threads, which each take the next file from the queue until it is empty
+	const size_t num_threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), _reload_queue.size());
+	for (size_t i = 0; i < num_threads; ++i)
+		_worker_threads.emplace_back([this]() { // Keep track of the spawned threads, so the runtime cannot be destroyed while they are still running
+			// Loading effects is not time critical, so avoid taking processor time away from the application render thread
+			SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+			for (size_t index; !_reload_cancelled && (index = _reload_queue_index++) < _reload_queue.size();)
+				load_effect(_reload_queue[index].second, _reload_queue[index].first);
+		});
 }
 void reshade::runtime::load_textures()
 {
-	LOG(INFO) << "Loading image files for textures ...";
-
-	for (texture &texture : _textures)
+	if (_texture_load_tasks.empty())
 	{
-		if (texture.impl == nullptr || texture.impl_reference != texture_reference::none)
-			continue; // Ignore textures that are not created yet and those that are handled in the runtime implementation
+		LOG(INFO) << "Loading image files for textures ...";
 
-		std::filesystem::path source_path = std::filesystem::u8path(
-			texture.annotation_as_string("source"));
-		// Ignore textures that have no image file attached to them (e.g. plain render targets)
-		if (source_path.empty())
-			continue;
+		for (texture &texture : _textures)
+		{
+			if (texture.impl == nullptr || texture.impl_reference != texture_reference::none)
+				continue; // Ignore textures that are not created yet and those that are handled in the runtime implementation
+
+			std::filesystem::path source_path = std::filesystem::u8path(texture.source);
+			// Ignore textures that have no image file attached to them (e.g. plain render targets)
+			if (source_path.empty())
+				continue;
 
-		struct _stat64 st {};
-		// Search for image file using the provided search paths unless the path provided is already absolute
-		if (!find_file(_texture_search_paths, source_path) || _wstati64(source_path.wstring().c_str(), &st) != 0)
+			struct _stat64 st {};
+			// Search for image file using the provided search paths unless the path provided is already absolute
+			if (!find_file(_texture_search_paths, source_path) || _wstati64(source_path.wstring().c_str(), &st) != 0)
+			{
+				LOG(ERROR) << "> Source " << source_path << " for texture '" << texture.unique_name << "' could not be found in any of the texture search paths.";
+				continue;
+			}
+
+			const std::string cache_key = source_path.u8string() + '|' + std::to_string(texture.width) + 'x' + std::to_string(texture.height) + 'x' + std::to_string(texture.levels) + '|' + std::to_string(static_cast<unsigned int>(texture.format));
+
+			// Skip decoding files that did not change since they were last loaded into a texture with the same description
+			if (const auto it = _texture_image_cache.find(cache_key);
+				it != _texture_image_cache.end() && it->second->modified_time == st.st_mtime)
+			{
+				// Remember that this texture uses the image too, so that it is not evicted from the cache while it is still in use
+				if (std::find(it->second->texture_names.begin(), it->second->texture_names.end(), texture.unique_name) == it->second->texture_names.end())
+					it->second->texture_names.push_back(texture.unique_name);
+
+				if (it->second->compressed)
+					upload_texture_compressed(texture, it->second->pixels.data());
+				else
+					upload_texture(texture, it->second->pixels.data());
+				continue;
+			}
+
+			// Textures with the same source file and description share a single task
+			auto task = std::find_if(_texture_load_tasks.begin(), _texture_load_tasks.end(),
+				[&cache_key](const std::unique_ptr<texture_load_task> &task) { return task->cache_key == cache_key; });
+			if (task == _texture_load_tasks.end())
+			{
+				task = _texture_load_tasks.insert(_texture_load_tasks.end(), std::make_unique<texture_load_task>());
+				(*task)->cache_key = cache_key;
+				(*task)->source_path = std::move(source_path);
+				(*task)->modified_time = st.st_mtime;
+				(*task)->width = texture.width;
+				(*task)->height = texture.height;
+				(*task)->levels = texture.levels;
+				(*task)->format = texture.format;
+			}
+
+			(*task)->texture_names.push_back(texture.unique_name);
+		}
+
+		if (_texture_load_tasks.empty())
 		{
-			LOG(ERROR) << "> Source " << source_path << " for texture '" << texture.unique_name << "' could not be found in any of the texture search paths.";
-			continue;
+			_textures_loaded = true;
+			return;
 		}
 
-		unsigned char *filedata = nullptr;
-		int width = 0, height = 0, channels = 0;
+		_texture_load_task_index = 0;
 
-		if (FILE *file; _wfopen_s(&file, source_path.wstring().c_str(), L"rb") == 0)
-		{
-			std::vector<uint8_t> filebuffer(static_cast<size_t>(st.st_size));
-			fread(filebuffer.data(), 1, filebuffer.size(), file);
-			fclose(file);
+		// Decode and resize the images on worker threads, so that large images do not stall rendering
+		const size_t num_threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), _texture_load_tasks.size());
+		for (size_t i = 0; i < num_threads; ++i)
+			_texture_load_threads.emplace_back([this]() {
+				SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
 
-			if (stbi_dds_test_memory(filebuffer.data(), filebuffer.size()))
-				filedata = stbi_dds_load_from_memory(filebuffer.data(), filebuffer.size(), &width, &height, &channels, STBI_rgb_alpha);
-			else
-				filedata = stbi_load_from_memory(filebuffer.data(), filebuffer.size(), &width, &height, &channels, STBI_rgb_alpha);
-		}
+				for (size_t index; !_texture_load_cancelled && (index = _texture_load_task_index++) < _texture_load_tasks.size();)
+				{
+					texture_load_task &task = *_texture_load_tasks[index];
+					if (!task.cancelled)
+						load_image_file(task);
+					task.finished = true;
+				}
+			});
+	}
+
+	// Upload the images that were decoded since the last frame
+	for (const std::unique_ptr<texture_load_task> &task : _texture_load_tasks)
+	{
+		if (task->consumed || !task->finished)
+			continue;
+
+		task->consumed = true;
 
-		if (filedata == nullptr)
+		// The textures may have been created again with a different description since loading started, so the image is only kept in the image cache
+		if (task->cancelled)
+			continue;
+
+		if (task->pixels.empty())
 		{
-			LOG(ERROR) << "> Source " << source_path << " for texture '" << texture.unique_name << "' could not be loaded! Make sure it is of a compatible file format.";
+			LOG(ERROR) << "> Source " << task->source_path << " for texture '" << task->texture_names.front() << "' could not be loaded! Make sure it is of a compatible file format.";
 			continue;
 		}
 
-		if (texture.width != uint32_t(width) || texture.height != uint32_t(height))
+		for (const std::string &texture_name : task->texture_names)
 		{
-			LOG(INFO) << "> Resizing image data for texture '" << texture.unique_name << "' from " << width << "x" << height << " to " << texture.width << "x" << texture.height << " ...";
-
-			std::vector<uint8_t> resized(texture.width * texture.height * 4);
-			stbir_resize_uint8(filedata, width, height, 0, resized.data(), texture.width, texture.height, 0, 4);
-			upload_texture(texture, resized.data());
+			// The texture may have been destroyed while the image was loaded (e.g. because its effect failed to compile)
+			if (const auto texture = std::find_if(_textures.begin(), _textures.end(),
+				[&texture_name](const auto &item) { return item.unique_name == texture_name; });
+				texture != _textures.end() && texture->impl != nullptr)
+			{
+				if (task->compressed)
+					upload_texture_compressed(*texture, task->pixels.data());
+				else
+					upload_texture(*texture, task->pixels.data());
+			}
 		}
-		else
+	}
+
+	// Every task is finished when it was consumed, so this does not have to wait for the worker threads
+	if (std::all_of(_texture_load_tasks.begin(), _texture_load_tasks.end(), [](const std::unique_ptr<texture_load_task> &task) { return task->consumed; }))
+	{
+		// Textures were created again while this batch was loading, so start another one for those (which picks up the images decoded so far from the cache)
+		const bool cancelled = std::any_of(_texture_load_tasks.begin(), _texture_load_tasks.end(), [](const std::unique_ptr<texture_load_task> &task) { return task->cancelled.load(); });
+
+		finish_texture_load_tasks();
+
+		if (cancelled)
+			return;
+
+		// Drop images from the cache that are no longer used by any texture, so that the cache does not grow with every change to the loaded effects
+		for (auto it = _texture_image_cache.begin(); it != _texture_image_cache.end();)
 		{
-			upload_texture(texture, filedata);
+			if (std::none_of(it->second->texture_names.begin(), it->second->texture_names.end(),
+				[this](const std::string &texture_name) { return std::find_if(_textures.begin(), _textures.end(), [&texture_name](const auto &item) { return item.unique_name == texture_name; }) != _textures.end(); }))
+				it = _texture_image_cache.erase(it);
+			else
+				++it;
 		}
 
-		stbi_image_free(filedata);
+		_textures_loaded = true;
 	}
-
-	_textures_loaded = true;
 }
 
 void reshade::runtime::unload_effect(size_t id)
 {
+	// The effect may be loaded again with different code, so discard the code that was compiled for it (and skip compiling it if a worker thread did not get to it yet)
+	for (const std::unique_ptr<effect_compile_task> &task : _compile_tasks)
+	{
+		if (task->effect_index == id)
+		{
+			task->consumed = true;
+			task->cancelled = true;
+		}
+	}
+
+	// Techniques are enabled again after the effect was loaded, which queues it for compilation again if it loaded successfully
+	_reload_compile_queue.erase(std::remove(_reload_compile_queue.begin(), _reload_compile_queue.end(), id), _reload_compile_queue.end());
+
 	_uniforms.erase(std::remove_if(_uniforms.begin(), _uniforms.end(),
 		[id](const auto &it) { return it.effect_index == id; }), _uniforms.end());
+	// Textures shared with other effects are still referenced by those, so keep them (the effect picks them up again by name when it is initialized again)
 	_textures.erase(std::remove_if(_textures.begin(), _textures.end(),
-		[id](const auto &it) { return it.effect_index == id; }), _textures.end());
+		[id](const auto &it) { return it.effect_index == id && !it.shared; }), _textures.end());
 	_techniques.erase(std::remove_if(_techniques.begin(), _techniques.end(),
 		[id](const auto &it) { return it.effect_index == id; }), _techniques.end());
 
 	_loaded_effects[id].source_file.clear();
 
+	build_special_uniform_updates();
+
 #if RESHADE_GUI
 	// Remove all texture preview windows since some may no longer be valid
 	_texture_previews.clear();
 #endif
 }
+void reshade::runtime::build_special_uniform_updates()
+{
+	_special_uniform_updates.clear();
+
+	// Parse the annotations here once, instead of looking them up by name for every variable every frame
+	for (size_t uniform_index = 0; uniform_index < _uniforms.size(); ++uniform_index)
+	{
+		const uniform &variable = _uniforms[uniform_index];
+		if (variable.special == special_uniform::none)
+			continue;
+
+		special_uniform_update update;
+		update.uniform_index = uniform_index;
+		update.source = variable.special;
+
+		switch (variable.special)
+		{
+		case special_uniform::random:
+			update.random_min = variable.annotation_as_int("min");
+			update.random_max = variable.annotation_as_int("max");
+			break;
+		case special_uniform::ping_pong:
+			update.min = variable.annotation_as_float("min");
+			update.max = variable.annotation_as_float("max");
+			update.step_min = variable.annotation_as_float("step", 0);
+			update.step_max = variable.annotation_as_float("step", 1);
+			update.smoothing = variable.annotation_as_float("smoothing");
+			break;
+		case special_uniform::key:
+		case special_uniform::mouse_button:
+			update.keycode = variable.annotation_as_int("keycode");
+			// Variables with an invalid key or button are never updated
+			if (variable.special == special_uniform::key ? (update.keycode <= 7 || update.keycode >= 256) : (update.keycode < 0 || update.keycode >= 5))
+				continue;
+			if (const std::string_view mode = variable.annotation_as_string("mode");
+				mode == "toggle" || variable.annotation_as_int("toggle"))
+				update.mode = 2;
+			else if (mode == "press")
+				update.mode = 1;
+			break;
+		}
+
+		_special_uniform_updates.push_back(update);
+	}
+}
 void reshade::runtime::unload_effects()
 {
-	// Make sure no threads are still accessing effect data
+	// Stop loading effects that were not started yet and make sure no threads are still accessing effect data
+	_reload_cancelled = true;
 	for (std::thread &thread : _worker_threads)
 		thread.join();
 	_worker_threads.clear();
+	_reload_queue.clear();
+
+	// Discard compiled code that was not used yet, since it belongs to the effects unloaded below
+	finish_compile_tasks();
+	_reload_compile_queue.clear();
+
+	// Stop loading images into the textures unloaded below (decoded images are kept in the cache across reloads)
+	finish_texture_load_tasks();
+
+	// All effects are unloaded below anyway, so finish a reload that was cancelled as if the remaining effects were loaded
+	if (_reload_remaining_effects != std::numeric_limits<size_t>::max())
+		_reload_remaining_effects = 0;
 
 	_uniforms.clear();
+	_special_uniform_updates.clear();
 	_textures.clear();
 	_techniques.clear();
 
 	_loaded_effects.clear();
 	_uniform_data_storage.clear();
+	_uniform_storage_modified.clear();
 
 	_textures_loaded = false;
 
@@ -567,6 +1060,32 @@ void reshade::runtime::unload_effects()
 	_texture_previews.clear();
 #endif
 }
+void reshade::runtime::finish_compile_tasks()
+{
+	// Only wait for the tasks that are already being worked on
+	for (const std::unique_ptr<effect_compile_task> &task : _compile_tasks)
+		task->cancelled = true;
+
+	for (std::thread &thread : _compile_threads)
+		thread.join();
+	_compile_threads.clear();
+	_compile_tasks.clear();
+}
+void reshade::runtime::finish_texture_load_tasks()
+{
+	_texture_load_cancelled = true;
+	for (std::thread &thread : _texture_load_threads)
+		thread.join();
+	_texture_load_threads.clear();
+	_texture_load_cancelled = false;
+
+	// Keep the loaded images (including those not uploaded yet), so that loading them again is fast
+	for (std::unique_ptr<texture_load_task> &task : _texture_load_tasks)
+		if (task->finished && !task->pixels.empty())
+			_texture_image_cache[task->cache_key] = std::move(task);
+
+	_texture_load_tasks.clear();
+}
 
 void reshade::runtime::update_and_render_effects()
 {
@@ -576,9 +1095,41 @@ void reshade::runtime::update_and_render_effects()
 
 	if (_reload_remaining_effects == 0)
 	{
-		// Finished loading effects, so apply preset to figure out which ones need compiling
+		// Finished loading effects, so add their variables, textures and techniques (in effect order, so that the result does not depend on the order loading finished in)
+		if (!_reload_queue.empty())
+		{
+			std::sort(_reload_queue.begin(), _reload_queue.end(),
+				[](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+
+			size_t num_uniforms = 0, num_textures = 0, num_techniques = 0, storage_size = 0;
+			for (const auto &entry : _reload_queue)
+			{
+				const effect_data &effect = _loaded_effects[entry.first];
+				num_uniforms += effect.module.uniforms.size();
+				num_textures += effect.module.textures.size();
+				num_techniques += effect.module.techniques.size();
+				storage_size += (effect.module.total_uniform_size + 15) & ~15;
+			}
+
+			_uniforms.reserve(_uniforms.size() + num_uniforms);
+			_textures.reserve(_textures.size() + num_textures);
+			_techniques.reserve(_techniques.size() + num_techniques);
+			_uniform_data_storage.reserve(_uniform_data_storage.size() + storage_size);
+
+			for (const auto &entry : _reload_queue)
+				init_effect(entry.first);
+
+			build_special_uniform_updates();
+
+			_reload_queue.clear();
+		}
+
+		// Apply preset to figure out which effects need compiling
 		load_current_preset();
 
+		if (_lazy_effect_compilation && _warm_up_preset_effects)
+			warm_up_preset_effects();
+
 		_last_reload_time = std::chrono::high_resolution_clock::now();
 		_reload_total_effects = 0;
 		_reload_remaining_effects = std::numeric_limits<size_t>::max();
@@ -591,57 +1142,132 @@ void reshade::runtime::update_and_render_effects()
 	{
 		if (!_reload_compile_queue.empty())
 		{
-			// Pop an effect from the queue
-			size_t effect_index = _reload_compile_queue.back();
-			_reload_compile_queue.pop_back();
+			// Compile the code of all queued effects on worker threads (once the previous batch is done), so that only creating back-end objects is left to do on this thread
+			if (_compile_tasks.empty())
+			{
+				// Compiling creates new textures, which need images loaded again afterwards anyway, so skip the images that were not started yet
+				// This does not wait for the images that are decoded right now, their results still end up in the image cache once 'load_textures' handled the rest of the batch
+				for (const std::unique_ptr<texture_load_task> &task : _texture_load_tasks)
+					task->cancelled = true;
+
+				// Effects that failed to load have nothing to compile
+				_reload_compile_queue.erase(std::remove_if(_reload_compile_queue.begin(), _reload_compile_queue.end(),
+					[this](size_t effect_index) { return !_loaded_effects[effect_index].compile_sucess; }), _reload_compile_queue.end());
+
+				for (const size_t effect_index : _reload_compile_queue)
+				{
+					effect_compile_task &task = *_compile_tasks.emplace_back(std::make_unique<effect_compile_task>());
+					task.effect_index = effect_index;
+					task.effect = _loaded_effects[effect_index];
+					task.effect.errors.clear();
+				}
 
-			effect_data &effect = _loaded_effects[effect_index];
+				_compile_task_index = 0;
+
+				const size_t num_threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), _compile_tasks.size());
+				for (size_t i = 0; i < num_threads; ++i)
+					_compile_threads.emplace_back([this]() {
+						SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+						for (size_t index; (index = _compile_task_index++) < _compile_tasks.size();)
+						{
+							effect_compile_task &task = *_compile_tasks[index];
+							if (!task.cancelled)
+							{
+								if (task.effect.recording != nullptr)
+									generate_effect_code(task.effect);
+								task.success = compile_effect_code(task.effect);
+							}
+							task.finished = true;
+						}
+					});
+			}
 
-			// Create textures now, since they are referenced when building samplers in the 'compile_effect' call below
-			bool success = true;
-			for (texture &texture : _textures)
-				if (texture.impl == nullptr && (texture.effect_index == effect_index || texture.shared))
-					success &= init_texture(texture);
+			// Finish effects whose code was compiled, until the time budget for this frame is used up (but always at least one, so that loading makes progress)
+			const auto activation_start = std::chrono::high_resolution_clock::now();
 
-			// Compile the effect with the back-end implementation
-			if (success && !compile_effect(effect))
+			for (const std::unique_ptr<effect_compile_task> &task : _compile_tasks)
 			{
-				success = false;
+				if (task->consumed || !task->finished)
+					continue;
+
+				task->consumed = true;
+
+				const size_t effect_index = task->effect_index;
+				effect_data &effect = _loaded_effects[effect_index];
+
+				// The effect was specialized again while its code was compiled, so keep it queued for the next batch
+				if (task->effect.preamble != effect.preamble)
+					continue;
+
+				_reload_compile_queue.erase(std::find(_reload_compile_queue.begin(), _reload_compile_queue.end(), effect_index));
+
+				// Only the description of the effect was loaded so far, so switch over to the generated code
+				if (effect.recording != nullptr)
+					init_effect_code(effect_index, std::move(task->effect.module));
+
+				effect.errors += task->effect.errors;
+				effect.compiled_entry_points = std::move(task->effect.compiled_entry_points);
 
-				// De-duplicate error lines (D3DCompiler sometimes repeats the same error multiple times)
-				for (size_t cur_line_offset = 0, next_line_offset, end_offset;
-					(next_line_offset = effect.errors.find('\n', cur_line_offset)) != std::string::npos && (end_offset = effect.errors.find('\n', next_line_offset + 1)) != std::string::npos; cur_line_offset = next_line_offset + 1)
+				// Create textures now, since they are referenced when building samplers in the 'compile_effect' call below
+				bool success = true;
+				for (texture &texture : _textures)
+					if (texture.impl == nullptr && (texture.effect_index == effect_index || texture.shared))
+						success &= init_texture(texture);
+
+				// Create the back-end objects for the effect from the compiled code
+				if (success && (!task->success || !compile_effect(effect)))
 				{
-					const std::string_view cur_line(effect.errors.c_str() + cur_line_offset, next_line_offset - cur_line_offset);
-					const std::string_view next_line(effect.errors.c_str() + next_line_offset + 1, end_offset - next_line_offset - 1);
+					success = false;
 
-					if (cur_line == next_line)
+					// De-duplicate error lines (D3DCompiler sometimes repeats the same error multiple times)
+					for (size_t cur_line_offset = 0, next_line_offset, end_offset;
+						(next_line_offset = effect.errors.find('\n', cur_line_offset)) != std::string::npos && (end_offset = effect.errors.find('\n', next_line_offset + 1)) != std::string::npos; cur_line_offset = next_line_offset + 1)
 					{
-						effect.errors.erase(next_line_offset, end_offset - next_line_offset);
-						next_line_offset = cur_line_offset - 1;
+						const std::string_view cur_line(effect.errors.c_str() + cur_line_offset, next_line_offset - cur_line_offset);
+						const std::string_view next_line(effect.errors.c_str() + next_line_offset + 1, end_offset - next_line_offset - 1);
+
+						if (cur_line == next_line)
+						{
+							effect.errors.erase(next_line_offset, end_offset - next_line_offset);
+							next_line_offset = cur_line_offset - 1;
+						}
 					}
+
+					LOG(ERROR) << "Failed to compile " << effect.source_file << ":\n" << effect.errors;
 				}
 
-				LOG(ERROR) << "Failed to compile " << effect.source_file << ":\n" << effect.errors;
-			}
+				effect.compiled_entry_points.clear();
 
-			if (!success)
-			{
-				// Destroy all textures belonging to this effect
-				for (texture &texture : _textures)
-					if (texture.effect_index == effect_index && !texture.shared)
-						texture.impl.reset();
-				// Disable all techniques belonging to this effect
-				for (technique &technique : _techniques)
-					if (technique.effect_index == effect_index)
-						disable_technique(technique);
-
-				effect.compile_sucess = false;
-				_last_reload_successful = false;
+				// Not every back-end fills the buffers it created with the current values, so upload everything before the effect is rendered first
+				if (success)
+					mark_uniform_storage_modified(effect_index, effect.storage_offset, effect.storage_size);
+
+				if (!success)
+				{
+					// Destroy all textures belonging to this effect
+					for (texture &texture : _textures)
+						if (texture.effect_index == effect_index && !texture.shared)
+							texture.impl.reset();
+					// Disable all techniques belonging to this effect
+					for (technique &technique : _techniques)
+						if (technique.effect_index == effect_index)
+							disable_technique(technique);
+
+					effect.compile_sucess = false;
+					_last_reload_successful = false;
+				}
+
+				// An effect has changed, need to reload textures
+				_textures_loaded = false;
+
+				if (std::chrono::high_resolution_clock::now() - activation_start >= std::chrono::milliseconds(_effect_activation_budget))
+					break;
 			}
 
-			// An effect has changed, need to reload textures
-			_textures_loaded = false;
+			// Wait for the worker threads to exit once every effect of this batch was handled (tasks that were discarded may still be compiled, so also wait for them to finish, to never block this thread on a worker)
+			if (std::all_of(_compile_tasks.begin(), _compile_tasks.end(), [](const std::unique_ptr<effect_compile_task> &task) { return task->consumed && task->finished; }))
+				finish_compile_tasks();
 		}
 		else if (!_textures_loaded)
 		{
@@ -658,9 +1284,11 @@ void reshade::runtime::update_and_render_effects()
 		return;
 
 	// Update special uniform variables
-	for (uniform &variable : _uniforms)
+	for (const special_uniform_update &update : _special_uniform_updates)
 	{
-		switch (variable.special)
+		uniform &variable = _uniforms[update.uniform_index];
+
+		switch (update.source)
 		{
 		case special_uniform::frame_time:
 			set_uniform_value(variable, _last_frame_duration.count() * 1e-6f, 0.0f, 0.0f, 0.0f);
@@ -671,36 +1299,29 @@ void reshade::runtime::update_and_render_effects()
 			else
 				set_uniform_value(variable, static_cast<unsigned int>(_framecount % UINT_MAX));
 			break;
-		case special_uniform::random: {
-			const int min = variable.annotation_as_int("min");
-			const int max = variable.annotation_as_int("max");
-			set_uniform_value(variable, min + (std::rand() % (max - min + 1)));
-			break; }
+		case special_uniform::random:
+			set_uniform_value(variable, update.random_min + (std::rand() % (update.random_max - update.random_min + 1)));
+			break;
 		case special_uniform::ping_pong: {
-			const float min = variable.annotation_as_float("min");
-			const float max = variable.annotation_as_float("max");
-			const float step_min = variable.annotation_as_float("step", 0);
-			const float step_max = variable.annotation_as_float("step", 1);
-			float increment = step_max == 0 ? step_min : (step_min + std::fmodf(static_cast<float>(std::rand()), step_max - step_min + 1));
-			const float smoothing = variable.annotation_as_float("smoothing");
+			float increment = update.step_max == 0 ? update.step_min : (update.step_min + std::fmodf(static_cast<float>(std::rand()), update.step_max - update.step_min + 1));
 
 			float value[2] = { 0, 0 };
 			get_uniform_value(variable, value, 2);
 			if (value[1] >= 0)
 			{
-				increment = std::max(increment - std::max(0.0f, smoothing - (max - value[0])), 0.05f);
+				increment = std::max(increment - std::max(0.0f, update.smoothing - (update.max - value[0])), 0.05f);
 				increment *= _last_frame_duration.count() * 1e-9f;
 
-				if ((value[0] += increment) >= max)
-					value[0] = max, value[1] = -1;
+				if ((value[0] += increment) >= update.max)
+					value[0] = update.max, value[1] = -1;
 			}
 			else
 			{
-				increment = std::max(increment - std::max(0.0f, smoothing - (value[0] - min)), 0.05f);
+				increment = std::max(increment - std::max(0.0f, update.smoothing - (value[0] - update.min)), 0.05f);
 				increment *= _last_frame_duration.count() * 1e-9f;
 
-				if ((value[0] -= increment) <= min)
-					value[0] = min, value[1] = +1;
+				if ((value[0] -= increment) <= update.min)
+					value[0] = update.min, value[1] = +1;
 			}
 			set_uniform_value(variable, value, 2);
 			break; }
@@ -711,18 +1332,15 @@ void reshade::runtime::update_and_render_effects()
 			set_uniform_value(variable, std::chrono::duration_cast<std::chrono::nanoseconds>(_last_present_time - _start_time).count() * 1e-6f);
 			break;
 		case special_uniform::key:
-			if (const int keycode = variable.annotation_as_int("keycode");
-				keycode > 7 && keycode < 256)
-				if (const std::string_view mode = variable.annotation_as_string("mode");
-					mode == "toggle" || variable.annotation_as_int("toggle")) {
-					bool current_value = false;
-					get_uniform_value(variable, &current_value, 1);
-					if (_input->is_key_pressed(keycode))
-						set_uniform_value(variable, !current_value);
-				} else if (mode == "press")
-					set_uniform_value(variable, _input->is_key_pressed(keycode));
-				else
-					set_uniform_value(variable, _input->is_key_down(keycode));
+			if (update.mode == 2) {
+				bool current_value = false;
+				get_uniform_value(variable, &current_value, 1);
+				if (_input->is_key_pressed(update.keycode))
+					set_uniform_value(variable, !current_value);
+			} else if (update.mode == 1)
+				set_uniform_value(variable, _input->is_key_pressed(update.keycode));
+			else
+				set_uniform_value(variable, _input->is_key_down(update.keycode));
 			break;
 		case special_uniform::mouse_point:
 			set_uniform_value(variable, _input->mouse_position_x(), _input->mouse_position_y());
@@ -731,18 +1349,15 @@ void reshade::runtime::update_and_render_effects()
 			set_uniform_value(variable, _input->mouse_movement_delta_x(), _input->mouse_movement_delta_y());
 			break;
 		case special_uniform::mouse_button:
-			if (const int keycode = variable.annotation_as_int("keycode");
-				keycode >= 0 && keycode < 5)
-				if (const std::string_view mode = variable.annotation_as_string("mode");
-					mode == "toggle" || variable.annotation_as_int("toggle")) {
-					bool current_value = false;
-					get_uniform_value(variable, &current_value, 1);
-					if (_input->is_mouse_button_pressed(keycode))
-						set_uniform_value(variable, !current_value);
-				} else if (mode == "press")
-					set_uniform_value(variable, _input->is_mouse_button_pressed(keycode));
-				else
-					set_uniform_value(variable, _input->is_mouse_button_down(keycode));
+			if (update.mode == 2) {
+				bool current_value = false;
+				get_uniform_value(variable, &current_value, 1);
+				if (_input->is_mouse_button_pressed(update.keycode))
+					set_uniform_value(variable, !current_value);
+			} else if (update.mode == 1)
+				set_uniform_value(variable, _input->is_mouse_button_pressed(update.keycode));
+			else
+				set_uniform_value(variable, _input->is_mouse_button_down(update.keycode));
 			break;
 		}
 	}
@@ -842,6 +1457,9 @@ void reshade::runtime::load_config()
 	config.get("GENERAL", "ScreenshotFormat", _screenshot_format);
 	config.get("GENERAL", "ScreenshotIncludePreset", _screenshot_include_preset);
 	config.get("GENERAL", "NoReloadOnInit", _no_reload_on_init);
+	config.get("GENERAL", "EffectActivationBudget", _effect_activation_budget);
+	config.get("GENERAL", "LazyEffectCompilation", _lazy_effect_compilation);
+	config.get("GENERAL", "WarmUpPresetEffects", _warm_up_preset_effects);
 
 	// Look for new preset files in the preset search paths
 	for (const auto &preset_file : find_files(_preset_search_paths, { ".ini", ".txt" }))
@@ -889,6 +1507,9 @@ void reshade::runtime::save_config(const std::filesystem::path &path) const
 	config.set("GENERAL", "ScreenshotFormat", _screenshot_format);
 	config.set("GENERAL", "ScreenshotIncludePreset", _screenshot_include_preset);
 	config.set("GENERAL", "NoReloadOnInit", _no_reload_on_init);
+	config.set("GENERAL", "EffectActivationBudget", _effect_activation_budget);
+	config.set("GENERAL", "LazyEffectCompilation", _lazy_effect_compilation);
+	config.set("GENERAL", "WarmUpPresetEffects", _warm_up_preset_effects);
 
 	for (const auto &callback : _save_config_callables)
 		callback(config);
@@ -905,14 +1526,56 @@ void reshade::runtime::load_preset(const std::filesystem::path &path)
 	std::vector<std::string> preset_preprocessor_definitions;
 	preset.get("", "PreprocessorDefinitions", preset_preprocessor_definitions);
 
-	// Recompile effects if preprocessor definitions have changed or running in performance mode (in which case all preset values are compile-time constants)
+	// Recompile effects if preprocessor definitions have changed
 	if (_reload_remaining_effects != 0 && // ... unless this is the 'load_current_preset' call in 'update_and_render_effects'
-		(_performance_mode || preset_preprocessor_definitions != _preset_preprocessor_definitions))
+		preset_preprocessor_definitions != _preset_preprocessor_definitions)
 	{
 		assert(!_preset_files.empty() && path == _preset_files[_current_preset]);
 		_preset_preprocessor_definitions = preset_preprocessor_definitions;
-		load_effects();
-		return; // Preset values are loaded in 'update_and_render_effects' during effect loading
+
+		if (_reload_remaining_effects != std::numeric_limits<size_t>::max())
+		{
+			load_effects(); // Effects are still being loaded with the old definitions, so start over
+			return;
+		}
+
+		// Only load those effects again that reference a macro whose definition changed, all others stay as they are
+		const std::vector<std::pair<std::string, std::string>> macros = build_macro_definitions();
+
+		for (const effect_data &effect : _loaded_effects)
+			if (!effect.source_file.empty() && !used_macros_unchanged(effect.used_macros, macros))
+				_reload_queue.emplace_back(effect.index, effect.source_file);
+
+		if (!_reload_queue.empty())
+		{
+			LOG(INFO) << "Reloading " << _reload_queue.size() << " effect(s) affected by the preprocessor definitions of " << path << " ...";
+
+			for (const auto &entry : _reload_queue)
+				unload_effect(entry.first);
+
+			start_loading_effects();
+			return; // Preset values are loaded in 'update_and_render_effects' during effect loading
+		}
+	}
+
+	// All preset values are compile-time constants in performance mode, so re-specialize effects whose values changed
+	if (_performance_mode)
+	{
+		for (effect_data &effect : _loaded_effects)
+		{
+			if (!effect.compile_sucess || !update_effect_spec_constants(effect, preset))
+				continue;
+
+			// Destroy the compiled techniques, so that they are queued for compilation again with the new preamble when enabled below
+			for (technique &technique : _techniques)
+			{
+				if (technique.effect_index != effect.index)
+					continue;
+
+				technique.impl.reset();
+				technique.passes_data.clear();
+			}
+		}
 	}
 
 	// Reorder techniques
@@ -953,7 +1616,7 @@ void reshade::runtime::load_preset(const std::filesystem::path &path)
 	for (technique &technique : _techniques)
 	{
 		// Ignore preset if "enabled" annotation is set
-		if (technique.annotation_as_int("enabled")
+		if (technique.force_enabled
 			|| std::find(technique_list.begin(), technique_list.end(), technique.name) != technique_list.end())
 			enable_technique(technique);
 		else
@@ -969,6 +1632,40 @@ void reshade::runtime::load_current_preset()
 	if (_current_preset < _preset_files.size())
 		load_preset(_preset_files[_current_preset]);
 }
+void reshade::runtime::warm_up_preset_effects()
+{
+	std::vector<std::string> technique_list;
+
+	for (size_t preset_index = 0; preset_index < _preset_files.size(); ++preset_index)
+	{
+		if (preset_index == _current_preset)
+			continue;
+
+		const ini_file preset(_preset_files[preset_index]);
+
+		// Switching to a preset with different preprocessor definitions reloads all effects anyway
+		std::vector<std::string> preset_preprocessor_definitions;
+		preset.get("", "PreprocessorDefinitions", preset_preprocessor_definitions);
+		if (preset_preprocessor_definitions != _preset_preprocessor_definitions)
+			continue;
+
+		std::vector<std::string> preset_technique_list;
+		preset.get("", "Techniques", preset_technique_list);
+		technique_list.insert(technique_list.end(), preset_technique_list.begin(), preset_technique_list.end());
+	}
+
+	// Queue after the effects of the current preset, so that those are still activated first
+	for (const technique &technique : _techniques)
+	{
+		if (technique.impl != nullptr || !_loaded_effects[technique.effect_index].compile_sucess ||
+			std::find(technique_list.begin(), technique_list.end(), technique.name) == technique_list.end() ||
+			std::find(_reload_compile_queue.begin(), _reload_compile_queue.end(), technique.effect_index) != _reload_compile_queue.end())
+			continue;
+
+		_reload_total_effects++;
+		_reload_compile_queue.push_back(technique.effect_index);
+	}
+}
 void reshade::runtime::save_preset(const std::filesystem::path &path) const
 {
 	ini_file preset(path);
@@ -1157,7 +1854,13 @@ void reshade::runtime::set_uniform_value(uniform &variable, const uint8_t *data,
 
 	assert(variable.storage_offset + size <= _uniform_data_storage.size());
 
+	// Special variables are set every frame, but often to the same value (e.g. key states), which does not need another upload
+	if (std::memcmp(&_uniform_data_storage[variable.storage_offset], data, size) == 0)
+		return;
+
 	std::memcpy(&_uniform_data_storage[variable.storage_offset], data, size);
+
+	mark_uniform_storage_modified(variable.effect_index, variable.storage_offset, size);
 }
 void reshade::runtime::set_uniform_value(uniform &variable, const bool *values, size_t count)
 {
@@ -1226,6 +1929,8 @@ void reshade::runtime::set_uniform_value(uniform &variable, const float *values,
 
 void reshade::runtime::reset_uniform_value(uniform &variable)
 {
+	mark_uniform_storage_modified(variable.effect_index, variable.storage_offset, variable.size);
+
 	if (!variable.has_initializer_value)
 	{
 		memset(_uniform_data_storage.data() + variable.storage_offset, 0, variable.size);
@@ -1256,3 +1961,25 @@ void reshade::runtime::reset_uniform_value(uniform &variable)
 		}
 	}
 }
+
+void reshade::runtime::mark_uniform_storage_modified(size_t effect_index, size_t offset, size_t size)
+{
+	if (effect_index >= _uniform_storage_modified.size() || size == 0)
+		return;
+
+	// Keep a single range per effect, since uploading a few unchanged bytes in between is cheaper than uploading many small ranges separately
+	auto &modified = _uniform_storage_modified[effect_index];
+	if (modified.first < modified.second)
+		modified = { std::min(modified.first, offset), std::max(modified.second, offset + size) };
+	else
+		modified = { offset, offset + size };
+}
+std::pair<size_t, size_t> reshade::runtime::get_modified_uniform_storage(size_t effect_index, size_t offset, size_t size) const
+{
+	const auto &modified = _uniform_storage_modified[effect_index];
+
+	const size_t begin = std::max(modified.first, offset);
+	const size_t end = std::min(modified.second, offset + size);
+
+	return begin < end ? std::make_pair(begin, end - begin) : std::make_pair(offset, size_t(0));
+}
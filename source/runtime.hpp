@@ -9,7 +9,10 @@
 #include <memory>
 #include <atomic>
 #include <chrono>
+#include <vector>
+#include <algorithm>
 #include <functional>
+#include <unordered_map>
 #include <filesystem>
 
 #if RESHADE_GUI
@@ -19,6 +22,11 @@ struct ImDrawData;
 struct ImGuiContext;
 #endif
 
+namespace reshadefx
+{
+	struct module;
+}
+
 namespace reshade
 {
 	class ini_file; // Some forward declarations to keep number of includes small
@@ -26,6 +34,51 @@ namespace reshade
 	struct texture;
 	struct technique;
 	struct effect_data;
+	struct special_uniform_update;
+
+	/// <summary>
+	/// An entry in one of the shader caches of a back-end, together with the IDs of all effects that currently use it.
+	/// </summary>
+	template <typename T>
+	struct effect_shader_cache_entry
+	{
+		T value;
+		std::vector<size_t> effect_indices;
+
+		void add_effect(size_t effect_index)
+		{
+			if (std::find(effect_indices.begin(), effect_indices.end(), effect_index) == effect_indices.end())
+				effect_indices.push_back(effect_index);
+		}
+	};
+
+	/// <summary>
+	/// Remove an effect from all entries of a shader cache except those it still uses, and erase the entries no effect uses anymore.
+	/// </summary>
+	/// <param name="cache">The shader cache to update.</param>
+	/// <param name="effect_index">The ID of the effect.</param>
+	/// <param name="used_keys">Keys of the entries the effect still uses.</param>
+	/// <param name="release">Function called with the value of every entry that is erased.</param>
+	template <typename T, typename F>
+	void release_effect_shader_cache_entries(std::unordered_map<std::string, effect_shader_cache_entry<T>> &cache, size_t effect_index, const std::vector<const std::string *> &used_keys, F release)
+	{
+		for (auto it = cache.begin(); it != cache.end();)
+		{
+			std::vector<size_t> &effect_indices = it->second.effect_indices;
+			if (std::find(used_keys.begin(), used_keys.end(), &it->first) == used_keys.end())
+				effect_indices.erase(std::remove(effect_indices.begin(), effect_indices.end(), effect_index), effect_indices.end());
+
+			if (effect_indices.empty())
+			{
+				release(it->second.value);
+				it = cache.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
 
 	/// <summary>
 	/// Platform independent base class for the main ReShade runtime.
@@ -65,6 +118,12 @@ namespace reshade
 		/// <param name="texture">The texture to update.</param>
 		/// <param name="pixels">The 32bpp RGBA image data to update the texture with.</param>
 		virtual void upload_texture(texture &texture, const uint8_t *pixels) = 0;
+		/// <summary>
+		/// Upload block-compressed image data in the format of a texture as is, e.g. from a DDS file.
+		/// </summary>
+		/// <param name="texture">The texture to update.</param>
+		/// <param name="data">The data of all mipmap levels of the texture, one after another, with tightly packed rows of blocks.</param>
+		virtual void upload_texture_compressed(texture &texture, const uint8_t *data) = 0;
 
 		/// <summary>
 		/// Get the value of a uniform variable.
@@ -139,20 +198,50 @@ namespace reshade
 		/// </summary>
 		virtual void load_effects();
 		/// <summary>
+		/// Unload the specified effect, so that it can be loaded again into the same ID.
+		/// Textures shared with other effects are kept, and so is the space of the effect in the uniform storage area, which is reused when it is initialized again.
+		/// </summary>
+		/// <param name="id">The ID of the effect.</param>
+		virtual void unload_effect(size_t id);
+		/// <summary>
 		/// Unload all effects currently loaded.
 		/// </summary>
 		virtual void unload_effects();
 		/// <summary>
 		/// Load image files and update textures with image data.
+		/// The files are decoded on worker threads, so this has to be called again every frame until <see cref="_textures_loaded"/> is set, uploading the images that finished meanwhile.
 		/// </summary>
 		void load_textures();
 
+		/// <summary>
+		/// Compile the generated code of an effect to the byte code of the back-end and store it in <see cref="effect_data::compiled_entry_points"/>.
+		/// This is called on a worker thread before <see cref="compile_effect"/>, so it must not access the device or anything else used on the render thread.
+		/// Back-ends that cannot compile code without the device do all the work in <see cref="compile_effect"/> instead.
+		/// </summary>
+		virtual bool compile_effect_code(effect_data &) { return true; }
 		/// <summary>
 		/// Compile effect from the specified effect module.
 		/// </summary>
 		/// <param name="effect">The effect module to compile.</param>
 		virtual bool compile_effect(effect_data &effect) = 0;
 
+		/// <summary>
+		/// Mark a range of the uniform storage area as modified, so that the back-end uploads it before the effect it belongs to is rendered next.
+		/// </summary>
+		/// <param name="effect_index">The ID of the effect the range belongs to.</param>
+		/// <param name="offset">Offset of the range in the storage area.</param>
+		/// <param name="size">Size of the range in bytes.</param>
+		void mark_uniform_storage_modified(size_t effect_index, size_t offset, size_t size);
+		/// <summary>
+		/// Get the part of a range in the uniform storage area that was modified since the back-end last uploaded the uniform data of the effect.
+		/// Back-ends reset the modified range of the effect after uploading, so that other techniques of the same effect do not upload it again.
+		/// </summary>
+		/// <param name="effect_index">The ID of the effect the range belongs to.</param>
+		/// <param name="offset">Offset of the range (e.g. of a uniform buffer) in the storage area.</param>
+		/// <param name="size">Size of the range in bytes.</param>
+		/// <returns>Offset and size of the modified part, with a size of zero if nothing in the range was modified.</returns>
+		std::pair<size_t, size_t> get_modified_uniform_storage(size_t effect_index, size_t offset, size_t size) const;
+
 		/// <summary>
 		/// Apply post-processing effects to the frame.
 		/// </summary>
@@ -172,6 +261,7 @@ namespace reshade
 
 		bool _is_initialized = false;
 		bool _has_high_network_activity = false;
+		bool _split_uniform_buffers = false; // Set by runtimes that bind uniform variables updated every frame in a separate buffer
 		unsigned int _width = 0;
 		unsigned int _height = 0;
 		unsigned int _window_width = 0;
@@ -186,6 +276,8 @@ namespace reshade
 		std::vector<uniform> _uniforms;
 		std::vector<technique> _techniques;
 		std::vector<unsigned char> _uniform_data_storage;
+		std::vector<special_uniform_update> _special_uniform_updates;
+		std::vector<std::pair<size_t, size_t>> _uniform_storage_modified; // Range of bytes in the storage area of each effect that changed since it was last uploaded (empty if the begin is not less than the end)
 
 	private:
 		/// <summary>
@@ -196,16 +288,61 @@ namespace reshade
 		static bool check_for_update(unsigned long latest_version[3]);
 
 		/// <summary>
-		/// Compile effect from the specified source file and initialize textures, uniforms and techniques.
+		/// Compile effect from the specified source file into the effect slot with the specified ID.
+		/// This only accesses that slot, so it can be called for different effects on multiple threads at once.
 		/// </summary>
 		/// <param name="path">The path to an effect source code file.</param>
-		/// <param name="out_id">The ID of the effect.</param>
-		void load_effect(const std::filesystem::path &path, size_t &out_id);
+		/// <param name="index">The ID of the effect.</param>
+		void load_effect(const std::filesystem::path &path, size_t index);
 		/// <summary>
-		/// Unload the specified effect.
+		/// Load all effects in the reload queue on worker threads.
 		/// </summary>
-		/// <param name="id">The ID of the effect.</param>
-		void unload_effect(size_t id);
+		void start_loading_effects();
+		/// <summary>
+		/// Build the list of macros effects are compiled with, from the built-in, global and current preset preprocessor definitions.
+		/// </summary>
+		std::vector<std::pair<std::string, std::string>> build_macro_definitions() const;
+		/// <summary>
+		/// Initialize textures, uniforms and techniques of an effect that was loaded with <see cref="load_effect"/>.
+		/// </summary>
+		/// <param name="index">The ID of the effect.</param>
+		void init_effect(size_t index);
+		/// <summary>
+		/// Generate the code of an effect whose code generation was deferred by <see cref="load_effect"/>, by replaying the parsed effect into the back-end.
+		/// This only accesses the specified effect, so it can be called on a worker thread with a copy of the effect.
+		/// </summary>
+		/// <param name="effect">The effect to generate code for.</param>
+		void generate_effect_code(effect_data &effect) const;
+		/// <summary>
+		/// Take over the generated code of an effect that was initialized with only its description, and move its uniform variables to the buffer layout of the back-end.
+		/// </summary>
+		/// <param name="index">The ID of the effect.</param>
+		/// <param name="module">The module returned by <see cref="generate_effect_code"/>.</param>
+		void init_effect_code(size_t index, reshadefx::module &&module);
+		/// <summary>
+		/// Queue effects with techniques that are enabled in any other preset for compilation, so that switching to those presets does not have to wait for them.
+		/// </summary>
+		void warm_up_preset_effects();
+		/// <summary>
+		/// Rebuild the list of special uniform variables that are updated every frame, with their annotations already parsed.
+		/// This has to be called whenever uniform variables are added or removed.
+		/// </summary>
+		void build_special_uniform_updates();
+		/// <summary>
+		/// Wait for all worker threads compiling effect code and discard their results.
+		/// </summary>
+		void finish_compile_tasks();
+		/// <summary>
+		/// Stop all worker threads loading image files, keeping the images loaded so far in the image cache.
+		/// </summary>
+		void finish_texture_load_tasks();
+		/// <summary>
+		/// Update the specialization constants of an effect with the values from a preset.
+		/// </summary>
+		/// <param name="effect">The effect to specialize.</param>
+		/// <param name="preset">The preset to read the values from.</param>
+		/// <returns><c>true</c> if any value changed and the effect has to be compiled again, <c>false</c> otherwise.</returns>
+		bool update_effect_spec_constants(effect_data &effect, const ini_file &preset);
 
 		/// <summary>
 		/// Enable a technique so it is rendered.
@@ -283,13 +420,26 @@ namespace reshade
 		bool _textures_loaded = false;
 		bool _performance_mode = false;
 		bool _no_reload_on_init = false;
+		bool _lazy_effect_compilation = false;
+		bool _warm_up_preset_effects = false;
 		bool _last_reload_successful = true;
-		std::mutex _reload_mutex;
 		size_t _reload_total_effects = 1;
 		std::vector<size_t> _reload_compile_queue;
 		std::atomic<size_t> _reload_remaining_effects = 0;
 		std::vector<effect_data> _loaded_effects;
 		std::vector<std::thread> _worker_threads;
+		std::vector<std::pair<size_t, std::filesystem::path>> _reload_queue; // Effect files to load with the ID of their effect, largest first
+		std::atomic<size_t> _reload_queue_index = 0;
+		std::atomic<bool> _reload_cancelled = false;
+		std::vector<std::thread> _compile_threads;
+		std::atomic<size_t> _compile_task_index = 0;
+		std::vector<std::unique_ptr<struct effect_compile_task>> _compile_tasks;
+		std::vector<std::thread> _texture_load_threads;
+		std::atomic<size_t> _texture_load_task_index = 0;
+		std::atomic<bool> _texture_load_cancelled = false;
+		std::vector<std::unique_ptr<struct texture_load_task>> _texture_load_tasks;
+		std::unordered_map<std::string, std::unique_ptr<struct texture_load_task>> _texture_image_cache; // Finished tasks by source path and texture description, to reuse their image data as long as the file did not change (images no texture uses anymore are dropped once all textures were loaded)
+		unsigned int _effect_activation_budget = 4; // Time in milliseconds that may be spent per frame on creating back-end objects for compiled effects
 
 		int _date[4] = {};
 		std::chrono::high_resolution_clock::duration _last_frame_duration;
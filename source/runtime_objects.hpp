@@ -7,8 +7,15 @@
 
 #include "effect_expression.hpp"
 #include "moving_average.hpp"
+#include <atomic>
+#include <memory>
 #include <filesystem>
 
+namespace reshadefx
+{
+	class codegen;
+}
+
 namespace reshade
 {
 	enum class special_uniform
@@ -54,12 +61,54 @@ namespace reshade
 		reshadefx::module module;
 		std::filesystem::path source_file;
 		size_t storage_offset = 0, storage_size = 0;
+		std::unordered_map<std::string, std::vector<uint8_t>> compiled_entry_points; // Byte code of every entry point, compiled ahead of time on a worker thread by the back-end
+		std::vector<std::pair<std::string, std::pair<bool, std::string>>> used_macros; // Macros referenced by the effect that were defined outside of it, with their definition (or an undefined flag)
+		std::shared_ptr<reshadefx::codegen> recording; // Parsed effect when code generation was deferred until one of its techniques is enabled, in which case the module only describes the effect
+	};
+
+	struct effect_compile_task
+	{
+		size_t effect_index = std::numeric_limits<size_t>::max();
+		effect_data effect; // Copy of the effect, so that the worker thread does not access data that may be modified on the render thread meanwhile
+		bool success = false;
+		bool consumed = false;
+		std::atomic<bool> finished = false;
+		std::atomic<bool> cancelled = false; // Set when the result is no longer needed, so that a worker thread that did not start on the task yet skips it
+	};
+
+	struct texture_load_task
+	{
+		std::string cache_key; // Source path and texture description, which identify the image in the image cache
+		std::filesystem::path source_path;
+		int64_t modified_time = 0; // Modification time of the source file when loading started
+		uint32_t width = 0, height = 0, levels = 1; // Dimensions to resize the image to
+		reshadefx::texture_format format = reshadefx::texture_format::rgba8;
+		std::vector<std::string> texture_names; // Unique names of all textures that use this image
+		std::vector<uint8_t> pixels; // Decoded 32bpp RGBA image data, empty if the file could not be loaded
+		bool compressed = false; // Pixels contain block-compressed data of all mipmap levels taken from the file as is, instead of RGBA data
+		bool consumed = false;
+		std::atomic<bool> finished = false;
+		std::atomic<bool> cancelled = false; // Set when the textures were created again while loading, so that a worker thread that did not start on the task yet skips it and the result is not uploaded
+	};
+
+	struct special_uniform_update
+	{
+		size_t uniform_index = 0; // Index of the variable in the list of all uniform variables
+		special_uniform source = special_uniform::none;
+		int keycode = 0; // Key or mouse button for key and mouse button variables
+		int mode = 0; // How key and mouse button variables behave: 0 = down, 1 = press, 2 = toggle
+		int random_min = 0, random_max = 0;
+		float min = 0.0f, max = 0.0f, step_min = 0.0f, step_max = 0.0f, smoothing = 0.0f; // Parameters for ping-pong variables
 	};
 
 	struct texture final : reshadefx::texture_info
 	{
 		texture() {}
-		texture(const reshadefx::texture_info &init) : texture_info(init) { }
+		texture(const reshadefx::texture_info &init) : texture_info(init)
+		{
+			source = annotation_as_string("source");
+			annotations.erase("source");
+		}
 
 		int annotation_as_int(const char *ann_name, size_t i = 0) const
 		{
@@ -81,6 +130,7 @@ namespace reshade
 		}
 
 		size_t effect_index = std::numeric_limits<size_t>::max();
+		std::string source; // Path to the image file to load into the texture
 		texture_reference impl_reference = texture_reference::none;
 		std::unique_ptr<base_object> impl;
 		bool shared = false;
@@ -88,7 +138,48 @@ namespace reshade
 
 	struct uniform final : reshadefx::uniform_info
 	{
-		uniform(const reshadefx::uniform_info &init) : uniform_info(init) {}
+		uniform(const reshadefx::uniform_info &init) : uniform_info(init)
+		{
+			// Resolve the annotations known to the runtime and user interface once here, instead of looking them up by name every frame
+			hidden = annotation_as_int("hidden") != 0;
+			ui_type = annotation_as_string("ui_type");
+			ui_label = annotation_as_string("ui_label");
+			ui_tooltip = annotation_as_string("ui_tooltip");
+			ui_category = annotation_as_string("ui_category");
+			ui_items = annotation_as_string("ui_items");
+			ui_min_int = annotation_as_int("ui_min");
+			ui_max_int = annotation_as_int("ui_max");
+			ui_step_int = annotation_as_int("ui_step");
+			ui_min_float = annotation_as_float("ui_min");
+			ui_max_float = annotation_as_float("ui_max");
+			ui_step_float = annotation_as_float("ui_step");
+
+			if (const std::string_view source = annotation_as_string("source"); source.empty()) /* Ignore if annotation is missing */;
+			else if (source == "frametime")
+				special = special_uniform::frame_time;
+			else if (source == "framecount")
+				special = special_uniform::frame_count;
+			else if (source == "random")
+				special = special_uniform::random;
+			else if (source == "pingpong")
+				special = special_uniform::ping_pong;
+			else if (source == "date")
+				special = special_uniform::date;
+			else if (source == "timer")
+				special = special_uniform::timer;
+			else if (source == "key")
+				special = special_uniform::key;
+			else if (source == "mousepoint")
+				special = special_uniform::mouse_point;
+			else if (source == "mousedelta")
+				special = special_uniform::mouse_delta;
+			else if (source == "mousebutton")
+				special = special_uniform::mouse_button;
+
+			// Only keep annotations that are specific to the kind of variable (e.g. parameters of special variables) in the map
+			for (const char *const name : { "hidden", "ui_type", "ui_label", "ui_tooltip", "ui_category", "ui_items", "ui_min", "ui_max", "ui_step", "source" })
+				annotations.erase(name);
+		}
 
 		int annotation_as_int(const char *ann_name, size_t i = 0) const
 		{
@@ -112,11 +203,34 @@ namespace reshade
 		size_t effect_index = std::numeric_limits<size_t>::max();
 		size_t storage_offset = 0;
 		special_uniform special = special_uniform::none;
+		bool hidden = false;
+		std::string ui_type, ui_label, ui_tooltip, ui_category;
+		std::string ui_items; // List of items separated by null characters
+		int ui_min_int = 0, ui_max_int = 0, ui_step_int = 0;
+		float ui_min_float = 0.0f, ui_max_float = 0.0f, ui_step_float = 0.0f;
 	};
 
 	struct technique final : reshadefx::technique_info
 	{
-		technique(const reshadefx::technique_info &init) : technique_info(init) {}
+		technique(const reshadefx::technique_info &init) : technique_info(init)
+		{
+			// Resolve the annotations known to the runtime and user interface once here, instead of looking them up by name every frame
+			force_hidden = annotation_as_int("hidden") != 0;
+			force_enabled = annotation_as_int("enabled") != 0;
+			ui_label = annotation_as_string("ui_label");
+			ui_tooltip = annotation_as_string("ui_tooltip");
+
+			hidden = force_hidden;
+			timeout = annotation_as_int("timeout");
+			timeleft = timeout;
+			toggle_key_data[0] = annotation_as_int("toggle");
+			toggle_key_data[1] = annotation_as_int("togglectrl");
+			toggle_key_data[2] = annotation_as_int("toggleshift");
+			toggle_key_data[3] = annotation_as_int("togglealt");
+
+			for (const char *const name : { "hidden", "enabled", "ui_label", "ui_tooltip", "timeout", "toggle", "togglectrl", "toggleshift", "togglealt" })
+				annotations.erase(name);
+		}
 
 		int annotation_as_int(const char *ann_name, size_t i = 0) const
 		{
@@ -139,6 +253,9 @@ namespace reshade
 
 		size_t effect_index = std::numeric_limits<size_t>::max();
 		std::vector<std::unique_ptr<base_object>> passes_data;
+		std::string ui_label, ui_tooltip;
+		bool force_hidden = false; // Technique is hidden from the user interface regardless of any search filter
+		bool force_enabled = false; // Technique is enabled regardless of the current preset
 		bool hidden = false;
 		bool enabled = false;
 		int32_t timeout = 0;
@@ -0,0 +1,461 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include "effect_preprocessor.hpp"
+#include <spirv.hpp>
+#include <memory>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+void print_usage(const char *path)
+{
+	printf(R"(usage: %s [options] <filename> [...]
+
+Compiles every effect with all code generation back-ends and compares the output against the golden files stored for it.
+The golden files are named after the effect, with the back-end as extension (e.g. "example.sm50.hlsl" or "example.spvasm").
+SPIR-V output is validated structurally and stored as a textual listing with one instruction per line, so that differences are readable.
+
+Options:
+  -h, --help                Print this help.
+
+  --golden-dir <path>       Directory containing the golden files. Defaults to the directory of each effect.
+  --update                  Write the current output as new golden files instead of comparing against them.
+	)", path);
+}
+
+/// <summary>
+/// A code generation back-end configuration the corpus is compiled with.
+/// </summary>
+struct golden_backend
+{
+	const char *extension;
+	std::function<reshadefx::codegen *()> create;
+};
+
+static const golden_backend s_backends[] = {
+	{ "sm30.hlsl", []() { return reshadefx::create_codegen_hlsl(30, false, false, false, false); } },
+	{ "sm40.hlsl", []() { return reshadefx::create_codegen_hlsl(40, false, false, false, false); } },
+	{ "sm50.hlsl", []() { return reshadefx::create_codegen_hlsl(50, false, false, false, false); } },
+	{ "glsl", []() { return reshadefx::create_codegen_glsl(false, false, false, false); } },
+	{ "spvasm", []() { return reshadefx::create_codegen_spirv(false, false, false); } },
+};
+
+/// <summary>
+/// Check that a SPIR-V module is structurally sound: valid header, instruction lengths, unique result IDs within the bound,
+/// properly nested functions and blocks that all end in a terminator, and that branches, calls and entry points reference existing labels and functions.
+/// </summary>
+/// <param name="spirv">The SPIR-V module to validate.</param>
+/// <param name="errors">Receives a description of every problem found.</param>
+/// <returns><c>true</c> if the module is valid, <c>false</c> otherwise.</returns>
+static bool validate_spirv(const std::vector<uint32_t> &spirv, std::string &errors)
+{
+	const auto error = [&errors](size_t offset, const std::string &message) {
+		errors += "spirv(" + std::to_string(offset) + "): " + message + '\n';
+		return false;
+	};
+
+	if (spirv.size() < 5)
+		return error(0, "module is too small to contain a header");
+	if (spirv[0] != spv::MagicNumber)
+		return error(0, "invalid magic number");
+	if (spirv[1] > spv::Version)
+		return error(1, "unsupported version");
+	if (spirv[4] != 0)
+		return error(4, "reserved schema word is not zero");
+
+	const uint32_t bound = spirv[3];
+	std::unordered_map<uint32_t, spv::Op> definitions;
+	std::vector<std::pair<size_t, uint32_t>> labels_referenced, functions_referenced;
+
+	bool valid = true;
+	bool in_function = false, in_block = false;
+	unsigned int num_memory_models = 0;
+
+	const auto define = [&](size_t offset, uint32_t id, spv::Op op) {
+		if (id == 0 || id >= bound)
+			valid = error(offset, "result ID " + std::to_string(id) + " is outside the ID bound " + std::to_string(bound));
+		else if (!definitions.emplace(id, op).second)
+			valid = error(offset, "result ID " + std::to_string(id) + " is defined more than once");
+	};
+
+	for (size_t offset = 5; offset < spirv.size();)
+	{
+		const uint32_t num_words = spirv[offset] >> spv::WordCountShift;
+		const auto op = static_cast<spv::Op>(spirv[offset] & spv::OpCodeMask);
+
+		if (num_words == 0 || offset + num_words > spirv.size())
+			return error(offset, "invalid instruction word count " + std::to_string(num_words));
+
+		const uint32_t *const operands = spirv.data() + offset + 1;
+		const auto require_operands = [&](uint32_t count) {
+			if (num_words > count)
+				return true;
+			valid = error(offset, "instruction " + std::to_string(op) + " is missing operands");
+			return false;
+		};
+
+		if (in_block && op != spv::OpLine && op != spv::OpNoLine && op != spv::OpLabel && op != spv::OpFunctionEnd)
+		{
+			switch (op)
+			{
+			case spv::OpBranch:
+				if (require_operands(1))
+					labels_referenced.emplace_back(offset, operands[0]);
+				in_block = false;
+				break;
+			case spv::OpBranchConditional:
+				if (require_operands(3))
+					labels_referenced.emplace_back(offset, operands[1]),
+					labels_referenced.emplace_back(offset, operands[2]);
+				in_block = false;
+				break;
+			case spv::OpSwitch:
+				if (require_operands(2))
+					for (uint32_t i = 1; i < num_words - 1; i += 2) // Default label followed by literal and label pairs
+						labels_referenced.emplace_back(offset, operands[i]);
+				in_block = false;
+				break;
+			case spv::OpReturn:
+			case spv::OpReturnValue:
+			case spv::OpKill:
+			case spv::OpUnreachable:
+				in_block = false;
+				break;
+			case spv::OpSelectionMerge:
+			case spv::OpLoopMerge:
+				if (require_operands(1))
+					labels_referenced.emplace_back(offset, operands[0]);
+				if (op == spv::OpLoopMerge && require_operands(2))
+					labels_referenced.emplace_back(offset, operands[1]);
+				break;
+			case spv::OpStore:
+			case spv::OpCopyMemory:
+			case spv::OpImageWrite:
+			case spv::OpControlBarrier:
+			case spv::OpMemoryBarrier:
+				break;
+			default:
+				// Everything else that can appear in a block has a result type and result ID
+				if (require_operands(2))
+				{
+					if (definitions.find(operands[0]) == definitions.end())
+						valid = error(offset, "result type " + std::to_string(operands[0]) + " is not defined");
+					define(offset, operands[1], op);
+				}
+				if (op == spv::OpFunctionCall && require_operands(3))
+					functions_referenced.emplace_back(offset, operands[2]);
+				break;
+			}
+		}
+		else switch (op)
+		{
+		case spv::OpMemoryModel:
+			num_memory_models++;
+			break;
+		case spv::OpEntryPoint:
+			if (require_operands(2))
+				functions_referenced.emplace_back(offset, operands[1]);
+			break;
+		case spv::OpString:
+		case spv::OpExtInstImport:
+			if (require_operands(1))
+				define(offset, operands[0], op);
+			break;
+		case spv::OpFunction:
+			if (in_function)
+				valid = error(offset, "function is defined inside another function");
+			in_function = true;
+			if (require_operands(2))
+				define(offset, operands[1], op);
+			break;
+		case spv::OpFunctionParameter:
+			if (!in_function)
+				valid = error(offset, "function parameter outside of a function");
+			if (require_operands(2))
+				define(offset, operands[1], op);
+			break;
+		case spv::OpFunctionEnd:
+			if (!in_function)
+				valid = error(offset, "function end without matching function");
+			if (in_block)
+				valid = error(offset, "last block of the function does not end in a terminator");
+			in_function = in_block = false;
+			break;
+		case spv::OpLabel:
+			if (!in_function)
+				valid = error(offset, "label outside of a function");
+			if (in_block)
+				valid = error(offset, "block does not end in a terminator before the next label");
+			in_block = true;
+			if (require_operands(1))
+				define(offset, operands[0], op);
+			break;
+		default:
+			if (op >= spv::OpTypeVoid && op <= spv::OpTypePipe)
+			{
+				if (require_operands(1))
+					define(offset, operands[0], op);
+			}
+			else if ((op >= spv::OpConstantTrue && op <= spv::OpConstantNull) || (op >= spv::OpSpecConstantTrue && op <= spv::OpSpecConstantOp) || op == spv::OpVariable || op == spv::OpUndef)
+			{
+				if (in_function && op != spv::OpVariable)
+					valid = error(offset, "constant is defined inside a function");
+				if (require_operands(2))
+					define(offset, operands[1], op);
+			}
+			else if (in_function && op != spv::OpLine && op != spv::OpNoLine)
+				valid = error(offset, "instruction " + std::to_string(op) + " is outside of a block");
+			break;
+		}
+
+		offset += num_words;
+	}
+
+	if (in_function)
+		valid = error(spirv.size(), "module ends inside a function");
+	if (num_memory_models != 1)
+		valid = error(5, "module must contain exactly one memory model");
+
+	for (const auto &reference : labels_referenced)
+		if (const auto it = definitions.find(reference.second); it == definitions.end() || it->second != spv::OpLabel)
+			valid = error(reference.first, "branch target " + std::to_string(reference.second) + " is not a label");
+	for (const auto &reference : functions_referenced)
+		if (const auto it = definitions.find(reference.second); it == definitions.end() || it->second != spv::OpFunction)
+			valid = error(reference.first, "ID " + std::to_string(reference.second) + " does not reference a function");
+
+	return valid;
+}
+
+/// <summary>
+/// Convert a SPIR-V module into a textual listing with one instruction per line, which is what is stored as golden file.
+/// </summary>
+static std::string format_spirv(const std::vector<uint32_t> &spirv)
+{
+	std::string listing;
+	char word[16];
+
+	for (size_t offset = 0; offset < spirv.size() && offset < 5; ++offset)
+	{
+		snprintf(word, sizeof(word), "0x%08x", spirv[offset]);
+		listing += "; ";
+		listing += word;
+		listing += '\n';
+	}
+
+	for (size_t offset = 5; offset < spirv.size();)
+	{
+		const uint32_t num_words = std::max(spirv[offset] >> spv::WordCountShift, 1u);
+
+		listing += std::to_string(spirv[offset] & spv::OpCodeMask);
+		for (uint32_t i = 1; i < num_words && offset + i < spirv.size(); ++i)
+			listing += ' ' + std::to_string(spirv[offset + i]);
+		listing += '\n';
+
+		offset += num_words;
+	}
+
+	return listing;
+}
+
+/// <summary>
+/// Print the first lines that differ between the golden and the actual output, with some surrounding context.
+/// </summary>
+static void print_diff(const std::string &expected, const std::string &actual)
+{
+	const auto split_lines = [](const std::string &text) {
+		std::vector<std::string> lines;
+		std::istringstream stream(text);
+		for (std::string line; std::getline(stream, line);)
+			lines.push_back(std::move(line));
+		return lines;
+	};
+
+	const std::vector<std::string> expected_lines = split_lines(expected);
+	const std::vector<std::string> actual_lines = split_lines(actual);
+
+	// Skip the common prefix and suffix, everything in between is reported as changed
+	size_t prefix = 0;
+	while (prefix < expected_lines.size() && prefix < actual_lines.size() && expected_lines[prefix] == actual_lines[prefix])
+		prefix++;
+	size_t suffix = 0;
+	while (suffix < expected_lines.size() - prefix && suffix < actual_lines.size() - prefix &&
+		expected_lines[expected_lines.size() - 1 - suffix] == actual_lines[actual_lines.size() - 1 - suffix])
+		suffix++;
+
+	const size_t max_lines = 20;
+	const size_t context = std::min<size_t>(prefix, 3);
+
+	std::cout << "@@ -" << (prefix - context + 1) << ',' << (expected_lines.size() - prefix - suffix + context) << " +" << (prefix - context + 1) << ',' << (actual_lines.size() - prefix - suffix + context) << " @@" << std::endl;
+	for (size_t i = prefix - context; i < prefix; ++i)
+		std::cout << ' ' << expected_lines[i] << std::endl;
+	for (size_t i = prefix; i < expected_lines.size() - suffix && i < prefix + max_lines; ++i)
+		std::cout << '-' << expected_lines[i] << std::endl;
+	for (size_t i = prefix; i < actual_lines.size() - suffix && i < prefix + max_lines; ++i)
+		std::cout << '+' << actual_lines[i] << std::endl;
+
+	if (expected_lines.size() - suffix > prefix + max_lines || actual_lines.size() - suffix > prefix + max_lines)
+		std::cout << "... (difference truncated)" << std::endl;
+}
+
+/// <summary>
+/// Compile an effect with all back-ends and compare against (or update) its golden files.
+/// </summary>
+/// <returns>The number of back-ends that failed.</returns>
+static unsigned int test_effect(const std::filesystem::path &path, const std::filesystem::path &golden_dir, bool update)
+{
+	reshadefx::preprocessor pp;
+	pp.add_include_path(path.parent_path());
+	pp.add_macro_definition("__RESHADE__", "40300");
+	pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", "0");
+	pp.add_macro_definition("BUFFER_WIDTH", "800");
+	pp.add_macro_definition("BUFFER_HEIGHT", "600");
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+
+	if (!pp.append_file(path))
+	{
+		std::cout << pp.errors() << "FAILED " << path.u8string() << ": preprocessing failed" << std::endl;
+		return 1;
+	}
+
+	unsigned int num_failures = 0;
+
+	// Parse once into a recording, so that the replay used by fxc is tested against direct code generation as well
+	std::unique_ptr<reshadefx::codegen> recording(reshadefx::create_codegen_recorder());
+	{
+		reshadefx::parser parser;
+		if (!parser.parse(pp.output(), recording.get()))
+		{
+			std::cout << parser.errors() << "FAILED " << path.u8string() << ": parsing failed" << std::endl;
+			return 1;
+		}
+	}
+
+	for (const golden_backend &config : s_backends)
+	{
+		const std::string name = path.stem().u8string() + '.' + config.extension;
+
+		std::unique_ptr<reshadefx::codegen> backend(config.create());
+		reshadefx::parser parser;
+		if (!parser.parse(pp.output(), backend.get()))
+		{
+			std::cout << parser.errors() << "FAILED " << name << ": parsing failed" << std::endl;
+			num_failures++;
+			continue;
+		}
+
+		reshadefx::module module;
+		backend->write_result(module);
+
+		std::unique_ptr<reshadefx::codegen> replay_backend(config.create());
+		reshadefx::replay_codegen(*recording, *replay_backend);
+		reshadefx::module replay_module;
+		replay_backend->write_result(replay_module);
+
+		std::string actual = module.hlsl;
+		std::string replay_actual = replay_module.hlsl;
+
+		if (!module.spirv.empty())
+		{
+			if (std::string errors; !validate_spirv(module.spirv, errors))
+			{
+				std::cout << errors << "FAILED " << name << ": SPIR-V validation failed" << std::endl;
+				num_failures++;
+				continue;
+			}
+
+			actual = format_spirv(module.spirv);
+			replay_actual = format_spirv(replay_module.spirv);
+		}
+
+		if (replay_actual != actual)
+		{
+			std::cout << "FAILED " << name << ": replayed output differs from direct code generation" << std::endl;
+			print_diff(actual, replay_actual);
+			num_failures++;
+			continue;
+		}
+
+		const std::filesystem::path golden_path = golden_dir / name;
+
+		if (update)
+		{
+			std::ofstream(golden_path, std::ios::binary) << actual;
+			std::cout << "UPDATED " << name << std::endl;
+			continue;
+		}
+
+		std::ifstream golden_file(golden_path, std::ios::binary);
+		if (!golden_file)
+		{
+			std::cout << "FAILED " << name << ": golden file " << golden_path.u8string() << " does not exist, run with --update to create it" << std::endl;
+			num_failures++;
+			continue;
+		}
+
+		const std::string expected((std::istreambuf_iterator<char>(golden_file)), std::istreambuf_iterator<char>());
+
+		if (actual != expected)
+		{
+			std::cout << "FAILED " << name << ": output differs from golden file " << golden_path.u8string() << std::endl;
+			print_diff(expected, actual);
+			num_failures++;
+			continue;
+		}
+
+		std::cout << "PASSED " << name << std::endl;
+	}
+
+	return num_failures;
+}
+
+int main(int argc, char *argv[])
+{
+	bool update = false;
+	std::filesystem::path golden_dir;
+	std::vector<std::filesystem::path> files;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char *const arg = argv[i];
+
+		if (0 == strcmp(arg, "-h") || 0 == strcmp(arg, "--help"))
+		{
+			print_usage(argv[0]);
+			return 0;
+		}
+		else if (0 == strcmp(arg, "--update"))
+			update = true;
+		else if (0 == strcmp(arg, "--golden-dir") && i + 1 < argc)
+			golden_dir = argv[++i];
+		else if (arg[0] == '-')
+		{
+			std::cerr << "error: unknown option \"" << arg << '\"' << std::endl;
+			return 1;
+		}
+		else
+			files.push_back(arg);
+	}
+
+	if (files.empty())
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	unsigned int num_failures = 0;
+	for (const std::filesystem::path &file : files)
+		num_failures += test_effect(file, golden_dir.empty() ? file.parent_path() : golden_dir, update);
+
+	return num_failures == 0 ? 0 : 1;
+}
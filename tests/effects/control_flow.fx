@@ -0,0 +1,92 @@
+// Branches, loops, switch statements and function calls
+
+uniform int Mode < ui_type = "combo"; ui_items = "Off\0Half\0Full\0"; > = 2;
+uniform float Threshold = 0.5;
+
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+
+float Luma(float3 color)
+{
+	return dot(color, float3(0.2126, 0.7152, 0.0722));
+}
+
+float3 Accumulate(float2 texcoord, out float weight)
+{
+	float3 result = 0.0;
+	weight = 0.0;
+
+	[unroll]
+	for (int x = -2; x <= 2; ++x)
+	{
+		const float3 color = tex2Dlod(BackBuffer, float4(texcoord + float2(x * BUFFER_RCP_WIDTH, 0), 0, 0)).rgb;
+		if (Luma(color) < Threshold)
+			continue;
+		result += color;
+		weight += 1.0;
+	}
+
+	[loop]
+	for (int i = 0; i < 16; i++)
+	{
+		if (weight >= 4.0)
+			break;
+		weight += 0.5;
+	}
+
+	return result;
+}
+
+float4 MainPS(float4 vpos : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	float4 color = tex2D(BackBuffer, texcoord);
+
+	float weight;
+	const float3 bright = Accumulate(texcoord, weight);
+
+	switch (Mode)
+	{
+	case 0:
+		return color;
+	case 1:
+		color.rgb += bright * 0.5 / max(weight, 1.0);
+		break;
+	default:
+		color.rgb += bright / max(weight, 1.0);
+		break;
+	}
+
+	int steps = 0;
+	while (Luma(color.rgb) > 1.0 && steps < 8)
+	{
+		color.rgb *= 0.9;
+		steps++;
+	}
+
+	do
+	{
+		color.a = saturate(color.a - 0.1);
+	}
+	while (color.a > 0.5);
+
+	if (color.r < 0.0)
+		discard;
+
+	return color;
+}
+
+technique ControlFlow
+{
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = MainPS;
+	}
+}
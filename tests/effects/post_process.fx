@@ -0,0 +1,64 @@
+// Typical post-processing effect with render targets, samplers and multiple passes
+
+uniform float Intensity < ui_type = "slider"; ui_min = 0.0; ui_max = 1.0; > = 0.5;
+uniform float3 Tint < ui_type = "color"; > = float3(1.0, 0.9, 0.8);
+uniform float Timer < source = "timer"; >;
+uniform int FrameCount < source = "framecount"; >;
+
+texture BackBufferTex : COLOR;
+texture DepthBufferTex : DEPTH;
+texture HalfTex { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA16F; MipLevels = 3; };
+
+sampler BackBuffer { Texture = BackBufferTex; SRGBTexture = true; };
+sampler DepthBuffer { Texture = DepthBufferTex; };
+sampler Half { Texture = HalfTex; AddressU = MIRROR; AddressV = MIRROR; MagFilter = POINT; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+
+float GetLinearDepth(float2 texcoord)
+{
+	const float depth = tex2Dlod(DepthBuffer, float4(texcoord, 0, 0)).x;
+	return depth / (1000.0 - depth * (1000.0 - 1.0));
+}
+
+float4 DownsamplePS(float4 vpos : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	float4 color = 0.0;
+	color += tex2D(BackBuffer, texcoord + float2(-BUFFER_RCP_WIDTH, -BUFFER_RCP_HEIGHT));
+	color += tex2D(BackBuffer, texcoord + float2( BUFFER_RCP_WIDTH, -BUFFER_RCP_HEIGHT));
+	color += tex2D(BackBuffer, texcoord + float2(-BUFFER_RCP_WIDTH,  BUFFER_RCP_HEIGHT));
+	color += tex2D(BackBuffer, texcoord + float2( BUFFER_RCP_WIDTH,  BUFFER_RCP_HEIGHT));
+	return color * 0.25;
+}
+
+float3 CombinePS(float4 vpos : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	const float3 color = tex2D(BackBuffer, texcoord).rgb;
+	const float3 blurred = tex2D(Half, texcoord).rgb * Tint;
+	const float fade = saturate(sin(Timer * 0.001) * 0.5 + 0.5) * ((FrameCount % 2) == 0 ? 1.0 : 0.9);
+	return lerp(color, blurred, Intensity * fade * (1.0 - GetLinearDepth(texcoord)));
+}
+
+technique PostProcess < ui_tooltip = "Blurs the image based on depth"; >
+{
+	pass Downsample
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = DownsamplePS;
+		RenderTarget = HalfTex;
+	}
+	pass Combine
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = CombinePS;
+		SRGBWriteEnable = true;
+		BlendEnable = true;
+		SrcBlend = SRCALPHA;
+		DestBlend = INVSRCALPHA;
+	}
+}
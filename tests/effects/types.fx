@@ -0,0 +1,80 @@
+// Structures, arrays, matrices, vector swizzles and intrinsics
+
+#define NUM_WEIGHTS 4
+#define WEIGHT(i) (1.0 / ((i) + 1))
+
+uniform float4x4 Transform = float4x4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+uniform float2 Offsets[2] = { float2(0.5, 0.0), float2(0.0, 0.5) };
+uniform bool Invert = false;
+uniform uint Seed = 12345u;
+
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+
+struct VSOutput
+{
+	float4 position : SV_Position;
+	float2 texcoord : TEXCOORD0;
+	float3 ray : TEXCOORD1;
+};
+
+struct Material
+{
+	float3 albedo;
+	float roughness;
+};
+
+static const float Weights[NUM_WEIGHTS] = { WEIGHT(0), WEIGHT(1), WEIGHT(2), WEIGHT(3) };
+
+VSOutput MainVS(uint id : SV_VertexID)
+{
+	VSOutput output;
+	output.texcoord = float2((id == 2) ? 2.0 : 0.0, (id == 1) ? 2.0 : 0.0);
+	output.position = mul(float4(output.texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0), Transform);
+	output.ray = normalize(float3(output.texcoord - 0.5, 1.0));
+	return output;
+}
+
+Material MakeMaterial(float3 color)
+{
+	Material material;
+	material.albedo = color.bgr;
+	material.roughness = frac(sin(dot(color.xy, float2(12.9898, 78.233))) * 43758.5453);
+	return material;
+}
+
+float Hash(uint value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352du;
+	value ^= value >> 15;
+	return float(value & 0xFFFF) / 65535.0;
+}
+
+float4 MainPS(VSOutput input) : SV_Target
+{
+	float3 color = 0.0;
+	for (int i = 0; i < NUM_WEIGHTS; ++i)
+		color += tex2D(BackBuffer, input.texcoord + Offsets[i % 2] * BUFFER_RCP_WIDTH * i).rgb * Weights[i];
+
+	const Material material = MakeMaterial(color);
+
+	float3x3 basis = float3x3(1, 0, 0, 0, 1, 0, 0, 0, 1);
+	basis[2] = input.ray;
+
+	float4 result;
+	result.rgb = mul(basis, material.albedo) * (1.0 - material.roughness);
+	result.a = Hash(Seed + uint(input.position.x));
+	result.xy = pow(abs(result.yx), 2.2);
+
+	return Invert ? 1.0 - result : result;
+}
+
+technique Types
+{
+	pass
+	{
+		VertexShader = MainVS;
+		PixelShader = MainPS;
+	}
+}
@@ -0,0 +1,250 @@
+float hlsl_fmod(float x, float y) { return x - y * trunc(x / y); }
+ vec2 hlsl_fmod( vec2 x,  vec2 y) { return x - y * trunc(x / y); }
+ vec3 hlsl_fmod( vec3 x,  vec3 y) { return x - y * trunc(x / y); }
+ vec4 hlsl_fmod( vec4 x,  vec4 y) { return x - y * trunc(x / y); }
+ mat2 hlsl_fmod( mat2 x,  mat2 y) { return x - matrixCompMult(y, mat2(trunc(x[0] / y[0]), trunc(x[1] / y[1]))); }
+ mat3 hlsl_fmod( mat3 x,  mat3 y) { return x - matrixCompMult(y, mat3(trunc(x[0] / y[0]), trunc(x[1] / y[1]), trunc(x[2] / y[2]))); }
+ mat4 hlsl_fmod( mat4 x,  mat4 y) { return x - matrixCompMult(y, mat4(trunc(x[0] / y[0]), trunc(x[1] / y[1]), trunc(x[2] / y[2]), trunc(x[3] / y[3]))); }
+layout(std140, binding = 0) uniform _Globals {
+	int _Globals_Mode;
+	float _Globals_Threshold;
+};
+layout(binding = 0) uniform sampler2D V_USBackBuffer;
+void F_USPostProcessVS(
+	in uint id,
+	out vec4 position,
+	out vec2 texcoord)
+{
+	const uint _10 = 2u;
+	bool _11 = id == _10;
+	const float _12 = 2.00000000;
+	const float _13 = 0.00000000;
+	float _14 = _11 ? _12 : _13;
+	texcoord[0] = _14;
+	const uint _15 = 1u;
+	bool _16 = id == _15;
+	const float _17 = 2.00000000;
+	const float _18 = 0.00000000;
+	float _19 = _16 ? _17 : _18;
+	texcoord[1] = _19;
+	const vec2 _20 = vec2(2.00000000, -2.00000000);
+	vec2 _21 = texcoord * _20;
+	const vec2 _22 = vec2(-1.00000000, 1.00000000);
+	vec2 _23 = _21 + _22;
+	float _24 = _23[0];
+	float _25 = _23[1];
+	const float _26 = 0.00000000;
+	const float _27 = 1.00000000;
+	vec4 _28 = vec4(_24, _25, _26, _27);
+	position = _28;
+	return;
+}
+float F_USLuma(
+	in vec3 color)
+{
+	const vec3 _32 = vec3(0.21259999, 0.71520001, 0.07220000);
+	float _33 = dot(color, _32);
+	return _33;
+}
+vec3 F_USAccumulate(
+	in vec2 texcoord,
+	out float weight)
+{
+	const vec3 _38 = vec3(0.00000000, 0.00000000, 0.00000000);
+	vec3 result;
+	result = _38;
+	const float _40 = 0.00000000;
+	weight = _40;
+	const int _41 = -2;
+	int x;
+	x = _41;
+	const int _48 = 2;
+	bool _49 = x <= _48;
+	while (_49)
+	{
+		{
+			float _52 = float(x);
+			const float _53 = 0.00125000;
+			float _54 = _52 * _53;
+			const float _55 = 0.00000000;
+			vec2 _56 = vec2(_54, _55);
+			vec2 _57 = texcoord + _56;
+			float _58 = _57[0];
+			float _59 = _57[1];
+			const float _60 = 0.00000000;
+			const float _61 = 0.00000000;
+			vec4 _62 = vec4(_58, _59, _60, _61);
+			vec4 _63 = textureLod(V_USBackBuffer, _62.xy * vec2(1.0, -1.0) + vec2(0.0, 1.0), _62.w);
+			vec3 _64 = _63.xyz;
+			vec3 color_65;
+			color_65 = _64;
+			vec3 _69;
+			_69 = color_65;
+			float _70 = F_USLuma(_69);
+			bool _71 = _70 < _Globals_Threshold;
+			if (_71)
+			{
+					const int _50 = 1;
+		int _51 = x + _50;
+		x = _51;
+		const int _48 = 2;
+		_49 = x <= _48;
+	continue;
+			}
+			vec3 _72 = result + color_65;
+			result = _72;
+			const float _73 = 1.00000000;
+			float _74 = weight + _73;
+			weight = _74;
+		}
+		const int _50 = 1;
+		int _51 = x + _50;
+		x = _51;
+		const int _48 = 2;
+		_49 = x <= _48;
+	}
+	const int _75 = 0;
+	int i;
+	i = _75;
+	const int _82 = 16;
+	bool _83 = i < _82;
+	while (_83)
+	{
+		{
+			const float _89 = 4.00000000;
+			bool _90 = weight >= _89;
+			if (_90)
+			{
+				break;
+			}
+			const float _91 = 0.50000000;
+			float _92 = weight + _91;
+			weight = _92;
+		}
+		const int _84 = 1;
+		int _85 = i + _84;
+		i = _85;
+		const int _82 = 16;
+		_83 = i < _82;
+	}
+	return result;
+}
+vec4 F_USMainPS(
+	in vec4 vpos,
+	in vec2 texcoord)
+{
+	vec4 _97 = texture(V_USBackBuffer, texcoord * vec2(1.0, -1.0) + vec2(0.0, 1.0));
+	vec4 color_98;
+	color_98 = _97;
+	const float _99 = 0.00000000;
+	float weight_100;
+	weight_100 = _99;
+	vec2 _101;
+	float _102;
+	_101 = texcoord;
+	vec3 _103 = F_USAccumulate(_101, _102);
+	weight_100 = _102;
+	vec3 bright;
+	bright = _103;
+	switch (_Globals_Mode)
+	{
+	case 0: {
+		return color_98;
+	}
+	case 1: {
+		const vec3 _108 = vec3(0.50000000, 0.50000000, 0.50000000);
+		vec3 _109 = bright * _108;
+		const float _110 = 1.00000000;
+		float _111 = max(weight_100, _110);
+		vec3 _112 = _111.xxx;
+		vec3 _113 = _109 / _112;
+		vec3 _114 = color_98.xyz;
+		vec3 _115 = _114 + _113;
+		color_98.xyz = _115;
+		break;
+	}
+	default: {
+		const float _117 = 1.00000000;
+		float _118 = max(weight_100, _117);
+		vec3 _119 = _118.xxx;
+		vec3 _120 = bright / _119;
+		vec3 _121 = color_98.xyz;
+		vec3 _122 = _121 + _120;
+		color_98.xyz = _122;
+		break;
+	}
+	}
+	const int _123 = 0;
+	int steps;
+	steps = _123;
+	vec3 _130;
+	vec3 _131 = color_98.xyz;
+	_130 = _131;
+	float _132 = F_USLuma(_130);
+	const float _133 = 1.00000000;
+	bool _134 = _132 > _133;
+	const int _135 = 8;
+	bool _136 = steps < _135;
+	bool _137 = _134 && _136;
+	while (_137)
+	{
+		{
+			const vec3 _138 = vec3(0.89999998, 0.89999998, 0.89999998);
+			vec3 _139 = color_98.xyz;
+			vec3 _140 = _139 * _138;
+			color_98.xyz = _140;
+			const int _141 = 1;
+			int _142 = steps + _141;
+			steps = _142;
+		}
+		vec3 _130;
+		vec3 _131 = color_98.xyz;
+		_130 = _131;
+		float _132 = F_USLuma(_130);
+		const float _133 = 1.00000000;
+		bool _134 = _132 > _133;
+		const int _135 = 8;
+		bool _136 = steps < _135;
+		_137 = _134 && _136;
+	}
+	bool _153;
+	do
+	{
+		{
+			float _147 = color_98[3];
+			const float _148 = 0.10000000;
+			float _149 = _147 - _148;
+			float _150 = clamp(_149, 0.0, 1.0);
+			color_98[3] = _150;
+		}
+		float _151 = color_98[3];
+		const float _152 = 0.50000000;
+		_153 = _151 > _152;
+	}
+	while (_153);
+	float _157 = color_98[0];
+	const float _158 = 0.00000000;
+	bool _159 = _157 < _158;
+	if (_159)
+	{
+		discard;
+	}
+	return color_98;
+}
+#ifdef ENTRY_POINT_F__PostProcessVS
+layout(location = 1) out vec2 _param_texcoord;
+void main()
+{
+	F_USPostProcessVS(gl_VertexID, gl_Position, _param_texcoord);
+	return;
+}
+#endif
+#ifdef ENTRY_POINT_F__MainPS
+layout(location = 0) out vec4 _return;
+layout(location = 1) in vec2 _param_texcoord;
+void main()
+{
+	_return = F_USMainPS(gl_FragCoord, _param_texcoord);
+	return;
+}
+#endif
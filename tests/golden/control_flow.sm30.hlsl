@@ -0,0 +1,244 @@
+struct __sampler2D { sampler2D s; float2 pixelsize; };
+uniform float2 __TEXEL_SIZE__ : register(c255);
+int _Globals_Mode : register(c0);
+float _Globals_Threshold : register(c1);
+sampler2D __V__BackBuffer_s : register(s0);
+static const __sampler2D V__BackBuffer = { __V__BackBuffer_s, float2(COLOR_PIXEL_SIZE) }; 
+void F__PostProcessVS_(
+	in int id,
+	out float4 position,
+	out float2 texcoord)
+{
+	const int _10 = 2;
+	bool _11 = id == _10;
+	const float _12 = 2.00000000;
+	const float _13 = 0.00000000;
+	float _14 = _11 ? _12 : _13;
+	texcoord[0] = _14;
+	const int _15 = 1;
+	bool _16 = id == _15;
+	const float _17 = 2.00000000;
+	const float _18 = 0.00000000;
+	float _19 = _16 ? _17 : _18;
+	texcoord[1] = _19;
+	const float2 _20 = float2(2.00000000, -2.00000000);
+	float2 _21 = texcoord * _20;
+	const float2 _22 = float2(-1.00000000, 1.00000000);
+	float2 _23 = _21 + _22;
+	float _24 = _23[0];
+	float _25 = _23[1];
+	const float _26 = 0.00000000;
+	const float _27 = 1.00000000;
+	float4 _28 = float4(_24, _25, _26, _27);
+	position = _28;
+	return;
+}
+float F__Luma_(
+	in float3 color)
+{
+	const float3 _32 = float3(0.21259999, 0.71520001, 0.07220000);
+	float _33 = dot(color, _32);
+	return _33;
+}
+float3 F__Accumulate_(
+	in float2 texcoord,
+	out float weight)
+{
+	const float3 _38 = float3(0.00000000, 0.00000000, 0.00000000);
+	float3 result;
+	result = _38;
+	const float _40 = 0.00000000;
+	weight = _40;
+	const int _41 = -2;
+	int x;
+	x = _41;
+	const int _48 = 2;
+	bool _49 = x <= _48;
+	[unroll] while (_49)
+	{
+		{
+			float _52 = ((float)x);
+			const float _53 = 0.00125000;
+			float _54 = _52 * _53;
+			const float _55 = 0.00000000;
+			float2 _56 = float2(_54, _55);
+			float2 _57 = texcoord + _56;
+			float _58 = _57[0];
+			float _59 = _57[1];
+			const float _60 = 0.00000000;
+			const float _61 = 0.00000000;
+			float4 _62 = float4(_58, _59, _60, _61);
+			float4 _63 = tex2Dlod(V__BackBuffer.s, _62);
+			float3 _64 = _63.xyz;
+			float3 color_65;
+			color_65 = _64;
+			float3 _69;
+			_69 = color_65;
+			float _70 = F__Luma_(_69);
+			bool _71 = _70 < _Globals_Threshold;
+			if (_71)
+			{
+					const int _50 = 1;
+		int _51 = x + _50;
+		x = _51;
+		const int _48 = 2;
+		_49 = x <= _48;
+	continue;
+			}
+			float3 _72 = result + color_65;
+			result = _72;
+			const float _73 = 1.00000000;
+			float _74 = weight + _73;
+			weight = _74;
+		}
+		const int _50 = 1;
+		int _51 = x + _50;
+		x = _51;
+		const int _48 = 2;
+		_49 = x <= _48;
+	}
+	const int _75 = 0;
+	int i;
+	i = _75;
+	const int _82 = 16;
+	bool _83 = i < _82;
+	[loop] while (_83)
+	{
+		{
+			const float _89 = 4.00000000;
+			bool _90 = weight >= _89;
+			if (_90)
+			{
+				break;
+			}
+			const float _91 = 0.50000000;
+			float _92 = weight + _91;
+			weight = _92;
+		}
+		const int _84 = 1;
+		int _85 = i + _84;
+		i = _85;
+		const int _82 = 16;
+		_83 = i < _82;
+	}
+	return result;
+}
+float4 F__MainPS_(
+	in float4 vpos,
+	in float2 texcoord)
+{
+	float4 _97 = tex2D(V__BackBuffer.s, texcoord);
+	float4 color_98;
+	color_98 = _97;
+	const float _99 = 0.00000000;
+	float weight_100;
+	weight_100 = _99;
+	float2 _101;
+	float _102;
+	_101 = texcoord;
+	float3 _103 = F__Accumulate_(_101, _102);
+	weight_100 = _102;
+	float3 bright;
+	bright = _103;
+	[unroll] do { if (_Globals_Mode == 0)
+	{
+		return color_98;
+	}
+	else
+	if (_Globals_Mode == 1)
+	{
+		const float3 _108 = float3(0.50000000, 0.50000000, 0.50000000);
+		float3 _109 = bright * _108;
+		const float _110 = 1.00000000;
+		float _111 = max(weight_100, _110);
+		float3 _112 = _111.xxx;
+		float3 _113 = _109 / _112;
+		float3 _114 = color_98.xyz;
+		float3 _115 = _114 + _113;
+		color_98.xyz = _115;
+		break;
+	}
+	else
+	{
+		const float _117 = 1.00000000;
+		float _118 = max(weight_100, _117);
+		float3 _119 = _118.xxx;
+		float3 _120 = bright / _119;
+		float3 _121 = color_98.xyz;
+		float3 _122 = _121 + _120;
+		color_98.xyz = _122;
+		break;
+	} } while (false);
+	const int _123 = 0;
+	int steps;
+	steps = _123;
+	float3 _130;
+	float3 _131 = color_98.xyz;
+	_130 = _131;
+	float _132 = F__Luma_(_130);
+	const float _133 = 1.00000000;
+	bool _134 = _132 > _133;
+	const int _135 = 8;
+	bool _136 = steps < _135;
+	bool _137 = _134 && _136;
+	while (_137)
+	{
+		{
+			const float3 _138 = float3(0.89999998, 0.89999998, 0.89999998);
+			float3 _139 = color_98.xyz;
+			float3 _140 = _139 * _138;
+			color_98.xyz = _140;
+			const int _141 = 1;
+			int _142 = steps + _141;
+			steps = _142;
+		}
+		float3 _130;
+		float3 _131 = color_98.xyz;
+		_130 = _131;
+		float _132 = F__Luma_(_130);
+		const float _133 = 1.00000000;
+		bool _134 = _132 > _133;
+		const int _135 = 8;
+		bool _136 = steps < _135;
+		_137 = _134 && _136;
+	}
+	bool _153;
+	do
+	{
+		{
+			float _147 = color_98[3];
+			const float _148 = 0.10000000;
+			float _149 = _147 - _148;
+			float _150 = saturate(_149);
+			color_98[3] = _150;
+		}
+		float _151 = color_98[3];
+		const float _152 = 0.50000000;
+		_153 = _151 > _152;
+	}
+	while (_153);
+	float _157 = color_98[0];
+	const float _158 = 0.00000000;
+	bool _159 = _157 < _158;
+	if (_159)
+	{
+		discard;
+	}
+	return color_98;
+}
+void F__PostProcessVS(
+	in int id : TEXCOORD0 /* VERTEXID */,
+	out float4 position : POSITION,
+	out float2 texcoord : TEXCOORD)
+{
+	F__PostProcessVS_(id, position, texcoord);
+	position.xy += __TEXEL_SIZE__ * position.ww;
+	return;
+}
+float4 F__MainPS(
+	in float4 vpos : VPOS,
+	in float2 texcoord : TEXCOORD) : COLOR
+{
+	const float4 ret_166 = float4(F__MainPS_(vpos, texcoord));
+	return ret_166;
+}
@@ -0,0 +1,163 @@
+float hlsl_fmod(float x, float y) { return x - y * trunc(x / y); }
+ vec2 hlsl_fmod( vec2 x,  vec2 y) { return x - y * trunc(x / y); }
+ vec3 hlsl_fmod( vec3 x,  vec3 y) { return x - y * trunc(x / y); }
+ vec4 hlsl_fmod( vec4 x,  vec4 y) { return x - y * trunc(x / y); }
+ mat2 hlsl_fmod( mat2 x,  mat2 y) { return x - matrixCompMult(y, mat2(trunc(x[0] / y[0]), trunc(x[1] / y[1]))); }
+ mat3 hlsl_fmod( mat3 x,  mat3 y) { return x - matrixCompMult(y, mat3(trunc(x[0] / y[0]), trunc(x[1] / y[1]), trunc(x[2] / y[2]))); }
+ mat4 hlsl_fmod( mat4 x,  mat4 y) { return x - matrixCompMult(y, mat4(trunc(x[0] / y[0]), trunc(x[1] / y[1]), trunc(x[2] / y[2]), trunc(x[3] / y[3]))); }
+layout(std140, binding = 0) uniform _Globals {
+	float _Globals_Intensity;
+	vec3 _Globals_Tint;
+	float _Globals_Timer;
+	int _Globals_FrameCount;
+};
+layout(binding = 0) uniform sampler2D V_USBackBuffer;
+layout(binding = 1) uniform sampler2D V_USDepthBuffer;
+layout(binding = 2) uniform sampler2D V_USHalf;
+void F_USPostProcessVS(
+	in uint id,
+	out vec4 position,
+	out vec2 texcoord)
+{
+	const uint _16 = 2u;
+	bool _17 = id == _16;
+	const float _18 = 2.00000000;
+	const float _19 = 0.00000000;
+	float _20 = _17 ? _18 : _19;
+	texcoord[0] = _20;
+	const uint _21 = 1u;
+	bool _22 = id == _21;
+	const float _23 = 2.00000000;
+	const float _24 = 0.00000000;
+	float _25 = _22 ? _23 : _24;
+	texcoord[1] = _25;
+	const vec2 _26 = vec2(2.00000000, -2.00000000);
+	vec2 _27 = texcoord * _26;
+	const vec2 _28 = vec2(-1.00000000, 1.00000000);
+	vec2 _29 = _27 + _28;
+	float _30 = _29[0];
+	float _31 = _29[1];
+	const float _32 = 0.00000000;
+	const float _33 = 1.00000000;
+	vec4 _34 = vec4(_30, _31, _32, _33);
+	position = _34;
+	return;
+}
+float F_USGetLinearDepth(
+	in vec2 texcoord)
+{
+	float _38 = texcoord[0];
+	float _39 = texcoord[1];
+	const float _40 = 0.00000000;
+	const float _41 = 0.00000000;
+	vec4 _42 = vec4(_38, _39, _40, _41);
+	vec4 _43 = textureLod(V_USDepthBuffer, _42.xy * vec2(1.0, -1.0) + vec2(0.0, 1.0), _42.w);
+	float _44 = _43[0];
+	float depth;
+	depth = _44;
+	const float _46 = 999.00000000;
+	float _47 = depth * _46;
+	const float _48 = 1000.00000000;
+	float _49 = _48 - _47;
+	float _50 = depth / _49;
+	return _50;
+}
+vec4 F_USDownsamplePS(
+	in vec4 vpos,
+	in vec2 texcoord)
+{
+	const vec4 _55 = vec4(0.00000000, 0.00000000, 0.00000000, 0.00000000);
+	vec4 color;
+	color = _55;
+	const vec2 _57 = vec2(-0.00125000, -0.00166667);
+	vec2 _58 = texcoord + _57;
+	vec4 _59 = texture(V_USBackBuffer, _58 * vec2(1.0, -1.0) + vec2(0.0, 1.0));
+	vec4 _60 = color + _59;
+	color = _60;
+	const vec2 _61 = vec2(0.00125000, -0.00166667);
+	vec2 _62 = texcoord + _61;
+	vec4 _63 = texture(V_USBackBuffer, _62 * vec2(1.0, -1.0) + vec2(0.0, 1.0));
+	vec4 _64 = color + _63;
+	color = _64;
+	const vec2 _65 = vec2(-0.00125000, 0.00166667);
+	vec2 _66 = texcoord + _65;
+	vec4 _67 = texture(V_USBackBuffer, _66 * vec2(1.0, -1.0) + vec2(0.0, 1.0));
+	vec4 _68 = color + _67;
+	color = _68;
+	const vec2 _69 = vec2(0.00125000, 0.00166667);
+	vec2 _70 = texcoord + _69;
+	vec4 _71 = texture(V_USBackBuffer, _70 * vec2(1.0, -1.0) + vec2(0.0, 1.0));
+	vec4 _72 = color + _71;
+	color = _72;
+	const vec4 _73 = vec4(0.25000000, 0.25000000, 0.25000000, 0.25000000);
+	vec4 _74 = color * _73;
+	return _74;
+}
+vec3 F_USCombinePS(
+	in vec4 vpos,
+	in vec2 texcoord)
+{
+	vec4 _79 = texture(V_USBackBuffer, texcoord * vec2(1.0, -1.0) + vec2(0.0, 1.0));
+	vec3 _80 = _79.xyz;
+	vec3 color_81;
+	color_81 = _80;
+	vec4 _82 = texture(V_USHalf, texcoord * vec2(1.0, -1.0) + vec2(0.0, 1.0));
+	vec3 _83 = _82.xyz;
+	vec3 _84 = _83 * _Globals_Tint;
+	vec3 blurred;
+	blurred = _84;
+	const float _86 = 0.00100000;
+	float _87 = _Globals_Timer * _86;
+	float _88 = sin(_87);
+	const float _89 = 0.50000000;
+	float _90 = _88 * _89;
+	const float _91 = 0.50000000;
+	float _92 = _90 + _91;
+	float _93 = clamp(_92, 0.0, 1.0);
+	const int _94 = 2;
+	int _95 = _Globals_FrameCount % _94;
+	const int _96 = 0;
+	bool _97 = _95 == _96;
+	const float _98 = 1.00000000;
+	const float _99 = 0.89999998;
+	float _100 = _97 ? _98 : _99;
+	float _101 = _93 * _100;
+	float fade;
+	fade = _101;
+	float _103 = _Globals_Intensity * fade;
+	vec2 _104;
+	_104 = texcoord;
+	float _105 = F_USGetLinearDepth(_104);
+	const float _106 = 1.00000000;
+	float _107 = _106 - _105;
+	float _108 = _103 * _107;
+	vec3 _109 = _108.xxx;
+	vec3 _110 = mix(color_81, blurred, _109);
+	return _110;
+}
+#ifdef ENTRY_POINT_F__PostProcessVS
+layout(location = 1) out vec2 _param_texcoord;
+void main()
+{
+	F_USPostProcessVS(gl_VertexID, gl_Position, _param_texcoord);
+	return;
+}
+#endif
+#ifdef ENTRY_POINT_F__DownsamplePS
+layout(location = 0) out vec4 _return;
+layout(location = 1) in vec2 _param_texcoord;
+void main()
+{
+	_return = F_USDownsamplePS(gl_FragCoord, _param_texcoord);
+	return;
+}
+#endif
+#ifdef ENTRY_POINT_F__CombinePS
+layout(location = 0) out vec3 _return;
+layout(location = 1) in vec2 _param_texcoord;
+void main()
+{
+	_return = F_USCombinePS(gl_FragCoord, _param_texcoord);
+	return;
+}
+#endif
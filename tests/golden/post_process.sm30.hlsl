@@ -0,0 +1,156 @@
+struct __sampler2D { sampler2D s; float2 pixelsize; };
+uniform float2 __TEXEL_SIZE__ : register(c255);
+float _Globals_Intensity : register(c0);
+float3 _Globals_Tint : register(c1);
+float _Globals_Timer : register(c4);
+int _Globals_FrameCount : register(c5);
+sampler2D __V__BackBuffer_s : register(s0);
+static const __sampler2D V__BackBuffer = { __V__BackBuffer_s, float2(COLOR_PIXEL_SIZE) }; 
+sampler2D __V__DepthBuffer_s : register(s1);
+static const __sampler2D V__DepthBuffer = { __V__DepthBuffer_s, float2(DEPTH_PIXEL_SIZE) }; 
+sampler2D __V__Half_s : register(s2);
+static const __sampler2D V__Half = { __V__Half_s, float2(0.002500, 0.003333) }; 
+void F__PostProcessVS_(
+	in int id,
+	out float4 position,
+	out float2 texcoord)
+{
+	const int _16 = 2;
+	bool _17 = id == _16;
+	const float _18 = 2.00000000;
+	const float _19 = 0.00000000;
+	float _20 = _17 ? _18 : _19;
+	texcoord[0] = _20;
+	const int _21 = 1;
+	bool _22 = id == _21;
+	const float _23 = 2.00000000;
+	const float _24 = 0.00000000;
+	float _25 = _22 ? _23 : _24;
+	texcoord[1] = _25;
+	const float2 _26 = float2(2.00000000, -2.00000000);
+	float2 _27 = texcoord * _26;
+	const float2 _28 = float2(-1.00000000, 1.00000000);
+	float2 _29 = _27 + _28;
+	float _30 = _29[0];
+	float _31 = _29[1];
+	const float _32 = 0.00000000;
+	const float _33 = 1.00000000;
+	float4 _34 = float4(_30, _31, _32, _33);
+	position = _34;
+	return;
+}
+float F__GetLinearDepth_(
+	in float2 texcoord)
+{
+	float _38 = texcoord[0];
+	float _39 = texcoord[1];
+	const float _40 = 0.00000000;
+	const float _41 = 0.00000000;
+	float4 _42 = float4(_38, _39, _40, _41);
+	float4 _43 = tex2Dlod(V__DepthBuffer.s, _42);
+	float _44 = _43[0];
+	float depth;
+	depth = _44;
+	const float _46 = 999.00000000;
+	float _47 = depth * _46;
+	const float _48 = 1000.00000000;
+	float _49 = _48 - _47;
+	float _50 = depth / _49;
+	return _50;
+}
+float4 F__DownsamplePS_(
+	in float4 vpos,
+	in float2 texcoord)
+{
+	const float4 _55 = float4(0.00000000, 0.00000000, 0.00000000, 0.00000000);
+	float4 color;
+	color = _55;
+	const float2 _57 = float2(-0.00125000, -0.00166667);
+	float2 _58 = texcoord + _57;
+	float4 _59 = tex2D(V__BackBuffer.s, _58);
+	float4 _60 = color + _59;
+	color = _60;
+	const float2 _61 = float2(0.00125000, -0.00166667);
+	float2 _62 = texcoord + _61;
+	float4 _63 = tex2D(V__BackBuffer.s, _62);
+	float4 _64 = color + _63;
+	color = _64;
+	const float2 _65 = float2(-0.00125000, 0.00166667);
+	float2 _66 = texcoord + _65;
+	float4 _67 = tex2D(V__BackBuffer.s, _66);
+	float4 _68 = color + _67;
+	color = _68;
+	const float2 _69 = float2(0.00125000, 0.00166667);
+	float2 _70 = texcoord + _69;
+	float4 _71 = tex2D(V__BackBuffer.s, _70);
+	float4 _72 = color + _71;
+	color = _72;
+	const float4 _73 = float4(0.25000000, 0.25000000, 0.25000000, 0.25000000);
+	float4 _74 = color * _73;
+	return _74;
+}
+float3 F__CombinePS_(
+	in float4 vpos,
+	in float2 texcoord)
+{
+	float4 _79 = tex2D(V__BackBuffer.s, texcoord);
+	float3 _80 = _79.xyz;
+	float3 color_81;
+	color_81 = _80;
+	float4 _82 = tex2D(V__Half.s, texcoord);
+	float3 _83 = _82.xyz;
+	float3 _84 = _83 * _Globals_Tint;
+	float3 blurred;
+	blurred = _84;
+	const float _86 = 0.00100000;
+	float _87 = _Globals_Timer * _86;
+	float _88 = sin(_87);
+	const float _89 = 0.50000000;
+	float _90 = _88 * _89;
+	const float _91 = 0.50000000;
+	float _92 = _90 + _91;
+	float _93 = saturate(_92);
+	const int _94 = 2;
+	int _95 = _Globals_FrameCount % _94;
+	const int _96 = 0;
+	bool _97 = _95 == _96;
+	const float _98 = 1.00000000;
+	const float _99 = 0.89999998;
+	float _100 = _97 ? _98 : _99;
+	float _101 = _93 * _100;
+	float fade;
+	fade = _101;
+	float _103 = _Globals_Intensity * fade;
+	float2 _104;
+	_104 = texcoord;
+	float _105 = F__GetLinearDepth_(_104);
+	const float _106 = 1.00000000;
+	float _107 = _106 - _105;
+	float _108 = _103 * _107;
+	float3 _109 = _108.xxx;
+	float3 _110 = lerp(color_81, blurred, _109);
+	return _110;
+}
+void F__PostProcessVS(
+	in int id : TEXCOORD0 /* VERTEXID */,
+	out float4 position : POSITION,
+	out float2 texcoord : TEXCOORD)
+{
+	F__PostProcessVS_(id, position, texcoord);
+	position.xy += __TEXEL_SIZE__ * position.ww;
+	return;
+}
+float4 F__DownsamplePS(
+	in float4 vpos : VPOS,
+	in float2 texcoord : TEXCOORD) : COLOR
+{
+	const float4 ret_117 = float4(F__DownsamplePS_(vpos, texcoord));
+	return ret_117;
+}
+float4 F__CombinePS(
+	in float4 vpos : VPOS,
+	in float2 texcoord : TEXCOORD) : COLOR
+{
+	const float4 ret_122 = float4(F__CombinePS_(vpos, texcoord), 0.0);
+	return ret_122;
+}
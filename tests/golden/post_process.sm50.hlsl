@@ -0,0 +1,139 @@
+struct __sampler2D { Texture2D t; SamplerState s; };
+cbuffer _Globals {
+	float _Globals_Intensity;
+	float3 _Globals_Tint;
+	float _Globals_Timer;
+	int _Globals_FrameCount;
+};
+Texture2D V__BackBufferTex : register(t0);
+Texture2D __srgbV__BackBufferTex : register(t1);
+Texture2D V__DepthBufferTex : register(t2);
+Texture2D __srgbV__DepthBufferTex : register(t3);
+Texture2D V__HalfTex : register(t4);
+Texture2D __srgbV__HalfTex : register(t5);
+SamplerState __s0 : register(s0);
+static const __sampler2D V__BackBuffer = { __srgbV__BackBufferTex, __s0 };
+static const __sampler2D V__DepthBuffer = { V__DepthBufferTex, __s0 };
+SamplerState __s1 : register(s1);
+static const __sampler2D V__Half = { V__HalfTex, __s1 };
+void F__PostProcessVS(
+	in uint id : SV_VERTEXID,
+	out float4 position : SV_POSITION,
+	out float2 texcoord : TEXCOORD)
+{
+	const uint _16 = 2;
+	bool _17 = id == _16;
+	const float _18 = 2.00000000;
+	const float _19 = 0.00000000;
+	float _20 = _17 ? _18 : _19;
+	texcoord[0] = _20;
+	const uint _21 = 1;
+	bool _22 = id == _21;
+	const float _23 = 2.00000000;
+	const float _24 = 0.00000000;
+	float _25 = _22 ? _23 : _24;
+	texcoord[1] = _25;
+	const float2 _26 = float2(2.00000000, -2.00000000);
+	float2 _27 = texcoord * _26;
+	const float2 _28 = float2(-1.00000000, 1.00000000);
+	float2 _29 = _27 + _28;
+	float _30 = _29[0];
+	float _31 = _29[1];
+	const float _32 = 0.00000000;
+	const float _33 = 1.00000000;
+	float4 _34 = float4(_30, _31, _32, _33);
+	position = _34;
+	return;
+}
+float F__GetLinearDepth(
+	in float2 texcoord)
+{
+	float _38 = texcoord[0];
+	float _39 = texcoord[1];
+	const float _40 = 0.00000000;
+	const float _41 = 0.00000000;
+	float4 _42 = float4(_38, _39, _40, _41);
+	float4 _43 = V__DepthBuffer.t.SampleLevel(V__DepthBuffer.s, _42.xy, _42.w);
+	float _44 = _43[0];
+	float depth;
+	depth = _44;
+	const float _46 = 999.00000000;
+	float _47 = depth * _46;
+	const float _48 = 1000.00000000;
+	float _49 = _48 - _47;
+	float _50 = depth / _49;
+	return _50;
+}
+float4 F__DownsamplePS(
+	in float4 vpos : SV_POSITION,
+	in float2 texcoord : TEXCOORD) : SV_TARGET
+{
+	const float4 _55 = float4(0.00000000, 0.00000000, 0.00000000, 0.00000000);
+	float4 color;
+	color = _55;
+	const float2 _57 = float2(-0.00125000, -0.00166667);
+	float2 _58 = texcoord + _57;
+	float4 _59 = V__BackBuffer.t.Sample(V__BackBuffer.s, _58);
+	float4 _60 = color + _59;
+	color = _60;
+	const float2 _61 = float2(0.00125000, -0.00166667);
+	float2 _62 = texcoord + _61;
+	float4 _63 = V__BackBuffer.t.Sample(V__BackBuffer.s, _62);
+	float4 _64 = color + _63;
+	color = _64;
+	const float2 _65 = float2(-0.00125000, 0.00166667);
+	float2 _66 = texcoord + _65;
+	float4 _67 = V__BackBuffer.t.Sample(V__BackBuffer.s, _66);
+	float4 _68 = color + _67;
+	color = _68;
+	const float2 _69 = float2(0.00125000, 0.00166667);
+	float2 _70 = texcoord + _69;
+	float4 _71 = V__BackBuffer.t.Sample(V__BackBuffer.s, _70);
+	float4 _72 = color + _71;
+	color = _72;
+	const float4 _73 = float4(0.25000000, 0.25000000, 0.25000000, 0.25000000);
+	float4 _74 = color * _73;
+	return _74;
+}
+float3 F__CombinePS(
+	in float4 vpos : SV_POSITION,
+	in float2 texcoord : TEXCOORD) : SV_TARGET
+{
+	float4 _79 = V__BackBuffer.t.Sample(V__BackBuffer.s, texcoord);
+	float3 _80 = _79.xyz;
+	float3 color_81;
+	color_81 = _80;
+	float4 _82 = V__Half.t.Sample(V__Half.s, texcoord);
+	float3 _83 = _82.xyz;
+	float3 _84 = _83 * _Globals_Tint;
+	float3 blurred;
+	blurred = _84;
+	const float _86 = 0.00100000;
+	float _87 = _Globals_Timer * _86;
+	float _88 = sin(_87);
+	const float _89 = 0.50000000;
+	float _90 = _88 * _89;
+	const float _91 = 0.50000000;
+	float _92 = _90 + _91;
+	float _93 = saturate(_92);
+	const int _94 = 2;
+	int _95 = _Globals_FrameCount % _94;
+	const int _96 = 0;
+	bool _97 = _95 == _96;
+	const float _98 = 1.00000000;
+	const float _99 = 0.89999998;
+	float _100 = _97 ? _98 : _99;
+	float _101 = _93 * _100;
+	float fade;
+	fade = _101;
+	float _103 = _Globals_Intensity * fade;
+	float2 _104;
+	_104 = texcoord;
+	float _105 = F__GetLinearDepth(_104);
+	const float _106 = 1.00000000;
+	float _107 = _106 - _105;
+	float _108 = _103 * _107;
+	float3 _109 = _108.xxx;
+	float3 _110 = lerp(color_81, blurred, _109);
+	return _110;
+}
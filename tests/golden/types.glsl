@@ -0,0 +1,204 @@
+float hlsl_fmod(float x, float y) { return x - y * trunc(x / y); }
+ vec2 hlsl_fmod( vec2 x,  vec2 y) { return x - y * trunc(x / y); }
+ vec3 hlsl_fmod( vec3 x,  vec3 y) { return x - y * trunc(x / y); }
+ vec4 hlsl_fmod( vec4 x,  vec4 y) { return x - y * trunc(x / y); }
+ mat2 hlsl_fmod( mat2 x,  mat2 y) { return x - matrixCompMult(y, mat2(trunc(x[0] / y[0]), trunc(x[1] / y[1]))); }
+ mat3 hlsl_fmod( mat3 x,  mat3 y) { return x - matrixCompMult(y, mat3(trunc(x[0] / y[0]), trunc(x[1] / y[1]), trunc(x[2] / y[2]))); }
+ mat4 hlsl_fmod( mat4 x,  mat4 y) { return x - matrixCompMult(y, mat4(trunc(x[0] / y[0]), trunc(x[1] / y[1]), trunc(x[2] / y[2]), trunc(x[3] / y[3]))); }
+layout(std140, binding = 0) uniform _Globals {
+	mat4x4 _Globals_Transform;
+	vec2 _Globals_Offsets;
+	bool _Globals_Invert;
+	uint _Globals_Seed;
+};
+layout(binding = 0) uniform sampler2D V_USBackBuffer;
+struct S_USVSOutput
+{
+	vec4 position;
+	vec2 texcoord;
+	vec3 ray;
+};
+struct S_USMaterial
+{
+	vec3 albedo;
+	float roughness;
+};
+S_USVSOutput F_USMainVS(
+	in uint id)
+{
+	S_USVSOutput _12;
+	S_USVSOutput output_;
+	output_ = _12;
+	const uint _14 = 2u;
+	bool _15 = id == _14;
+	const float _16 = 2.00000000;
+	const float _17 = 0.00000000;
+	float _18 = _15 ? _16 : _17;
+	const uint _19 = 1u;
+	bool _20 = id == _19;
+	const float _21 = 2.00000000;
+	const float _22 = 0.00000000;
+	float _23 = _20 ? _21 : _22;
+	vec2 _24 = vec2(_18, _23);
+	output_.texcoord = _24;
+	vec2 _25 = output_.texcoord;
+	const vec2 _26 = vec2(2.00000000, -2.00000000);
+	vec2 _27 = _25 * _26;
+	const vec2 _28 = vec2(-1.00000000, 1.00000000);
+	vec2 _29 = _27 + _28;
+	float _30 = _29[0];
+	float _31 = _29[1];
+	const float _32 = 0.00000000;
+	const float _33 = 1.00000000;
+	vec4 _34 = vec4(_30, _31, _32, _33);
+	vec4 _35 = (_34 * _Globals_Transform);
+	output_.position = _35;
+	vec2 _36 = output_.texcoord;
+	const vec2 _37 = vec2(0.50000000, 0.50000000);
+	vec2 _38 = _36 - _37;
+	float _39 = _38[0];
+	float _40 = _38[1];
+	const float _41 = 1.00000000;
+	vec3 _42 = vec3(_39, _40, _41);
+	vec3 _43 = normalize(_42);
+	output_.ray = _43;
+	return output_;
+}
+S_USMaterial F_USMakeMaterial(
+	in vec3 color)
+{
+	S_USMaterial _47;
+	S_USMaterial material;
+	material = _47;
+	vec3 _49 = color.zyx;
+	material.albedo = _49;
+	vec2 _50 = color.xy;
+	const vec2 _51 = vec2(12.98980045, 78.23300171);
+	float _52 = dot(_50, _51);
+	float _53 = sin(_52);
+	const float _54 = 43758.54296875;
+	float _55 = _53 * _54;
+	float _56 = fract(_55);
+	material.roughness = _56;
+	return material;
+}
+float F_USHash(
+	in uint value)
+{
+	const uint _60 = 16u;
+	uint _61 = value >> _60;
+	uint _62 = value ^ _61;
+	value = _62;
+	const uint _63 = 2146121005u;
+	uint _64 = value * _63;
+	value = _64;
+	const uint _65 = 15u;
+	uint _66 = value >> _65;
+	uint _67 = value ^ _66;
+	value = _67;
+	const uint _68 = 65535u;
+	uint _69 = value & _68;
+	float _70 = float(_69);
+	const float _71 = 65535.00000000;
+	float _72 = _70 / _71;
+	return _72;
+}
+vec4 F_USMainPS(
+	in S_USVSOutput input_)
+{
+	const vec3 _76 = vec3(0.00000000, 0.00000000, 0.00000000);
+	vec3 color_77;
+	color_77 = _76;
+	const int _78 = 0;
+	int i;
+	i = _78;
+	const int _85 = 4;
+	bool _86 = i < _85;
+	while (_86)
+	{
+		{
+			const int _89 = 2;
+			int _90 = i % _89;
+			vec2 _91 = _Globals_Offsets[_90];
+			const vec2 _92 = vec2(0.00125000, 0.00125000);
+			vec2 _93 = _91 * _92;
+			vec2 _94 = vec2(i.xx);
+			vec2 _95 = _93 * _94;
+			vec2 _96 = input_.texcoord;
+			vec2 _97 = _96 + _95;
+			vec4 _98 = texture(V_USBackBuffer, _97 * vec2(1.0, -1.0) + vec2(0.0, 1.0));
+			const float _99[4] = float[](1.00000000, 0.50000000, 0.33333334, 0.25000000);
+			float _100[4] = _99;
+			vec3 _101 = _98.xyz;
+			vec3 _102 = _100[i].xxx;
+			vec3 _103 = _101 * _102;
+			vec3 _104 = color_77 + _103;
+			color_77 = _104;
+		}
+		const int _87 = 1;
+		int _88 = i + _87;
+		i = _88;
+		const int _85 = 4;
+		_86 = i < _85;
+	}
+	vec3 _105;
+	_105 = color_77;
+	S_USMaterial _106 = F_USMakeMaterial(_105);
+	S_USMaterial material_107;
+	material_107 = _106;
+	const mat3x3 _108 = transpose(mat3x3(1.00000000, 0.00000000, 0.00000000, 0.00000000, 1.00000000, 0.00000000, 0.00000000, 0.00000000, 1.00000000));
+	mat3x3 basis;
+	basis = _108;
+	vec3 _110 = input_.ray;
+	basis[2] = _110;
+	const vec4 _111 = vec4(0.00000000, 0.00000000, 0.00000000, 0.00000000);
+	vec4 result;
+	result = _111;
+	vec3 _113 = material_107.albedo;
+	vec3 _114 = (basis * _113);
+	const float _115 = 1.00000000;
+	float _116 = material_107.roughness;
+	float _117 = _115 - _116;
+	vec3 _118 = _117.xxx;
+	vec3 _119 = _114 * _118;
+	result.xyz = _119;
+	uint _120 = uint(input_.position[0]);
+	uint _121 = _Globals_Seed + _120;
+	uint _122;
+	_122 = _121;
+	float _123 = F_USHash(_122);
+	result[3] = _123;
+	vec2 _124 = result.yx;
+	vec2 _125 = abs(_124);
+	const vec2 _126 = vec2(2.20000005, 2.20000005);
+	vec2 _127 = pow(_125, _126);
+	result.xy = _127;
+	const vec4 _128 = vec4(1.00000000, 1.00000000, 1.00000000, 1.00000000);
+	vec4 _129 = _128 - result;
+	bvec4 _130 = _Globals_Invert.xxxx;
+	vec4 _131 = all(_130) ? _129 : result;
+	return _131;
+}
+#ifdef ENTRY_POINT_F__MainVS
+layout(location = 1) out vec2 _return_texcoord;
+layout(location = 2) out vec3 _return_ray;
+void main()
+{
+	S_USVSOutput _return = F_USMainVS(gl_VertexID);
+	gl_Position = _return.position;
+	_return_texcoord = _return.texcoord;
+	_return_ray = _return.ray;
+	return;
+}
+#endif
+#ifdef ENTRY_POINT_F__MainPS
+layout(location = 0) out vec4 _return;
+layout(location = 1) in vec2 _param_input_texcoord;
+layout(location = 2) in vec3 _param_input_ray;
+void main()
+{
+	S_USVSOutput _param_input = S_USVSOutput(gl_FragCoord, _param_input_texcoord, _param_input_ray);
+	_return = F_USMainPS(_param_input);
+	return;
+}
+#endif
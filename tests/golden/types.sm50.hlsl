@@ -0,0 +1,178 @@
+struct __sampler2D { Texture2D t; SamplerState s; };
+cbuffer _Globals {
+	float4x4 _Globals_Transform;
+	float2 _Globals_Offsets;
+	bool _Globals_Invert;
+	uint _Globals_Seed;
+};
+Texture2D V__BackBufferTex : register(t0);
+Texture2D __srgbV__BackBufferTex : register(t1);
+SamplerState __s0 : register(s0);
+static const __sampler2D V__BackBuffer = { V__BackBufferTex, __s0 };
+struct S__VSOutput
+{
+	float4 position : SV_POSITION;
+	float2 texcoord : TEXCOORD0;
+	float3 ray : TEXCOORD1;
+};
+struct S__Material
+{
+	float3 albedo;
+	float roughness;
+};
+S__VSOutput F__MainVS(
+	in uint id : SV_VERTEXID)
+{
+	const S__VSOutput _12 = (S__VSOutput)0;
+	S__VSOutput output;
+	output = _12;
+	const uint _14 = 2;
+	bool _15 = id == _14;
+	const float _16 = 2.00000000;
+	const float _17 = 0.00000000;
+	float _18 = _15 ? _16 : _17;
+	const uint _19 = 1;
+	bool _20 = id == _19;
+	const float _21 = 2.00000000;
+	const float _22 = 0.00000000;
+	float _23 = _20 ? _21 : _22;
+	float2 _24 = float2(_18, _23);
+	output.texcoord = _24;
+	float2 _25 = output.texcoord;
+	const float2 _26 = float2(2.00000000, -2.00000000);
+	float2 _27 = _25 * _26;
+	const float2 _28 = float2(-1.00000000, 1.00000000);
+	float2 _29 = _27 + _28;
+	float _30 = _29[0];
+	float _31 = _29[1];
+	const float _32 = 0.00000000;
+	const float _33 = 1.00000000;
+	float4 _34 = float4(_30, _31, _32, _33);
+	float4 _35 = mul(_34, _Globals_Transform);
+	output.position = _35;
+	float2 _36 = output.texcoord;
+	const float2 _37 = float2(0.50000000, 0.50000000);
+	float2 _38 = _36 - _37;
+	float _39 = _38[0];
+	float _40 = _38[1];
+	const float _41 = 1.00000000;
+	float3 _42 = float3(_39, _40, _41);
+	float3 _43 = normalize(_42);
+	output.ray = _43;
+	return output;
+}
+S__Material F__MakeMaterial(
+	in float3 color)
+{
+	const S__Material _47 = (S__Material)0;
+	S__Material material;
+	material = _47;
+	float3 _49 = color.zyx;
+	material.albedo = _49;
+	float2 _50 = color.xy;
+	const float2 _51 = float2(12.98980045, 78.23300171);
+	float _52 = dot(_50, _51);
+	float _53 = sin(_52);
+	const float _54 = 43758.54296875;
+	float _55 = _53 * _54;
+	float _56 = frac(_55);
+	material.roughness = _56;
+	return material;
+}
+float F__Hash(
+	in uint value)
+{
+	const uint _60 = 16;
+	uint _61 = value >> _60;
+	uint _62 = value ^ _61;
+	value = _62;
+	const uint _63 = 2146121005;
+	uint _64 = value * _63;
+	value = _64;
+	const uint _65 = 15;
+	uint _66 = value >> _65;
+	uint _67 = value ^ _66;
+	value = _67;
+	const uint _68 = 65535;
+	uint _69 = value & _68;
+	float _70 = ((float)_69);
+	const float _71 = 65535.00000000;
+	float _72 = _70 / _71;
+	return _72;
+}
+float4 F__MainPS(
+	in S__VSOutput input) : SV_TARGET
+{
+	const float3 _76 = float3(0.00000000, 0.00000000, 0.00000000);
+	float3 color_77;
+	color_77 = _76;
+	const int _78 = 0;
+	int i;
+	i = _78;
+	const int _85 = 4;
+	bool _86 = i < _85;
+	while (_86)
+	{
+		{
+			const int _89 = 2;
+			int _90 = i % _89;
+			float2 _91 = _Globals_Offsets[_90];
+			const float2 _92 = float2(0.00125000, 0.00125000);
+			float2 _93 = _91 * _92;
+			float2 _94 = ((float2)i.xx);
+			float2 _95 = _93 * _94;
+			float2 _96 = input.texcoord;
+			float2 _97 = _96 + _95;
+			float4 _98 = V__BackBuffer.t.Sample(V__BackBuffer.s, _97);
+			const float _99[4] = { 1.00000000, 0.50000000, 0.33333334, 0.25000000 };
+			float _100[4] = _99;
+			float3 _101 = _98.xyz;
+			float3 _102 = _100[i].xxx;
+			float3 _103 = _101 * _102;
+			float3 _104 = color_77 + _103;
+			color_77 = _104;
+		}
+		const int _87 = 1;
+		int _88 = i + _87;
+		i = _88;
+		const int _85 = 4;
+		_86 = i < _85;
+	}
+	float3 _105;
+	_105 = color_77;
+	S__Material _106 = F__MakeMaterial(_105);
+	S__Material material_107;
+	material_107 = _106;
+	const float3x3 _108 = float3x3(1.00000000, 0.00000000, 0.00000000, 0.00000000, 1.00000000, 0.00000000, 0.00000000, 0.00000000, 1.00000000);
+	float3x3 basis;
+	basis = _108;
+	float3 _110 = input.ray;
+	basis[2] = _110;
+	const float4 _111 = float4(0.00000000, 0.00000000, 0.00000000, 0.00000000);
+	float4 result;
+	result = _111;
+	float3 _113 = material_107.albedo;
+	float3 _114 = mul(basis, _113);
+	const float _115 = 1.00000000;
+	float _116 = material_107.roughness;
+	float _117 = _115 - _116;
+	float3 _118 = _117.xxx;
+	float3 _119 = _114 * _118;
+	result.xyz = _119;
+	uint _120 = ((uint)input.position[0]);
+	uint _121 = _Globals_Seed + _120;
+	uint _122;
+	_122 = _121;
+	float _123 = F__Hash(_122);
+	result[3] = _123;
+	float2 _124 = result.yx;
+	float2 _125 = abs(_124);
+	const float2 _126 = float2(2.20000005, 2.20000005);
+	float2 _127 = pow(_125, _126);
+	result.xy = _127;
+	const float4 _128 = float4(1.00000000, 1.00000000, 1.00000000, 1.00000000);
+	float4 _129 = _128 - result;
+	bool4 _130 = _Globals_Invert.xxxx;
+	float4 _131 = _130 ? _129 : result;
+	return _131;
+}
@@ -0,0 +1,143 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "alloc_stats.hpp"
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+
+// Counted per thread, so that measurements are not affected by work on other threads
+static thread_local size_t s_num_allocations = 0;
+static thread_local size_t s_num_allocated_bytes = 0;
+
+size_t get_num_allocations()
+{
+	return s_num_allocations;
+}
+size_t get_num_allocated_bytes()
+{
+	return s_num_allocated_bytes;
+}
+
+static void *allocate(size_t size) noexcept
+{
+	s_num_allocations++;
+	s_num_allocated_bytes += size;
+
+	return std::malloc(size != 0 ? size : 1);
+}
+static void *allocate(size_t size, std::align_val_t alignment) noexcept
+{
+	// Over-allocate through the same malloc as all other allocations and store the original pointer right in front of the aligned block, so that it can be released with free again
+	const size_t align = static_cast<size_t>(alignment) < alignof(void *) ? alignof(void *) : static_cast<size_t>(alignment);
+
+	void *const memory = allocate(size + align + sizeof(void *));
+	if (memory == nullptr)
+		return nullptr;
+
+	void *const aligned_memory = reinterpret_cast<void *>((reinterpret_cast<uintptr_t>(memory) + sizeof(void *) + align - 1) & ~static_cast<uintptr_t>(align - 1));
+	static_cast<void **>(aligned_memory)[-1] = memory;
+	return aligned_memory;
+}
+
+static void deallocate(void *memory) noexcept
+{
+	std::free(memory);
+}
+static void deallocate(void *memory, std::align_val_t) noexcept
+{
+	if (memory != nullptr)
+		std::free(static_cast<void **>(memory)[-1]);
+}
+
+void *operator new(size_t size)
+{
+	if (void *const memory = allocate(size))
+		return memory;
+	throw std::bad_alloc();
+}
+void *operator new[](size_t size)
+{
+	if (void *const memory = allocate(size))
+		return memory;
+	throw std::bad_alloc();
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	return allocate(size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+	return allocate(size);
+}
+void *operator new(size_t size, std::align_val_t alignment)
+{
+	if (void *const memory = allocate(size, alignment))
+		return memory;
+	throw std::bad_alloc();
+}
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+	if (void *const memory = allocate(size, alignment))
+		return memory;
+	throw std::bad_alloc();
+}
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return allocate(size, alignment);
+}
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return allocate(size, alignment);
+}
+
+void operator delete(void *memory) noexcept
+{
+	deallocate(memory);
+}
+void operator delete[](void *memory) noexcept
+{
+	deallocate(memory);
+}
+void operator delete(void *memory, size_t) noexcept
+{
+	deallocate(memory);
+}
+void operator delete[](void *memory, size_t) noexcept
+{
+	deallocate(memory);
+}
+void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+	deallocate(memory);
+}
+void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+	deallocate(memory);
+}
+void operator delete(void *memory, std::align_val_t alignment) noexcept
+{
+	deallocate(memory, alignment);
+}
+void operator delete[](void *memory, std::align_val_t alignment) noexcept
+{
+	deallocate(memory, alignment);
+}
+void operator delete(void *memory, size_t, std::align_val_t alignment) noexcept
+{
+	deallocate(memory, alignment);
+}
+void operator delete[](void *memory, size_t, std::align_val_t alignment) noexcept
+{
+	deallocate(memory, alignment);
+}
+void operator delete(void *memory, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	deallocate(memory, alignment);
+}
+void operator delete[](void *memory, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	deallocate(memory, alignment);
+}
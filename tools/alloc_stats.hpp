@@ -0,0 +1,18 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/// <summary>
+/// Returns the number of allocations made through the global operator new on the calling thread so far.
+/// Linking "alloc_stats.cpp" into a tool replaces all global allocation functions with counting ones.
+/// </summary>
+size_t get_num_allocations();
+/// <summary>
+/// Returns the number of bytes allocated through the global operator new on the calling thread so far.
+/// </summary>
+size_t get_num_allocated_bytes();
@@ -0,0 +1,39 @@
+// Statements, structures and intrinsics
+struct Light { float3 position; float3 color; float radius; };
+
+static const Light Lights[2] = { { float3(0, 1, 0), float3(1, 1, 1), 2.0 }, { float3(1, 0, 0), float3(1, 0, 0), 1.0 } };
+
+float3 Shade(float3 p, inout float weight)
+{
+	float3 result = 0;
+	[unroll] for (int i = 0; i < 2; ++i)
+	{
+		const float d = distance(p, Lights[i].position);
+		if (d > Lights[i].radius)
+			continue;
+		result += Lights[i].color * smoothstep(Lights[i].radius, 0.0, d);
+		weight += 1.0;
+	}
+
+	int n = 3;
+	[loop] while (n-- > 0) { weight *= 0.5; if (weight < 0.1) break; }
+	do { weight += 0.01; } while (weight < 0.5);
+
+	switch (int(weight) & 3)
+	{
+	case 0: return result;
+	case 1: case 2: result *= 2; break;
+	default: discard;
+	}
+
+	float4x4 m = float4x4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+	return mul(float4(result, 1), m).xyz * (weight != 0 ? rcp(weight) : 1.0);
+}
+
+float4 MainPS(float4 vpos : SV_Position) : SV_Target
+{
+	float weight = 0;
+	return float4(Shade(vpos.xyz, weight), weight);
+}
+
+technique Flow { pass { VertexShader = MainPS; PixelShader = MainPS; } }
@@ -0,0 +1,42 @@
+// The first byte of each input selects the lexer options or code generation back-end in the fuzz targets
+uniform float Intensity < ui_type = "slider"; ui_min = 0.0; ui_max = 1.0; > = 0.5;
+uniform float Timer < source = "timer"; >;
+
+texture BackBufferTex : COLOR;
+texture TargetTex { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA16F; MipLevels = 3; };
+sampler BackBuffer { Texture = BackBufferTex; SRGBTexture = true; };
+sampler Target { Texture = TargetTex; AddressU = MIRROR; MagFilter = POINT; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+
+float4 DownsamplePS(float4 vpos : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return tex2Dlod(BackBuffer, float4(texcoord, 0, 0)) * Intensity;
+}
+float3 CombinePS(float4 vpos : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	const float3 color = tex2D(BackBuffer, texcoord).rgb;
+	return lerp(color, tex2D(Target, texcoord).rgb, saturate(sin(Timer * 0.001)));
+}
+
+technique Example < ui_tooltip = "Example"; >
+{
+	pass Downsample
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = DownsamplePS;
+		RenderTarget = TargetTex;
+	}
+	pass Combine
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = CombinePS;
+		SRGBWriteEnable = true;
+		BlendEnable = true; SrcBlend = SRCALPHA; DestBlend = INVSRCALPHA;
+	}
+}
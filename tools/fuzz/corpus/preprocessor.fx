@@ -0,0 +1,29 @@
+// Macro expansion and conditional compilation
+#define STR(x) #x
+#define CAT(a, b) a##b
+#define TWICE(x) ((x) + (x))
+#define SELECT(a, b, c) CAT(sel_, a)(b, c)
+#define sel_0(b, c) b
+#define sel_1(b, c) c
+#ifndef QUALITY
+	#define QUALITY 2
+#endif
+
+#if QUALITY > 1 && defined(BUFFER_WIDTH)
+static const int Samples = TWICE(QUALITY) * 4;
+#elif QUALITY == 1
+static const int Samples = 4;
+#else
+	#error "unsupported quality"
+#endif
+
+#undef TWICE
+#pragma message STR(Samples)
+#line 100 "renamed.fx"
+
+float CAT(get, Value)() { return SELECT(1, 0.0, 1.0) + Samples; }
+
+#if 0
+	#if unbalanced (
+	#endif
+#endif
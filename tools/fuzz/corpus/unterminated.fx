@@ -0,0 +1,4 @@
+// Unterminated constructs at the end of the file
+float a = 1.0e+;
+static const string s = "never closed
+/* comment that never ends
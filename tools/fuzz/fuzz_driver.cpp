@@ -0,0 +1,191 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Standalone driver for the fuzz targets in this directory, used with compilers that do not ship libFuzzer.
+// It runs every input from the specified files and directories through the target once and enforces the same
+// per-input time and memory budgets libFuzzer would, so that crash and timeout reproducers can be checked anywhere.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static size_t s_memory_budget = 0;
+static std::atomic<size_t> s_allocated_bytes(0);
+static const char *s_current_input = nullptr;
+
+// Count all allocations to detect inputs that make the compiler allocate unreasonable amounts of memory
+void *operator new(size_t size)
+{
+	const size_t total = s_allocated_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+	if (s_memory_budget != 0 && total > s_memory_budget)
+	{
+		fprintf(stderr, "==ERROR: input \"%s\" exceeded the memory budget of %zu MB\n", s_current_input, s_memory_budget >> 20);
+		std::_Exit(1);
+	}
+
+	if (void *const ptr = std::malloc(size != 0 ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+void operator delete[](void *ptr) noexcept
+{
+	std::free(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+void operator delete[](void *ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+static void print_usage(const char *path)
+{
+	printf("usage: %s [options] <file|directory> [...]\n\n", path);
+	printf("Runs every input through the fuzz target once and fails on the first crash or budget violation.\n\n");
+	printf("options:\n");
+	printf("  -timeout=<seconds>      Time budget per input (default: 10, 0 to disable)\n");
+	printf("  -alloc_budget_mb=<mb>   Total allocation budget per input (default: 2048, 0 to disable)\n");
+	printf("\nOther options starting with '-' are ignored, so the same command line works with libFuzzer builds.\n");
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int timeout = 10;
+	size_t memory_budget = size_t(2048) << 20;
+	std::vector<std::filesystem::path> inputs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char *const arg = argv[i];
+
+		if (strcmp(arg, "-help=1") == 0 || strcmp(arg, "--help") == 0)
+		{
+			print_usage(argv[0]);
+			return 0;
+		}
+		else if (strncmp(arg, "-timeout=", 9) == 0)
+			timeout = static_cast<unsigned int>(strtoul(arg + 9, nullptr, 10));
+		else if (strncmp(arg, "-alloc_budget_mb=", 17) == 0)
+			memory_budget = static_cast<size_t>(strtoull(arg + 17, nullptr, 10)) << 20;
+		else if (arg[0] == '-')
+			continue;
+		else if (std::error_code ec; std::filesystem::is_directory(arg, ec))
+		{
+			for (const auto &entry : std::filesystem::recursive_directory_iterator(arg, ec))
+				if (entry.is_regular_file(ec))
+					inputs.push_back(entry.path());
+		}
+		else
+			inputs.push_back(arg);
+	}
+
+	if (inputs.empty())
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	std::sort(inputs.begin(), inputs.end());
+
+	// The watchdog aborts the process when an input takes longer than the time budget, since there is no way to interrupt the compiler
+	// The generation counter is odd while an input is running and is incremented both before and after each run
+	std::mutex watchdog_mutex;
+	std::condition_variable watchdog_signal;
+	size_t generation = 0;
+	bool finished = false;
+	std::thread watchdog([&]() {
+		std::unique_lock<std::mutex> lock(watchdog_mutex);
+		while (true)
+		{
+			watchdog_signal.wait(lock, [&]() { return finished || (generation % 2) != 0; });
+			if (finished)
+				break;
+
+			const size_t running = generation;
+			if (timeout == 0)
+				watchdog_signal.wait(lock, [&]() { return finished || generation != running; });
+			else if (!watchdog_signal.wait_for(lock, std::chrono::seconds(timeout), [&]() { return finished || generation != running; }))
+			{
+				fprintf(stderr, "==ERROR: input \"%s\" exceeded the time budget of %u seconds\n", s_current_input, timeout);
+				std::_Exit(1);
+			}
+		}
+	});
+
+	const auto advance_generation = [&]() {
+		{
+			const std::lock_guard<std::mutex> lock(watchdog_mutex);
+			generation++;
+		}
+		watchdog_signal.notify_one();
+	};
+
+	double slowest_time = 0.0;
+	std::string slowest_input;
+
+	for (const std::filesystem::path &path : inputs)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			fprintf(stderr, "error: could not open \"%s\"\n", path.u8string().c_str());
+			continue;
+		}
+
+		const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		const std::string name = path.u8string();
+
+		s_current_input = name.c_str();
+		s_allocated_bytes = 0;
+		s_memory_budget = memory_budget;
+		advance_generation();
+
+		const auto start = std::chrono::steady_clock::now();
+		LLVMFuzzerTestOneInput(data.data(), data.size());
+		const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		advance_generation();
+		s_memory_budget = 0;
+
+		printf("%s: %zu bytes in %.2f ms, %zu KB allocated\n", name.c_str(), data.size(), elapsed, s_allocated_bytes.load() >> 10);
+
+		if (elapsed >= slowest_time)
+			slowest_time = elapsed, slowest_input = name;
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(watchdog_mutex);
+		finished = true;
+	}
+	watchdog_signal.notify_one();
+	watchdog.join();
+
+	printf("Executed %zu inputs, slowest was \"%s\" with %.2f ms\n", inputs.size(), slowest_input.c_str(), slowest_time);
+
+	return 0;
+}
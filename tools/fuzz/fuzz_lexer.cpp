@@ -0,0 +1,35 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_lexer.hpp"
+#include <cstdlib>
+
+/// <summary>
+/// Fuzzing entry point for the lexer, which tokenizes arbitrary input until the end of the file is reached.
+/// The first byte of the input selects the lexer options, so that all combinations are covered.
+/// </summary>
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size == 0)
+		return 0;
+
+	const uint8_t flags = data[0];
+
+	reshadefx::lexer lexer(
+		std::string(reinterpret_cast<const char *>(data + 1), size - 1),
+		(flags & 0x01) != 0,
+		(flags & 0x02) != 0,
+		(flags & 0x04) != 0,
+		(flags & 0x08) != 0,
+		(flags & 0x10) != 0,
+		(flags & 0x20) != 0);
+
+	// Every token consumes at least one character, so more tokens than characters means the lexer got stuck
+	for (size_t num_tokens = 0; lexer.lex().id != reshadefx::tokenid::end_of_file; ++num_tokens)
+		if (num_tokens > size)
+			std::abort();
+
+	return 0;
+}
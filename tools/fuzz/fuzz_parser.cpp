@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include "effect_preprocessor.hpp"
+#include <memory>
+
+/// <summary>
+/// Fuzzing entry point for the parser and code generation, which preprocesses and parses arbitrary input and then writes the result of the selected back-end.
+/// The first byte of the input selects the back-end and its options, so that all of them are covered.
+/// </summary>
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size == 0)
+		return 0;
+
+	const uint8_t flags = data[0];
+
+	std::string source(reinterpret_cast<const char *>(data + 1), size - 1);
+	source.push_back('\n');
+
+	reshadefx::preprocessor pp;
+	pp.add_macro_definition("__RESHADE__", "40300");
+	pp.add_macro_definition("BUFFER_WIDTH", "800");
+	pp.add_macro_definition("BUFFER_HEIGHT", "600");
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+
+	if (!pp.append_string(source))
+		return 0;
+
+	const bool debug_info = (flags & 0x04) != 0;
+	const bool uniforms_to_spec_constants = (flags & 0x08) != 0;
+	const bool optimize_uniform_layout = (flags & 0x10) != 0;
+	const bool split_uniform_buffers = (flags & 0x20) != 0;
+
+	std::unique_ptr<reshadefx::codegen> backend;
+	switch (flags & 0x3)
+	{
+	case 0:
+		backend.reset(reshadefx::create_codegen_hlsl(30, debug_info, uniforms_to_spec_constants, optimize_uniform_layout, split_uniform_buffers));
+		break;
+	case 1:
+		backend.reset(reshadefx::create_codegen_hlsl(50, debug_info, uniforms_to_spec_constants, optimize_uniform_layout, split_uniform_buffers));
+		break;
+	case 2:
+		backend.reset(reshadefx::create_codegen_glsl(debug_info, uniforms_to_spec_constants, optimize_uniform_layout, split_uniform_buffers));
+		break;
+	case 3:
+		backend.reset(reshadefx::create_codegen_spirv(debug_info, uniforms_to_spec_constants, optimize_uniform_layout));
+		break;
+	}
+
+	reshadefx::parser parser;
+
+	// Code generation is only valid for effects that parsed without errors
+	if (parser.parse(std::move(pp.output()), backend.get()))
+	{
+		reshadefx::module module;
+		backend->write_result(module);
+	}
+
+	return 0;
+}
@@ -0,0 +1,27 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_preprocessor.hpp"
+
+/// <summary>
+/// Fuzzing entry point for the preprocessor, which runs arbitrary input through <see cref="reshadefx::preprocessor::append_string"/>.
+/// </summary>
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	// The preprocessor requires input strings to end with a line feed
+	std::string source(reinterpret_cast<const char *>(data), size);
+	source.push_back('\n');
+
+	reshadefx::preprocessor pp;
+	pp.add_macro_definition("__RESHADE__", "40300");
+	pp.add_macro_definition("BUFFER_WIDTH", "800");
+	pp.add_macro_definition("BUFFER_HEIGHT", "600");
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+
+	pp.append_string(source);
+
+	return 0;
+}
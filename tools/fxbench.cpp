@@ -0,0 +1,656 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include "effect_preprocessor.hpp"
+#include "version.h"
+#include "alloc_stats.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <functional>
+
+void print_usage(const char *path)
+{
+	printf(R"(usage: %s [options] [<filename> ...]
+
+Compiles a corpus of effects through every stage of the ReShade FX compiler and reports throughput and memory allocations of each stage.
+The corpus consists of a set of generated effects that stress specific parts of the compiler, plus all effect files (or directories containing .fx files) passed on the command-line.
+
+Options:
+  -h, --help                Print this help.
+
+  -I <path>                 Add directory to include search path.
+  --scale <value>           Multiply the size of the generated effects by this factor. Defaults to 1.
+  --iterations <count>      Compile every effect this many times and report the fastest run. Defaults to 5.
+  --no-generated            Only benchmark the effects passed on the command-line.
+  --dump <path>             Write the generated effects to this directory, e.g. to inspect them or to use them with fxc.
+
+  --baseline <file>         Compare the results against a baseline file and fail if any stage regressed.
+  --write-baseline <file>   Write the results to a baseline file.
+  --tolerance <percent>     Allowed throughput regression compared to the baseline before failing. Defaults to 20.
+	)", path);
+}
+
+/// <summary>
+/// An effect to benchmark, either generated or loaded from disk.
+/// </summary>
+struct benchmark_input
+{
+	std::string name;
+	std::string source;
+	std::filesystem::path path; // Empty for generated effects
+	size_t num_lines = 0;
+};
+
+/// <summary>
+/// Result of one compiler stage for one effect.
+/// </summary>
+struct stage_result
+{
+	std::string input;
+	std::string stage;
+	double time_ms = 0.0;
+	double lines_per_second = 0.0;
+	size_t num_allocations = 0;
+	size_t num_allocated_bytes = 0;
+};
+
+// -- Generators -- //
+
+/// <summary>
+/// An effect with the structure of a typical post-processing effect: a few textures, a multi-pass technique, separable blur loops and a handful of helper functions.
+/// </summary>
+static std::string generate_typical(unsigned int scale)
+{
+	std::string source = R"(
+uniform float Intensity < ui_type = "slider"; ui_min = 0.0; ui_max = 2.0; ui_label = "Intensity"; > = 1.0;
+uniform float Threshold < ui_type = "slider"; ui_min = 0.0; ui_max = 1.0; > = 0.8;
+uniform float3 Tint < ui_type = "color"; > = float3(1.0, 0.95, 0.9);
+uniform int BlurSteps < ui_type = "slider"; ui_min = 1; ui_max = 16; > = 8;
+uniform float Timer < source = "timer"; >;
+
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+texture BloomTex1 { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA16F; };
+sampler BloomSampler1 { Texture = BloomTex1; };
+texture BloomTex2 { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA16F; };
+sampler BloomSampler2 { Texture = BloomTex2; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+
+float Luminance(float3 color)
+{
+	return dot(color, float3(0.2126, 0.7152, 0.0722));
+}
+)";
+
+	// Each "layer" adds another set of passes and helper functions, like effects that combine several features
+	for (unsigned int i = 0; i < 8 * scale; ++i)
+	{
+		const std::string n = std::to_string(i);
+		source += R"(
+float3 Tonemap)" + n + R"((float3 color)
+{
+	color *= Intensity * )" + n + R"(.5;
+	return color / (1.0 + Luminance(color));
+}
+float4 BrightPassPS)" + n + R"((float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float3 color = tex2D(BackBuffer, uv).rgb;
+	return float4(max(color - Threshold, 0.0) * Tint, 1.0);
+}
+float4 BlurPS)" + n + R"((float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float3 color = 0.0;
+	float weight_sum = 0.0;
+	[loop]
+	for (int i = -BlurSteps; i <= BlurSteps; i++)
+	{
+		const float weight = exp(-(i * i) / (2.0 * BlurSteps * BlurSteps));
+		color += tex2Dlod(BloomSampler1, float4(uv + float2(i * BUFFER_RCP_WIDTH * 2.0, 0.0), 0.0, 0.0)).rgb * weight;
+		weight_sum += weight;
+	}
+	return float4(color / weight_sum, 1.0);
+}
+float4 CombinePS)" + n + R"((float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float3 color = tex2D(BackBuffer, uv).rgb;
+	float3 bloom = tex2D(BloomSampler2, uv).rgb;
+	if (Luminance(bloom) > 0.001)
+		color += Tonemap)" + n + R"((bloom) * (0.5 + 0.5 * sin(Timer * 0.001));
+	return float4(saturate(color), 1.0);
+}
+technique Bloom)" + n + R"(
+{
+	pass { VertexShader = PostProcessVS; PixelShader = BrightPassPS)" + n + R"(; RenderTarget = BloomTex1; }
+	pass { VertexShader = PostProcessVS; PixelShader = BlurPS)" + n + R"(; RenderTarget = BloomTex2; }
+	pass { VertexShader = PostProcessVS; PixelShader = CombinePS)" + n + R"(; }
+}
+)";
+	}
+
+	return source;
+}
+
+/// <summary>
+/// An effect which makes heavy use of the preprocessor: thousands of object-like macros, nested function-like macros and long conditional chains.
+/// </summary>
+static std::string generate_macro_heavy(unsigned int scale)
+{
+	std::string source = R"(
+#define SQR(x) ((x) * (x))
+#define LERP(a, b, t) ((a) + ((b) - (a)) * (t))
+#define SMOOTH(x) LERP(SQR(x), x, 0.5)
+#define NEST1(x) SMOOTH(x)
+#define NEST2(x) NEST1(NEST1(x))
+#define NEST3(x) NEST2(NEST1(x))
+#define CONCAT_IMPL(a, b) a##b
+#define CONCAT(a, b) CONCAT_IMPL(a, b)
+#define STRINGIZE(x) #x
+)";
+
+	const unsigned int num_macros = 2000 * scale;
+	for (unsigned int i = 0; i < num_macros; ++i)
+		source += "#define VALUE_" + std::to_string(i) + " (" + std::to_string(i % 97) + ".0 / 97.0)\n";
+
+	for (unsigned int i = 0; i < num_macros; i += 10)
+		source += "#if defined(VALUE_" + std::to_string(i) + ") && (" + std::to_string(i) + " % 3 == 0 || !defined(UNDEFINED_" + std::to_string(i) + "))\n"
+			"#define SELECTED_" + std::to_string(i) + " VALUE_" + std::to_string(i) + "\n"
+			"#elif " + std::to_string(i) + " > 10\n"
+			"#define SELECTED_" + std::to_string(i) + " 1.0\n"
+			"#else\n"
+			"#define SELECTED_" + std::to_string(i) + " 0.0\n"
+			"#endif\n";
+
+	source += R"(
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+float4 MacroPS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float CONCAT(value, _sum) = 0.0;
+)";
+
+	for (unsigned int i = 0; i < num_macros; i += 10)
+		source += "\tvalue_sum += NEST2(uv.x * SELECTED_" + std::to_string(i) + ") + VALUE_" + std::to_string(i + 1) + ";\n";
+
+	source += R"(
+	return float4(value_sum, uv, 1.0);
+}
+technique Macros < ui_label = STRINGIZE(macro heavy); >
+{
+	pass { VertexShader = PostProcessVS; PixelShader = MacroPS; }
+}
+)";
+
+	return source;
+}
+
+/// <summary>
+/// An effect with deeply nested control flow and expressions, which stresses the recursive descent parser and the structured control flow generation.
+/// </summary>
+static std::string generate_deep_nesting(unsigned int scale)
+{
+	std::string source = R"(
+uniform int Selector = 3;
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+)";
+
+	const unsigned int depth = 48;
+
+	for (unsigned int f = 0; f < 4 * scale; ++f)
+	{
+		source += "float Nested" + std::to_string(f) + "(float2 uv)\n{\n\tfloat value = 0.0;\n";
+
+		std::string indent = "\t";
+		for (unsigned int i = 0; i < depth; ++i)
+		{
+			switch (i % 3)
+			{
+			case 0:
+				source += indent + "if (uv.x > " + std::to_string(i) + ".0 / " + std::to_string(depth) + ".0)\n" + indent + "{\n";
+				break;
+			case 1:
+				source += indent + "for (int i" + std::to_string(i) + " = 0; i" + std::to_string(i) + " < 2; i" + std::to_string(i) + "++)\n" + indent + "{\n";
+				break;
+			case 2:
+				source += indent + "switch (Selector)\n" + indent + "{\n" + indent + "case 0:\n" + indent + "\tvalue -= 1.0;\n" + indent + "\tbreak;\n" + indent + "default:\n" + indent + "{\n";
+				break;
+			}
+			indent += '\t';
+			source += indent + "value += uv.y * " + std::to_string(i) + ".0;\n";
+		}
+
+		// Deeply parenthesized expression in the innermost block
+		source += indent + "value += ";
+		for (unsigned int i = 0; i < depth * 4; ++i)
+			source += "(uv.x + ";
+		source += "1.0";
+		for (unsigned int i = 0; i < depth * 4; ++i)
+			source += ')';
+		source += ";\n";
+
+		for (unsigned int i = depth; i-- > 0;)
+		{
+			indent.pop_back();
+			if (i % 3 == 2)
+				source += indent + "\tbreak;\n" + indent + "}\n";
+			source += indent + "}\n";
+		}
+
+		source += "\treturn value;\n}\n";
+	}
+
+	source += "float4 NestedPS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target\n{\n\tfloat value = 0.0;\n";
+	for (unsigned int f = 0; f < 4 * scale; ++f)
+		source += "\tvalue += Nested" + std::to_string(f) + "(uv);\n";
+	source += "\treturn value;\n}\ntechnique Nesting\n{\n\tpass { VertexShader = PostProcessVS; PixelShader = NestedPS; }\n}\n";
+
+	return source;
+}
+
+/// <summary>
+/// An effect with thousands of annotated uniform variables of different types, which stresses uniform layout and the annotation handling.
+/// </summary>
+static std::string generate_many_uniforms(unsigned int scale)
+{
+	static const char *const types[] = { "float", "float2", "float3", "float4", "int", "bool", "float4x4", "uint2" };
+	static const char *const initializers[] = { "1.0", "float2(0.5, 0.5)", "float3(1.0, 0.0, 0.0)", "float4(1.0, 1.0, 1.0, 1.0)", "2", "true", "float4x4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1)", "uint2(1, 2)" };
+
+	std::string source;
+
+	const unsigned int num_uniforms = 2000 * scale;
+	for (unsigned int i = 0; i < num_uniforms; ++i)
+	{
+		const unsigned int t = i % 8;
+		source += "uniform " + std::string(types[t]) + " Uniform" + std::to_string(i) + " < ui_type = \"drag\"; ui_min = 0.0; ui_max = " + std::to_string(i) + ".0; ui_label = \"Uniform " + std::to_string(i) + "\"; ui_tooltip = \"Generated uniform variable\"; > = " + initializers[t] + ";\n";
+	}
+
+	source += R"(
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+float4 UniformPS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float4 value = 0.0;
+)";
+
+	for (unsigned int i = 0; i < num_uniforms; i += 8)
+		source += "\tvalue.x += Uniform" + std::to_string(i) + "; value.xy += Uniform" + std::to_string(i + 1) + "; value = mul(value, Uniform" + std::to_string(i + 6) + ");\n";
+
+	source += "\treturn value;\n}\ntechnique Uniforms\n{\n\tpass { VertexShader = PostProcessVS; PixelShader = UniformPS; }\n}\n";
+
+	return source;
+}
+
+/// <summary>
+/// An effect with a long list of techniques and passes, which stresses entry point generation and technique handling.
+/// </summary>
+static std::string generate_many_techniques(unsigned int scale)
+{
+	std::string source = R"(
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+texture TargetTex { Width = 256; Height = 256; Format = RGBA8; };
+sampler TargetSampler { Texture = TargetTex; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+)";
+
+	const unsigned int num_shaders = 50;
+	for (unsigned int i = 0; i < num_shaders; ++i)
+		source += "float4 PS" + std::to_string(i) + "(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target\n{\n\treturn tex2D(" + (i % 2 ? "TargetSampler" : "BackBuffer") + ", uv) * " + std::to_string(i) + ".0;\n}\n";
+
+	for (unsigned int i = 0; i < 250 * scale; ++i)
+	{
+		source += "technique Technique" + std::to_string(i) + " < ui_label = \"Technique " + std::to_string(i) + "\"; enabled = " + (i % 2 ? "true" : "false") + "; >\n{\n";
+		for (unsigned int p = 0; p < 4; ++p)
+			source += "\tpass Pass" + std::to_string(p) + " { VertexShader = PostProcessVS; PixelShader = PS" + std::to_string((i + p) % num_shaders) + ";" + (p % 2 ? " RenderTarget = TargetTex;" : " BlendEnable = true; SrcBlend = SRCALPHA; DestBlend = INVSRCALPHA;") + " }\n";
+		source += "}\n";
+	}
+
+	return source;
+}
+
+// -- Benchmark -- //
+
+/// <summary>
+/// Run a compiler stage on an effect several times and keep the fastest run. Allocations are deterministic, so they are taken from the first run.
+/// </summary>
+static stage_result measure_stage(const benchmark_input &input, const char *stage, unsigned int iterations, const std::function<void()> &setup, const std::function<bool()> &run)
+{
+	stage_result result;
+	result.input = input.name;
+	result.stage = stage;
+	result.time_ms = std::numeric_limits<double>::max();
+
+	for (unsigned int i = 0; i < iterations; ++i)
+	{
+		setup();
+
+		const size_t num_allocations = get_num_allocations();
+		const size_t num_allocated_bytes = get_num_allocated_bytes();
+		const auto start_time = std::chrono::high_resolution_clock::now();
+
+		if (!run())
+		{
+			std::cout << "error: " << input.name << " failed to compile in stage " << stage << std::endl;
+			std::exit(1);
+		}
+
+		const double time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+		if (i == 0)
+		{
+			result.num_allocations = get_num_allocations() - num_allocations;
+			result.num_allocated_bytes = get_num_allocated_bytes() - num_allocated_bytes;
+		}
+
+		result.time_ms = std::min(result.time_ms, time_ms);
+	}
+
+	result.lines_per_second = input.num_lines / (std::max(result.time_ms, 0.001) / 1000.0);
+
+	return result;
+}
+
+static void benchmark_effect(const benchmark_input &input, const std::vector<std::filesystem::path> &include_paths, unsigned int iterations, std::vector<stage_result> &results)
+{
+	const auto configure_preprocessor = [&](reshadefx::preprocessor &pp) {
+		pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
+		pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", "0");
+		pp.add_macro_definition("BUFFER_WIDTH", "800");
+		pp.add_macro_definition("BUFFER_HEIGHT", "600");
+		pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+		pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+		for (const auto &include_path : include_paths)
+			pp.add_include_path(include_path);
+	};
+
+	std::unique_ptr<reshadefx::preprocessor> pp;
+	results.push_back(measure_stage(input, "preprocess", iterations,
+		[&]() { pp = std::make_unique<reshadefx::preprocessor>(); configure_preprocessor(*pp); },
+		[&]() {
+			if (!input.path.empty())
+				return pp->append_file(input.path);
+			else
+				return pp->append_string(input.source);
+		}));
+
+	const std::string preprocessed = pp->output();
+
+	results.push_back(measure_stage(input, "lex", iterations, []() {},
+		[&]() {
+			reshadefx::lexer lexer(preprocessed);
+			while (lexer.lex().id != reshadefx::tokenid::end_of_file)
+				continue;
+			return true;
+		}));
+
+	std::unique_ptr<reshadefx::parser> parser;
+	std::unique_ptr<reshadefx::codegen> recording;
+	results.push_back(measure_stage(input, "parse", iterations,
+		[&]() { parser = std::make_unique<reshadefx::parser>(); recording.reset(reshadefx::create_codegen_recorder()); },
+		[&]() { return parser->parse(preprocessed, recording.get()); }));
+
+	const auto measure_codegen = [&](const char *stage, const std::function<reshadefx::codegen *()> &create_backend) {
+		std::unique_ptr<reshadefx::codegen> backend;
+		results.push_back(measure_stage(input, stage, iterations,
+			[&]() { backend.reset(create_backend()); },
+			[&]() {
+				reshadefx::module module;
+				reshadefx::replay_codegen(*recording, *backend);
+				backend->write_result(module);
+				return true;
+			}));
+	};
+
+	measure_codegen("codegen_hlsl", []() { return reshadefx::create_codegen_hlsl(50, false, false, false, false); });
+	measure_codegen("codegen_glsl", []() { return reshadefx::create_codegen_glsl(false, false, false, false); });
+	measure_codegen("codegen_spirv", []() { return reshadefx::create_codegen_spirv(false, false, false); });
+}
+
+/// <summary>
+/// Compare results against a baseline file, which contains one "input stage lines_per_second allocations" entry per line.
+/// Throughput may be lower than the baseline by the specified tolerance, since it depends on the machine, but the number of allocations is deterministic and may not grow by more than 1%.
+/// </summary>
+static bool compare_baseline(const std::vector<stage_result> &results, const char *path, double tolerance)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << "error: could not open baseline file " << path << std::endl;
+		return false;
+	}
+
+	bool success = true;
+
+	for (std::string line; std::getline(file, line);)
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream entry(line);
+		std::string input, stage;
+		double lines_per_second = 0.0;
+		size_t num_allocations = 0;
+		if (!(entry >> input >> stage >> lines_per_second >> num_allocations))
+			continue;
+
+		const auto result = std::find_if(results.begin(), results.end(),
+			[&input, &stage](const stage_result &result) { return result.input == input && result.stage == stage; });
+		if (result == results.end())
+			continue;
+
+		if (result->lines_per_second < lines_per_second * (1.0 - tolerance / 100.0))
+		{
+			printf("regression: %s %s throughput dropped from %.0f to %.0f lines/s\n", input.c_str(), stage.c_str(), lines_per_second, result->lines_per_second);
+			success = false;
+		}
+		if (result->num_allocations > num_allocations + num_allocations / 100)
+		{
+			printf("regression: %s %s allocations increased from %zu to %zu\n", input.c_str(), stage.c_str(), num_allocations, result->num_allocations);
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<const char *> inputs;
+	std::vector<std::filesystem::path> include_paths;
+	const char *dump_path = nullptr;
+	const char *baseline_path = nullptr;
+	const char *write_baseline_path = nullptr;
+	unsigned int scale = 1;
+	unsigned int iterations = 5;
+	double tolerance = 20.0;
+	bool generated = true;
+
+	// Parse command-line arguments
+	for (int i = 1; i < argc; ++i)
+	{
+		if (const char *arg = argv[i]; arg[0] == '-')
+		{
+			if (0 == strcmp(arg, "-h") || 0 == strcmp(arg, "--help"))
+			{
+				print_usage(argv[0]);
+				return 0;
+			}
+			else if (0 == strcmp(arg, "-I"))
+			{
+				include_paths.push_back(std::filesystem::u8path(argv[++i]));
+			}
+			else if (0 == strcmp(arg, "--scale"))
+			{
+				scale = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (0 == strcmp(arg, "--iterations"))
+			{
+				iterations = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (0 == strcmp(arg, "--no-generated"))
+			{
+				generated = false;
+			}
+			else if (0 == strcmp(arg, "--dump"))
+			{
+				dump_path = argv[++i];
+			}
+			else if (0 == strcmp(arg, "--baseline"))
+			{
+				baseline_path = argv[++i];
+			}
+			else if (0 == strcmp(arg, "--write-baseline"))
+			{
+				write_baseline_path = argv[++i];
+			}
+			else if (0 == strcmp(arg, "--tolerance"))
+			{
+				tolerance = std::strtod(argv[++i], nullptr);
+			}
+		}
+		else
+		{
+			inputs.push_back(arg);
+		}
+	}
+
+	std::vector<benchmark_input> corpus;
+
+	if (generated)
+	{
+		const std::pair<const char *, std::string (*)(unsigned int)> generators[] = {
+			{ "typical", generate_typical },
+			{ "macro_heavy", generate_macro_heavy },
+			{ "deep_nesting", generate_deep_nesting },
+			{ "many_uniforms", generate_many_uniforms },
+			{ "many_techniques", generate_many_techniques },
+		};
+
+		for (const auto &generator : generators)
+		{
+			benchmark_input &input = corpus.emplace_back();
+			input.name = generator.first;
+			input.source = generator.second(scale);
+		}
+	}
+
+	for (const char *path : inputs)
+	{
+		std::error_code ec;
+		std::vector<std::filesystem::path> files;
+
+		if (std::filesystem::is_directory(std::filesystem::u8path(path), ec))
+		{
+			for (const auto &entry : std::filesystem::recursive_directory_iterator(std::filesystem::u8path(path), ec))
+				if (entry.path().extension() == ".fx")
+					files.push_back(entry.path());
+			std::sort(files.begin(), files.end());
+		}
+		else
+		{
+			files.push_back(std::filesystem::u8path(path));
+		}
+
+		for (const auto &file_path : files)
+		{
+			std::ifstream file(file_path);
+			if (!file.is_open())
+			{
+				std::cout << "error: could not open " << file_path.u8string() << std::endl;
+				return 1;
+			}
+
+			benchmark_input &input = corpus.emplace_back();
+			input.name = file_path.filename().u8string();
+			input.source.assign(std::istreambuf_iterator<char>(file.rdbuf()), std::istreambuf_iterator<char>());
+			input.path = file_path;
+		}
+	}
+
+	for (benchmark_input &input : corpus)
+	{
+		// The preprocessor requires input strings to end with a line feed
+		if (input.source.empty() || input.source.back() != '\n')
+			input.source.push_back('\n');
+
+		input.num_lines = std::count(input.source.begin(), input.source.end(), '\n');
+
+		if (dump_path != nullptr && input.path.empty())
+		{
+			std::error_code ec;
+			std::filesystem::create_directories(std::filesystem::u8path(dump_path), ec);
+			std::ofstream(std::filesystem::u8path(dump_path) / (input.name + ".fx")) << input.source;
+		}
+	}
+
+	if (corpus.empty())
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	std::vector<stage_result> results;
+
+	printf("%-20s %-14s %10s %12s %14s %12s %14s\n", "effect", "stage", "lines", "time (ms)", "lines/s", "allocations", "alloc. bytes");
+
+	for (const benchmark_input &input : corpus)
+	{
+		const size_t first_result = results.size();
+
+		benchmark_effect(input, include_paths, iterations, results);
+
+		for (size_t i = first_result; i < results.size(); ++i)
+			printf("%-20s %-14s %10zu %12.3f %14.0f %12zu %14zu\n", input.name.c_str(), results[i].stage.c_str(), input.num_lines, results[i].time_ms, results[i].lines_per_second, results[i].num_allocations, results[i].num_allocated_bytes);
+	}
+
+	if (write_baseline_path != nullptr)
+	{
+		std::ofstream file(write_baseline_path);
+		file << "# ReShade FX compiler benchmark baseline (scale " << scale << ")\n";
+		file << "# Throughput depends on the machine, regenerate with \"fxbench --write-baseline <file>\" when switching machines\n";
+		file << "# input stage lines_per_second allocations\n";
+
+		for (const stage_result &result : results)
+			file << result.input << ' ' << result.stage << ' ' << static_cast<uint64_t>(result.lines_per_second) << ' ' << result.num_allocations << '\n';
+	}
+
+	if (baseline_path != nullptr && !compare_baseline(results, baseline_path, tolerance))
+		return 1;
+
+	return 0;
+}
@@ -6,14 +6,38 @@
 #include "effect_parser.hpp"
 #include "effect_codegen.hpp"
 #include "effect_preprocessor.hpp"
+#include "effect_module_cache.hpp"
 #include "version.h"
+#include "alloc_stats.hpp"
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
+#include <thread>
 #include <fstream>
 #include <iostream>
+#include <functional>
+#include <unordered_set>
+#ifndef _WIN32
+#include <cerrno>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#endif
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
 
 void print_usage(const char *path)
 {
-	printf(R"(usage: %s [options] <filename>
+	printf(R"(usage: %s [options] <filename> [<filename> ...]
 
 Options:
   -h, --help                Print this help.
@@ -25,34 +49,932 @@ Options:
 
   -Fo <file>                Output SPIR-V binary to the given file.
   -Fe <file>                Output warnings and errors to the given file.
+  -Fh <file>                Output HLSL code for the previously specified shader model to the given file. Can be specified multiple times.
+  -Fg <file>                Output GLSL code to the given file.
+  -Fc <file>                Output the complete compiled module (code, uniforms, textures, samplers and techniques) in the cache format ReShade loads instead of compiling the effect.
+                            Uses the back-end selected with --glsl, --hlsl and --shader-model (SPIR-V otherwise). Cannot be combined with -Fh or -Fg.
+                            The runtime only uses the cache with the options it compiles with (-Zi --pack-uniforms, plus --split-uniforms if enabled in its configuration).
+
+  When -Fh or -Fg is used, the effect is parsed only once and code for all requested outputs (including -Fo) is generated in parallel.
 
   --glsl                    Print GLSL code for the previously specified entry point.
   --hlsl                    Print HLSL code for the previously specified entry point.
   --shader-model <value>    HLSL shader model version. Can be 30, 40, 41, 50, ...
+  --pack-uniforms           Reorder uniform variables to minimize padding and report the bytes saved.
+  --split-uniforms          Put uniform variables with a "source" annotation into a separate buffer (GLSL and HLSL only).
 
   -Zi                       Enable debug information.
+
+  --stats                   Compile with all back-ends and print time, memory allocations and output size of every compiler phase instead of writing any output.
+  --stats-json <file>       Same as --stats, but write the statistics as JSON to the given file. If <file> is "-", then the result is written to standard output instead.
+
+  -j <count>                Number of worker threads to use in batch mode. Defaults to the number of processor cores.
+  --output-dir <path>       Write the output of each effect to this directory in batch mode, using the effect file name with a .spv, .hlsl or .glsl extension.
+                            Effects that generate the same code share a single file through hard links.
+  --cache                   Write module cache files like -Fc in batch and watch mode, using the .fxcache extension. Place them next to the effects to ship precompiled effects.
+
+  --watch <path>            Compile all effects in the given directory and then recompile the effects affected by every change to them or the files they include, until terminated.
+                            Uses the same back-end and output options as batch mode.
+
+  --serve <socket>          Listen for compile requests on the given Unix domain socket instead of compiling any inputs. Included files stay cached between requests.
+
+  A request consists of "<key> <value>" lines followed by an empty line. Keys are "file" (the effect to compile, required), "define" (<id>=<text>), "include" (a path),
+  "backend" ("spirv", "glsl" or "hlsl"), "shader-model" and "option" ("debug-info", "pack-uniforms" or "split-uniforms"). Macros and include paths from the command-line apply to all requests.
+  Each response consists of a "result success" or "result failure" line, an "errors <size>" line followed by that many bytes of diagnostics and a line feed,
+  and a "module <size>" line followed by that many bytes of SPIR-V or code and a line feed. A connection can be used for any number of requests.
+
+  Batch mode is used when more than one input is specified, or an input is a directory, a wildcard pattern (e.g. "shaders/*.fx") or a response file (e.g. "@effects.txt", containing one input per line).
+  All effects are then compiled in parallel and a summary is printed at the end. Directories are searched recursively for .fx files.
 	)", path);
 }
 
+/// <summary>
+/// Measurements of a single compiler phase for the "--stats" option.
+/// </summary>
+struct phase_stats
+{
+	const char *name;
+	double time_ms;
+	size_t num_allocations;
+	size_t num_allocated_bytes;
+	size_t output_size;
+	const char *output_unit;
+};
+
+/// <summary>
+/// Run a compiler phase and measure its wall time and the memory allocations it makes.
+/// </summary>
+template <typename F>
+static phase_stats measure_phase(const char *name, const char *output_unit, F &&phase)
+{
+	const size_t num_allocations = get_num_allocations();
+	const size_t num_allocated_bytes = get_num_allocated_bytes();
+	const auto start_time = std::chrono::high_resolution_clock::now();
+
+	const size_t output_size = phase();
+
+	phase_stats stats;
+	stats.name = name;
+	stats.time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+	stats.num_allocations = get_num_allocations() - num_allocations;
+	stats.num_allocated_bytes = get_num_allocated_bytes() - num_allocated_bytes;
+	stats.output_size = output_size;
+	stats.output_unit = output_unit;
+	return stats;
+}
+
+/// <summary>
+/// Compile an effect with every back-end, one phase after another, and report statistics about each phase.
+/// Parsing is done into a recording back-end, so that the time spent in the parser and the time spent generating code can be measured separately.
+/// </summary>
+static int compile_with_stats(const char *filename, reshadefx::preprocessor &pp, unsigned int shader_model, bool debug_info, bool pack_uniforms, bool split_uniforms, bool print_stats, const char *json_path, const char *errorfile)
+{
+	std::vector<phase_stats> phases;
+
+	bool success = true;
+	phases.push_back(measure_phase("preprocess", "bytes", [&]() {
+		success = pp.append_file(filename);
+		return pp.output().size();
+	}));
+
+	phases.push_back(measure_phase("lex", "tokens", [&]() {
+		size_t num_tokens = 0;
+		reshadefx::lexer lexer(pp.output());
+		while (lexer.lex().id != reshadefx::tokenid::end_of_file)
+			num_tokens++;
+		return num_tokens;
+	}));
+
+	reshadefx::parser parser;
+	const std::unique_ptr<reshadefx::codegen> recording(reshadefx::create_codegen_recorder());
+
+	if (success)
+	{
+		phases.push_back(measure_phase("parse", "ids", [&]() {
+			success = parser.parse(pp.output(), recording.get());
+			return recording->id_count();
+		}));
+	}
+
+	if (!success)
+	{
+		if (errorfile == nullptr)
+			std::cout << pp.errors() << parser.errors() << std::endl;
+		else
+			std::ofstream(errorfile) << pp.errors() << parser.errors();
+		return 1;
+	}
+
+	const auto measure_codegen = [&](const char *name, const char *output_unit, reshadefx::codegen *backend) {
+		const std::unique_ptr<reshadefx::codegen> backend_holder(backend);
+		phases.push_back(measure_phase(name, output_unit, [&]() {
+			reshadefx::module module;
+			reshadefx::replay_codegen(*recording, *backend);
+			backend->write_result(module);
+			return module.spirv.empty() ? module.hlsl.size() : module.spirv.size();
+		}));
+	};
+
+	measure_codegen("codegen_hlsl", "bytes", reshadefx::create_codegen_hlsl(shader_model, debug_info, false, pack_uniforms, split_uniforms));
+	measure_codegen("codegen_glsl", "bytes", reshadefx::create_codegen_glsl(debug_info, false, pack_uniforms, split_uniforms));
+	measure_codegen("codegen_spirv", "words", reshadefx::create_codegen_spirv(debug_info, false, pack_uniforms));
+
+	if (print_stats)
+	{
+		printf("%-16s %12s %12s %14s %12s\n", "phase", "time (ms)", "allocations", "alloc. bytes", "output");
+		for (const phase_stats &stats : phases)
+			printf("%-16s %12.3f %12zu %14zu %12zu %s\n", stats.name, stats.time_ms, stats.num_allocations, stats.num_allocated_bytes, stats.output_size, stats.output_unit);
+	}
+
+	if (json_path != nullptr)
+	{
+		std::string json = "{\n  \"file\": \"";
+		for (const char *c = filename; *c != '\0'; ++c)
+		{
+			if (*c == '\\' || *c == '"')
+				json += '\\';
+			json += *c;
+		}
+		json += "\",\n  \"phases\": [\n";
+
+		for (size_t i = 0; i < phases.size(); ++i)
+		{
+			char line[512];
+			snprintf(line, sizeof(line), "    { \"name\": \"%s\", \"time_ms\": %.3f, \"allocations\": %zu, \"allocated_bytes\": %zu, \"output_size\": %zu, \"output_unit\": \"%s\" }%s\n",
+				phases[i].name, phases[i].time_ms, phases[i].num_allocations, phases[i].num_allocated_bytes, phases[i].output_size, phases[i].output_unit, i + 1 < phases.size() ? "," : "");
+			json += line;
+		}
+
+		json += "  ]\n}\n";
+
+		if (strcmp(json_path, "-") == 0)
+			std::cout << json;
+		else
+			std::ofstream(json_path) << json;
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Check whether a file name matches a pattern with '*' and '?' wildcards.
+/// </summary>
+static bool match_wildcard(const char *pattern, const char *name)
+{
+	for (; *pattern != '\0'; ++pattern, ++name)
+	{
+		if (*pattern == '*')
+		{
+			for (const char *rest = name; ; ++rest)
+				if (match_wildcard(pattern + 1, rest))
+					return true;
+				else if (*rest == '\0')
+					return false;
+		}
+
+		if (*name == '\0' || (*pattern != '?' && *pattern != *name))
+			return false;
+	}
+
+	return *name == '\0';
+}
+
+/// <summary>
+/// Expand a command-line input into the list of effect files to compile, together with the path their output should be written to relative to the output directory.
+/// </summary>
+static bool collect_inputs(const std::string &input, std::vector<std::pair<std::filesystem::path, std::filesystem::path>> &files)
+{
+	std::error_code ec;
+	const size_t first_index = files.size();
+
+	if (input[0] == '@')
+	{
+		std::ifstream file(input.substr(1));
+		if (!file.is_open())
+			return false;
+
+		for (std::string line; std::getline(file, line);)
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			if (line.empty() || line[0] == '#')
+				continue;
+			if (!collect_inputs(line, files))
+				return false;
+		}
+	}
+	else if (const std::filesystem::path path = std::filesystem::u8path(input); std::filesystem::is_directory(path, ec))
+	{
+		for (const auto &entry : std::filesystem::recursive_directory_iterator(path, ec))
+			if (entry.path().extension() == ".fx" && entry.is_regular_file(ec))
+				files.emplace_back(entry.path(), entry.path().lexically_relative(path));
+	}
+	else if (input.find_first_of("*?") != std::string::npos)
+	{
+		const std::string pattern = path.filename().u8string();
+		const std::filesystem::path parent_path = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+
+		for (const auto &entry : std::filesystem::directory_iterator(parent_path, ec))
+			if (entry.is_regular_file(ec) && match_wildcard(pattern.c_str(), entry.path().filename().u8string().c_str()))
+				files.emplace_back(entry.path(), entry.path().filename());
+	}
+	else
+	{
+		files.emplace_back(path, path.filename());
+	}
+
+	// Directory iteration order is unspecified, so sort to get the same order on every run
+	if (input[0] != '@')
+		std::sort(files.begin() + first_index, files.end());
+
+	return !ec;
+}
+
+/// <summary>
+/// Result of compiling a single effect in batch or watch mode.
+/// </summary>
+struct effect_result
+{
+	bool success = false;
+	std::string errors;
+	std::chrono::milliseconds duration;
+	std::vector<std::filesystem::path> included_files;
+	bool shared_output = false; // Whether the output is a link to that of another effect which generated the same code
+};
+
+/// <summary>
+/// Output files written in batch mode, indexed by their contents, so that effects which generate the same code share a single file.
+/// </summary>
+struct output_index
+{
+	std::mutex mutex;
+	std::unordered_map<std::string, std::filesystem::path> files;
+};
+
+/// <summary>
+/// Write a compiled module together with everything needed to check whether it is still up-to-date to a cache file the runtime can load instead of compiling the effect.
+/// </summary>
+static bool write_module_cache_file(const std::filesystem::path &output_path, const reshadefx::module &module, const reshadefx::preprocessor &pp, const std::filesystem::path &effect_path, const char *codegen_key)
+{
+	reshadefx::module_cache_info info;
+	info.compiler_version = VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION;
+	info.codegen_key = codegen_key;
+
+	for (const auto &macro : pp.used_macro_definitions())
+		info.macros.push_back(macro);
+	std::sort(info.macros.begin(), info.macros.end());
+
+	// File paths are stored relative to the effect, so that the cache stays valid when the effect directory is moved somewhere else
+	std::vector<std::filesystem::path> files = pp.included_files();
+	std::sort(files.begin(), files.end());
+	files.insert(files.begin(), effect_path);
+
+	for (const std::filesystem::path &file : files)
+	{
+		uint64_t hash = 0;
+		if (!reshadefx::hash_file(file, hash))
+			return false;
+
+		info.files.emplace_back(file.lexically_relative(effect_path.parent_path()).generic_u8string(), hash);
+	}
+
+	std::vector<uint8_t> data;
+	reshadefx::write_module_cache(module, info, data);
+
+	std::ofstream file(output_path, std::ios::binary);
+	file.write(reinterpret_cast<const char *>(data.data()), data.size());
+	return file.good();
+}
+
+/// <summary>
+/// Compile a single effect and write the output to the specified path (if not empty).
+/// </summary>
+/// <param name="cache_key">Write a module cache file with this code generation key instead of plain code if not <c>nullptr</c>.</param>
+/// <param name="outputs">Hard link the output to an existing file with the same contents instead of writing it again if not <c>nullptr</c>.</param>
+static effect_result compile_effect(const std::filesystem::path &path, const std::filesystem::path &output_path, const char *cache_key, output_index *outputs, const std::shared_ptr<reshadefx::preprocessor::file_cache> &file_cache,
+	const std::function<void(reshadefx::preprocessor &)> &configure_preprocessor, const std::function<reshadefx::codegen *()> &create_backend)
+{
+	effect_result result;
+	const auto start_time = std::chrono::high_resolution_clock::now();
+
+	reshadefx::preprocessor pp;
+	pp.set_shared_file_cache(file_cache);
+	configure_preprocessor(pp);
+
+	if (!pp.append_file(path))
+	{
+		result.errors = pp.errors().empty() ? "error: could not open " + path.u8string() + '\n' : pp.errors();
+	}
+	else
+	{
+		reshadefx::parser parser;
+		const std::unique_ptr<reshadefx::codegen> backend(create_backend());
+
+		result.success = parser.parse(std::move(pp.output()), backend.get());
+		result.errors = pp.errors() + parser.errors();
+
+		if (result.success && !output_path.empty())
+		{
+			reshadefx::module module;
+			backend->write_result(module);
+
+			std::error_code ec;
+			std::filesystem::create_directories(output_path.parent_path(), ec);
+
+			if (cache_key != nullptr)
+			{
+				if (!write_module_cache_file(output_path, module, pp, path, cache_key))
+					result.success = false, result.errors += "error: could not write module cache " + output_path.u8string() + '\n';
+			}
+			else
+			{
+				const bool is_text = module.spirv.empty();
+				std::string data = is_text ? std::move(module.hlsl) : std::string(
+					reinterpret_cast<const char *>(module.spirv.data()), module.spirv.size() * sizeof(uint32_t));
+
+				std::unique_lock<std::mutex> lock;
+				if (outputs != nullptr)
+				{
+					lock = std::unique_lock<std::mutex>(outputs->mutex);
+
+					// Never write through an existing link, since that would modify the output of another effect too
+					std::filesystem::remove(output_path, ec);
+
+					if (const auto [it, inserted] = outputs->files.emplace(data, output_path); !inserted)
+					{
+						std::filesystem::create_hard_link(it->second, output_path, ec);
+						result.shared_output = !ec;
+					}
+				}
+
+				if (!result.shared_output)
+					std::ofstream(output_path, is_text ? std::ios::out : std::ios::binary).write(data.data(), data.size());
+			}
+		}
+	}
+
+	result.included_files = pp.included_files();
+	result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time);
+
+	return result;
+}
+
+/// <summary>
+/// Get the path the output of an effect is written to in batch and watch mode, or an empty path if no output directory was specified.
+/// </summary>
+static std::filesystem::path make_output_path(const char *output_dir, const std::filesystem::path &relative_path, const char *extension)
+{
+	if (output_dir == nullptr)
+		return std::filesystem::path();
+
+	std::filesystem::path output_path = std::filesystem::u8path(output_dir) / relative_path;
+	output_path.replace_extension(extension);
+	return output_path;
+}
+
+/// <summary>
+/// Compile a list of effects on a pool of worker threads.
+/// </summary>
+/// <returns>The results of all effects, in the same order as the input list.</returns>
+static std::vector<effect_result> compile_effects(const std::vector<std::pair<std::filesystem::path, std::filesystem::path>> &files, unsigned int num_threads, const std::shared_ptr<reshadefx::preprocessor::file_cache> &file_cache,
+	const std::function<void(reshadefx::preprocessor &)> &configure_preprocessor, const std::function<reshadefx::codegen *()> &create_backend,
+	const char *output_dir, const char *extension, const char *cache_key, output_index *outputs)
+{
+	std::vector<effect_result> results(files.size());
+	std::atomic_size_t next_index = 0;
+
+	const auto worker = [&]() {
+		for (size_t index; (index = next_index++) < files.size();)
+			results[index] = compile_effect(files[index].first, make_output_path(output_dir, files[index].second, extension), cache_key, outputs, file_cache, configure_preprocessor, create_backend);
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < std::min<size_t>(num_threads, files.size()); ++i)
+		threads.emplace_back(worker);
+	worker();
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	return results;
+}
+
+/// <summary>
+/// Print the status of every effect and all errors that occurred.
+/// </summary>
+/// <returns>The number of effects that failed to compile.</returns>
+static size_t print_results(const std::vector<std::pair<std::filesystem::path, std::filesystem::path>> &files, const std::vector<effect_result> &results, const char *errorfile)
+{
+	// Print results in input order, so that the output does not depend on thread scheduling
+	std::string errors;
+	size_t num_failed = 0;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		errors += results[i].errors;
+
+		if (!results[i].success)
+			num_failed++;
+		std::cout << (results[i].success ? "succeeded" : "FAILED   ") << ' ' << files[i].first.u8string() << " (" << results[i].duration.count() << " ms)" << std::endl;
+	}
+
+	if (errorfile == nullptr)
+		std::cout << errors;
+	else
+		std::ofstream(errorfile) << errors;
+
+	return num_failed;
+}
+
+/// <summary>
+/// Compile a list of effects on a pool of worker threads and print a summary of the results.
+/// </summary>
+static int compile_batch(const std::vector<std::pair<std::filesystem::path, std::filesystem::path>> &files, unsigned int num_threads,
+	const std::function<void(reshadefx::preprocessor &)> &configure_preprocessor, const std::function<reshadefx::codegen *()> &create_backend,
+	const char *output_dir, const char *extension, const char *cache_key, const char *errorfile)
+{
+	// Included files are the same for most effects, so only read them once
+	const auto file_cache = std::make_shared<reshadefx::preprocessor::file_cache>();
+
+	const auto start_time = std::chrono::high_resolution_clock::now();
+
+	// Module cache files contain information specific to each effect, so only plain code can be shared between effects
+	output_index outputs;
+
+	const std::vector<effect_result> results = compile_effects(files, num_threads, file_cache, configure_preprocessor, create_backend, output_dir, extension, cache_key, cache_key == nullptr ? &outputs : nullptr);
+
+	const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time);
+
+	const size_t num_failed = print_results(files, results, errorfile);
+
+	std::cout << files.size() << " effects compiled in " << duration.count() << " ms: " << (files.size() - num_failed) << " succeeded, " << num_failed << " failed" << std::endl;
+
+	if (const size_t num_shared = std::count_if(results.begin(), results.end(), [](const effect_result &result) { return result.shared_output; }); num_shared != 0)
+		std::cout << num_shared << " effects generated the same code as another effect and share its output file" << std::endl;
+
+	return num_failed == 0 ? 0 : 1;
+}
+
+/// <summary>
+/// Compile all effects in a directory and then keep recompiling those affected by file changes, until the process is terminated.
+/// Changes to an included file only recompile the effects that included it during their last compilation.
+/// </summary>
+static int watch(const char *directory, unsigned int num_threads,
+	const std::function<void(reshadefx::preprocessor &)> &configure_preprocessor, const std::function<reshadefx::codegen *()> &create_backend,
+	const char *output_dir, const char *extension, const char *cache_key, const char *errorfile)
+{
+#ifdef __linux__
+	std::error_code ec;
+	const std::filesystem::path root = std::filesystem::weakly_canonical(std::filesystem::u8path(directory), ec);
+	const std::filesystem::path output_root = output_dir != nullptr ? std::filesystem::weakly_canonical(std::filesystem::u8path(output_dir), ec) : std::filesystem::path();
+
+	if (!std::filesystem::is_directory(root, ec))
+	{
+		std::cout << "error: " << directory << " is not a directory" << std::endl;
+		return 1;
+	}
+
+	const auto is_inside = [](const std::filesystem::path &path, const std::filesystem::path &parent) {
+		const std::string relative = path.lexically_relative(parent).u8string();
+		return !parent.empty() && !relative.empty() && relative.compare(0, 2, "..") != 0;
+	};
+
+	struct watched_effect
+	{
+		std::filesystem::path relative_path;
+		bool success = false;
+		std::unordered_set<std::string> dependencies;
+	};
+
+	// Effects are keyed by their canonical path, which is also the form all dependencies are stored in
+	std::map<std::string, watched_effect> effects;
+	for (const auto &entry : std::filesystem::recursive_directory_iterator(root, ec))
+		if (entry.path().extension() == ".fx" && entry.is_regular_file(ec) && !is_inside(entry.path(), output_root))
+			effects[entry.path().u8string()].relative_path = entry.path().lexically_relative(root);
+
+	const int notify_fd = inotify_init1(IN_CLOEXEC);
+	if (notify_fd < 0)
+	{
+		std::cout << "error: could not initialize file change notifications: " << strerror(errno) << std::endl;
+		return 1;
+	}
+
+	std::unordered_map<int, std::filesystem::path> watched_directories;
+	const auto add_watch = [&](const std::filesystem::path &path) {
+		if (const int wd = inotify_add_watch(notify_fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE); wd >= 0)
+			watched_directories[wd] = path;
+	};
+
+	add_watch(root);
+	for (const auto &entry : std::filesystem::recursive_directory_iterator(root, ec))
+		if (entry.is_directory(ec) && !is_inside(entry.path(), output_root) && entry.path() != output_root)
+			add_watch(entry.path());
+
+	const auto file_cache = std::make_shared<reshadefx::preprocessor::file_cache>();
+
+	const auto rebuild = [&](const std::vector<std::string> &keys) {
+		std::vector<std::pair<std::filesystem::path, std::filesystem::path>> files;
+		files.reserve(keys.size());
+		for (const std::string &key : keys)
+			files.emplace_back(std::filesystem::u8path(key), effects[key].relative_path);
+
+		const auto start_time = std::chrono::high_resolution_clock::now();
+
+		const std::vector<effect_result> results = compile_effects(files, num_threads, file_cache, configure_preprocessor, create_backend, output_dir, extension, cache_key, nullptr);
+
+		const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time);
+
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			watched_effect &effect = effects[keys[i]];
+			effect.success = results[i].success;
+			effect.dependencies.clear();
+
+			for (const std::filesystem::path &dependency : results[i].included_files)
+			{
+				const std::filesystem::path path = std::filesystem::weakly_canonical(dependency, ec);
+				effect.dependencies.insert(path.u8string());
+
+				// Include files may live outside the watched directory, so watch their directories too
+				if (!is_inside(path, root))
+					add_watch(path.parent_path());
+			}
+		}
+
+		const size_t num_failed = print_results(files, results, errorfile);
+
+		std::cout << files.size() << " effects compiled in " << duration.count() << " ms: " << (files.size() - num_failed) << " succeeded, " << num_failed << " failed" << std::endl;
+	};
+
+	std::vector<std::string> keys;
+	for (const auto &effect : effects)
+		keys.push_back(effect.first);
+	rebuild(keys);
+
+	std::cout << "watching " << root.u8string() << " for changes" << std::endl;
+
+	alignas(inotify_event) char buffer[4096];
+
+	while (true)
+	{
+		std::set<std::filesystem::path> changed_paths;
+
+		// Wait for the first change, then collect everything that follows within a short time, since editors usually touch a file several times when saving
+		for (int timeout = -1; true; timeout = 20)
+		{
+			pollfd fd = { notify_fd, POLLIN, 0 };
+			const int num_ready = poll(&fd, 1, timeout);
+			if (num_ready < 0 && errno == EINTR)
+				continue;
+			if (num_ready <= 0)
+				break;
+
+			const ssize_t size = read(notify_fd, buffer, sizeof(buffer));
+			if (size <= 0)
+				break;
+
+			for (ssize_t offset = 0; offset < size;)
+			{
+				const auto event = reinterpret_cast<const inotify_event *>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+
+				const auto it = watched_directories.find(event->wd);
+				if (it == watched_directories.end() || event->len == 0)
+					continue;
+
+				const std::filesystem::path path = it->second / event->name;
+				if (is_inside(path, output_root) || path == output_root)
+					continue;
+
+				if ((event->mask & IN_ISDIR) != 0)
+				{
+					// Effects may already have been added to a new directory before it is watched, so look for them right away
+					if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0 && is_inside(path, root))
+					{
+						add_watch(path);
+						for (const auto &entry : std::filesystem::recursive_directory_iterator(path, ec))
+							if (entry.is_directory(ec))
+								add_watch(entry.path());
+							else
+								changed_paths.insert(entry.path());
+					}
+					continue;
+				}
+
+				changed_paths.insert(path);
+			}
+		}
+
+		if (changed_paths.empty())
+			continue;
+
+		std::set<std::string> affected;
+		for (const std::filesystem::path &path : changed_paths)
+		{
+			const std::string key = path.u8string();
+
+			if (path.extension() == ".fx" && is_inside(path, root))
+			{
+				if (std::filesystem::is_regular_file(path, ec))
+				{
+					effects[key].relative_path = path.lexically_relative(root);
+					affected.insert(key);
+				}
+				else if (effects.erase(key) != 0)
+				{
+					std::cout << "removed   " << key << std::endl;
+				}
+			}
+
+			for (const auto &effect : effects)
+				if (effect.second.dependencies.count(key) != 0)
+					affected.insert(effect.first);
+		}
+
+		// An effect that failed may have done so because of a missing include, which is not recorded as dependency, so retry those on every change
+		for (const auto &effect : effects)
+			if (!effect.second.success)
+				affected.insert(effect.first);
+
+		if (!affected.empty())
+			rebuild(std::vector<std::string>(affected.begin(), affected.end()));
+	}
+#else
+	std::cout << "error: --watch is not supported on this platform" << std::endl;
+	return 1;
+#endif
+}
+
+#ifndef _WIN32
+/// <summary>
+/// Write all of the specified data to a socket, returning <c>false</c> if the client went away.
+/// </summary>
+static bool send_all(int socket, const char *data, size_t size)
+{
+	while (size != 0)
+	{
+		const ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+		if (sent <= 0)
+		{
+			if (sent < 0 && errno == EINTR)
+				continue;
+			return false;
+		}
+
+		data += sent;
+		size -= static_cast<size_t>(sent);
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Handle all compile requests on a single client connection until the client closes it.
+/// </summary>
+static void serve_client(int socket, const std::shared_ptr<reshadefx::preprocessor::file_cache> &file_cache, const std::function<void(reshadefx::preprocessor &)> &configure_preprocessor)
+{
+	std::string buffer;
+	size_t buffer_offset = 0;
+
+	// Read a single line from the socket, without the trailing line feed
+	const auto read_line = [&](std::string &line) {
+		while (true)
+		{
+			if (const size_t end = buffer.find('\n', buffer_offset); end != std::string::npos)
+			{
+				line.assign(buffer, buffer_offset, end - buffer_offset);
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
+				buffer_offset = end + 1;
+				return true;
+			}
+
+			buffer.erase(0, buffer_offset);
+			buffer_offset = 0;
+
+			char data[4096];
+			const ssize_t received = recv(socket, data, sizeof(data), 0);
+			if (received < 0 && errno == EINTR)
+				continue;
+			if (received <= 0)
+				return false;
+
+			buffer.append(data, static_cast<size_t>(received));
+		}
+	};
+
+	for (std::string line; read_line(line);)
+	{
+		if (line.empty())
+			continue; // Ignore empty lines between requests
+
+		std::filesystem::path path;
+		std::string backend = "spirv";
+		unsigned int shader_model = 50;
+		bool debug_info = false, pack_uniforms = false, split_uniforms = false;
+		std::vector<std::pair<std::string, std::string>> macros;
+		std::vector<std::filesystem::path> include_paths;
+		std::string errors;
+
+		// A request is a list of "<key> <value>" lines terminated by an empty line
+		do
+		{
+			const size_t separator = line.find(' ');
+			const std::string key = line.substr(0, separator);
+			const std::string value = separator != std::string::npos ? line.substr(separator + 1) : std::string();
+
+			if (key == "file")
+				path = std::filesystem::u8path(value);
+			else if (key == "define")
+			{
+				const size_t equals = value.find('=');
+				macros.emplace_back(value.substr(0, equals), equals != std::string::npos ? value.substr(equals + 1) : "1");
+			}
+			else if (key == "include")
+				include_paths.push_back(std::filesystem::u8path(value));
+			else if (key == "backend")
+				backend = value;
+			else if (key == "shader-model")
+				shader_model = std::strtoul(value.c_str(), nullptr, 10);
+			else if (key == "option" && value == "debug-info")
+				debug_info = true;
+			else if (key == "option" && value == "pack-uniforms")
+				pack_uniforms = true;
+			else if (key == "option" && value == "split-uniforms")
+				split_uniforms = true;
+			else
+				errors += "error: unknown request field '" + line + "'\n";
+		}
+		while (read_line(line) && !line.empty());
+
+		bool success = false;
+		reshadefx::module module;
+
+		std::unique_ptr<reshadefx::codegen> codegen;
+		if (backend == "spirv")
+			codegen.reset(reshadefx::create_codegen_spirv(debug_info, false, pack_uniforms));
+		else if (backend == "glsl")
+			codegen.reset(reshadefx::create_codegen_glsl(debug_info, false, pack_uniforms, split_uniforms));
+		else if (backend == "hlsl")
+			codegen.reset(reshadefx::create_codegen_hlsl(shader_model, debug_info, false, pack_uniforms, split_uniforms));
+		else
+			errors += "error: unknown back-end '" + backend + "'\n";
+
+		if (path.empty())
+			errors += "error: request is missing the 'file' field\n";
+
+		if (errors.empty())
+		{
+			reshadefx::preprocessor pp;
+			pp.set_shared_file_cache(file_cache);
+			configure_preprocessor(pp);
+			for (const auto &macro : macros)
+				pp.add_macro_definition(macro.first, macro.second);
+			for (const auto &include_path : include_paths)
+				pp.add_include_path(include_path);
+
+			if (!pp.append_file(path))
+			{
+				errors = pp.errors().empty() ? "error: could not open " + path.u8string() + '\n' : pp.errors();
+			}
+			else
+			{
+				reshadefx::parser parser;
+				success = parser.parse(std::move(pp.output()), codegen.get());
+				errors = pp.errors() + parser.errors();
+
+				if (success)
+					codegen->write_result(module);
+			}
+		}
+
+		const size_t module_size = module.spirv.empty() ? module.hlsl.size() : module.spirv.size() * sizeof(uint32_t);
+		const char *const module_data = module.spirv.empty() ? module.hlsl.data() : reinterpret_cast<const char *>(module.spirv.data());
+
+		const std::string header_errors = std::string("result ") + (success ? "success" : "failure") + "\nerrors " + std::to_string(errors.size()) + '\n';
+		const std::string header_module = "\nmodule " + std::to_string(module_size) + '\n';
+
+		if (!send_all(socket, header_errors.data(), header_errors.size()) ||
+			!send_all(socket, errors.data(), errors.size()) ||
+			!send_all(socket, header_module.data(), header_module.size()) ||
+			!send_all(socket, module_data, module_size) ||
+			!send_all(socket, "\n", 1))
+			break;
+	}
+
+	close(socket);
+}
+#endif
+
+/// <summary>
+/// Listen for compile requests on a Unix domain socket until the process is terminated.
+/// Included files stay cached between requests (and are only read again after they changed on disk), so that compiling many effects in a row avoids most file system access.
+/// </summary>
+static int serve(const char *socket_path, const std::function<void(reshadefx::preprocessor &)> &configure_preprocessor)
+{
+#ifndef _WIN32
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof(address.sun_path))
+	{
+		std::cout << "error: socket path " << socket_path << " is too long" << std::endl;
+		return 1;
+	}
+	strcpy(address.sun_path, socket_path);
+
+	const int listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_socket < 0)
+	{
+		std::cout << "error: could not create socket: " << strerror(errno) << std::endl;
+		return 1;
+	}
+
+	// Remove a stale socket file from a previous run, but never anything else that happens to be at that path
+	if (struct stat st; lstat(socket_path, &st) == 0)
+	{
+		if (!S_ISSOCK(st.st_mode))
+		{
+			std::cout << "error: " << socket_path << " already exists and is not a socket" << std::endl;
+			close(listen_socket);
+			return 1;
+		}
+
+		unlink(socket_path);
+	}
+
+	if (bind(listen_socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || listen(listen_socket, SOMAXCONN) != 0)
+	{
+		std::cout << "error: could not listen on " << socket_path << ": " << strerror(errno) << std::endl;
+		close(listen_socket);
+		return 1;
+	}
+
+	std::cout << "listening on " << socket_path << std::endl;
+
+	const auto file_cache = std::make_shared<reshadefx::preprocessor::file_cache>();
+
+	while (true)
+	{
+		const int client_socket = accept(listen_socket, nullptr, nullptr);
+		if (client_socket < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+
+			std::cout << "error: could not accept connection: " << strerror(errno) << std::endl;
+			break;
+		}
+
+		// Every connection gets its own thread, so that a client can keep a connection open and issue requests one after another without blocking others
+		std::thread(serve_client, client_socket, file_cache, configure_preprocessor).detach();
+	}
+
+	close(listen_socket);
+	unlink(socket_path);
+	return 1;
+#else
+	std::cout << "error: --serve is not supported on this platform" << std::endl;
+	return 1;
+#endif
+}
+
 int main(int argc, char *argv[])
 {
-	const char *filename = nullptr;
+	std::vector<const char *> inputs;
+	const char *output_dir = nullptr;
+	unsigned int num_threads = std::thread::hardware_concurrency();
 	const char *preprocess = nullptr;
 	const char *errorfile = nullptr;
 	const char *objectfile = nullptr;
+	const char *cachefile = nullptr;
+	bool write_cache = false;
 	bool print_glsl = false;
 	bool print_hlsl = false;
 	bool debug_info = false;
+	bool pack_uniforms = false;
+	bool split_uniforms = false;
+	bool print_stats = false;
+	const char *stats_json = nullptr;
+	const char *serve_socket = nullptr;
+	const char *watch_dir = nullptr;
 	unsigned int shader_model = 50;
 
-	reshadefx::parser parser;
-	reshadefx::preprocessor pp;
-	pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
-	pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", "0");
-	pp.add_macro_definition("BUFFER_WIDTH", "800");
-	pp.add_macro_definition("BUFFER_HEIGHT", "600");
-	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
-	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+	struct code_output
+	{
+		const char *path;
+		bool glsl;
+		unsigned int shader_model;
+	};
+	std::vector<code_output> code_outputs;
+
+	std::vector<std::pair<std::string, std::string>> macros = {
+		{ "__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION) },
+		{ "__RESHADE_PERFORMANCE_MODE__", "0" },
+		{ "BUFFER_WIDTH", "800" },
+		{ "BUFFER_HEIGHT", "600" },
+		{ "BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)" },
+		{ "BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)" },
+	};
+	std::vector<std::filesystem::path> include_paths;
 
 	// Parse command-line arguments
 	for (int i = 1; i < argc; ++i)
@@ -74,11 +996,11 @@ int main(int argc, char *argv[])
 				char *macro = argv[++i];
 				char *value = strchr(macro, '=');
 				if (value) *value++ = '\0';
-				pp.add_macro_definition(macro, value ? value : "1");
+				macros.emplace_back(macro, value ? value : "1");
 			}
 			else if (0 == strcmp(arg, "-I"))
 			{
-				pp.add_include_path(argv[++i]);
+				include_paths.push_back(std::filesystem::u8path(argv[++i]));
 			}
 			else if (0 == strcmp(arg, "-P"))
 			{
@@ -92,6 +1014,22 @@ int main(int argc, char *argv[])
 			{
 				objectfile = argv[++i];
 			}
+			else if (0 == strcmp(arg, "-Fh"))
+			{
+				code_outputs.push_back({ argv[++i], false, shader_model });
+			}
+			else if (0 == strcmp(arg, "-Fc"))
+			{
+				cachefile = argv[++i];
+			}
+			else if (0 == strcmp(arg, "--cache"))
+			{
+				write_cache = true;
+			}
+			else if (0 == strcmp(arg, "-Fg"))
+			{
+				code_outputs.push_back({ argv[++i], true, 0 });
+			}
 			else if (0 == strcmp(arg, "-Zi"))
 			{
 				debug_info = true;
@@ -108,25 +1046,112 @@ int main(int argc, char *argv[])
 			{
 				shader_model = std::strtol(argv[++i], nullptr, 10);
 			}
+			else if (0 == strcmp(arg, "--pack-uniforms"))
+			{
+				pack_uniforms = true;
+			}
+			else if (0 == strcmp(arg, "--split-uniforms"))
+			{
+				split_uniforms = true;
+			}
+			else if (0 == strcmp(arg, "-j"))
+			{
+				num_threads = std::strtoul(argv[++i], nullptr, 10);
+			}
+			else if (0 == strcmp(arg, "--output-dir"))
+			{
+				output_dir = argv[++i];
+			}
+			else if (0 == strcmp(arg, "--stats"))
+			{
+				print_stats = true;
+			}
+			else if (0 == strcmp(arg, "--stats-json"))
+			{
+				stats_json = argv[++i];
+			}
+			else if (0 == strcmp(arg, "--serve"))
+			{
+				serve_socket = argv[++i];
+			}
+			else if (0 == strcmp(arg, "--watch"))
+			{
+				watch_dir = argv[++i];
+			}
 		}
 		else
 		{
-			if (filename != nullptr)
-			{
-				std::cout << "error: More than one input file specified" << std::endl;
-				return 1;
-			}
-
-			filename = arg;
+			inputs.push_back(arg);
 		}
 	}
 
-	if (filename == nullptr)
+	if (cachefile != nullptr && !code_outputs.empty())
+	{
+		std::cout << "error: -Fc cannot be combined with -Fh or -Fg" << std::endl;
+		return 1;
+	}
+
+	const auto configure_preprocessor = [&](reshadefx::preprocessor &pp) {
+		for (const auto &macro : macros)
+			pp.add_macro_definition(macro.first, macro.second);
+		for (const auto &include_path : include_paths)
+			pp.add_include_path(include_path);
+	};
+
+	if (serve_socket != nullptr)
+		return serve(serve_socket, configure_preprocessor);
+
+	// Back-end used in batch and watch mode
+	const auto create_backend = [&]() {
+		if (print_glsl)
+			return reshadefx::create_codegen_glsl(debug_info, false, pack_uniforms, split_uniforms);
+		else if (print_hlsl)
+			return reshadefx::create_codegen_hlsl(shader_model, debug_info, false, pack_uniforms, split_uniforms);
+		else
+			return reshadefx::create_codegen_spirv(debug_info, false, pack_uniforms);
+	};
+	const char *const extension = write_cache ? ".fxcache" : print_glsl ? ".glsl" : print_hlsl ? ".hlsl" : ".spv";
+
+	// Identifies the back-end options in module cache files, so that the runtime only uses modules that were generated with the same options it would use
+	const std::string codegen_key =
+		print_glsl ? reshadefx::make_codegen_key("glsl", 0, debug_info, false, pack_uniforms, split_uniforms) :
+		print_hlsl ? reshadefx::make_codegen_key("hlsl", shader_model, debug_info, false, pack_uniforms, split_uniforms) :
+		reshadefx::make_codegen_key("spirv", 0, debug_info, false, pack_uniforms, false);
+	const char *const cache_key = write_cache ? codegen_key.c_str() : nullptr;
+
+	if (watch_dir != nullptr)
+		return watch(watch_dir, std::max(num_threads, 1u), configure_preprocessor, create_backend, output_dir, extension, cache_key, errorfile);
+
+	if (inputs.empty())
 	{
 		print_usage(argv[0]);
 		return 1;
 	}
 
+	if (inputs.size() > 1 || inputs[0][0] == '@' || strpbrk(inputs[0], "*?") != nullptr || std::filesystem::is_directory(std::filesystem::u8path(inputs[0])))
+	{
+		std::vector<std::pair<std::filesystem::path, std::filesystem::path>> files;
+		for (const char *input : inputs)
+		{
+			if (!collect_inputs(input, files))
+			{
+				std::cout << "error: could not read input " << input << std::endl;
+				return 1;
+			}
+		}
+
+		return compile_batch(files, std::max(num_threads, 1u), configure_preprocessor, create_backend, output_dir, extension, cache_key, errorfile);
+	}
+
+	const char *const filename = inputs[0];
+
+	reshadefx::parser parser;
+	reshadefx::preprocessor pp;
+	configure_preprocessor(pp);
+
+	if (print_stats || stats_json != nullptr)
+		return compile_with_stats(filename, pp, shader_model, debug_info, pack_uniforms, split_uniforms, print_stats, stats_json, errorfile);
+
 	if (!pp.append_file(filename))
 	{
 		if (errorfile == nullptr)
@@ -145,26 +1170,96 @@ int main(int argc, char *argv[])
 		return 0;
 	}
 
+	const auto print_errors = [&]() {
+		if (errorfile == nullptr)
+			std::cout << pp.errors() << parser.errors() << std::endl;
+		else
+			std::ofstream(errorfile) << pp.errors() << parser.errors();
+	};
+
+	if (!code_outputs.empty())
+	{
+		// Parse only once and then replay the result into all requested back-ends at the same time
+		const std::unique_ptr<reshadefx::codegen> recording(reshadefx::create_codegen_recorder());
+
+		if (!parser.parse(pp.output(), recording.get()))
+		{
+			print_errors();
+			return 1;
+		}
+
+		if (objectfile != nullptr)
+			code_outputs.push_back({ objectfile, false, 0 });
+
+		std::vector<reshadefx::module> modules(code_outputs.size());
+		std::vector<std::thread> threads;
+		threads.reserve(code_outputs.size());
+
+		for (size_t i = 0; i < code_outputs.size(); ++i)
+		{
+			threads.emplace_back([&, i]() {
+				const code_output &output = code_outputs[i];
+
+				std::unique_ptr<reshadefx::codegen> backend;
+				if (output.glsl)
+					backend.reset(reshadefx::create_codegen_glsl(debug_info, false, pack_uniforms, split_uniforms));
+				else if (output.shader_model != 0)
+					backend.reset(reshadefx::create_codegen_hlsl(output.shader_model, debug_info, false, pack_uniforms, split_uniforms));
+				else
+					backend.reset(reshadefx::create_codegen_spirv(debug_info, false, pack_uniforms));
+
+				reshadefx::replay_codegen(*recording, *backend);
+				backend->write_result(modules[i]);
+			});
+		}
+
+		for (std::thread &thread : threads)
+			thread.join();
+
+		for (size_t i = 0; i < code_outputs.size(); ++i)
+		{
+			const code_output &output = code_outputs[i];
+			const reshadefx::module &module = modules[i];
+
+			if (pack_uniforms)
+				std::cerr << output.path << ": uniform buffer is " << module.total_uniform_size << " bytes, saved " << module.uniform_bytes_saved << " bytes of padding" << std::endl;
+
+			if (output.glsl || output.shader_model != 0)
+				std::ofstream(output.path) << module.hlsl;
+			else
+				std::ofstream(output.path, std::ios::binary).write(
+					reinterpret_cast<const char *>(module.spirv.data()), module.spirv.size() * sizeof(uint32_t));
+		}
+
+		return 0;
+	}
+
 	std::unique_ptr<reshadefx::codegen> backend;
 	if (print_glsl)
-		backend.reset(reshadefx::create_codegen_glsl(debug_info, false));
+		backend.reset(reshadefx::create_codegen_glsl(debug_info, false, pack_uniforms, split_uniforms));
 	else if (print_hlsl)
-		backend.reset(reshadefx::create_codegen_hlsl(shader_model, debug_info, false));
+		backend.reset(reshadefx::create_codegen_hlsl(shader_model, debug_info, false, pack_uniforms, split_uniforms));
 	else
-		backend.reset(reshadefx::create_codegen_spirv(debug_info, false));
+		backend.reset(reshadefx::create_codegen_spirv(debug_info, false, pack_uniforms));
 
 	if (!parser.parse(pp.output(), backend.get()))
 	{
-		if (errorfile == nullptr)
-			std::cout << pp.errors() << parser.errors() << std::endl;
-		else
-			std::ofstream(errorfile) << pp.errors() << parser.errors();
+		print_errors();
 		return 1;
 	}
 
 	reshadefx::module module;
 	backend->write_result(module);
 
+	if (pack_uniforms)
+		std::cerr << filename << ": uniform buffer is " << module.total_uniform_size << " bytes, saved " << module.uniform_bytes_saved << " bytes of padding" << std::endl;
+
+	if (cachefile != nullptr && !write_module_cache_file(std::filesystem::u8path(cachefile), module, pp, std::filesystem::u8path(filename), codegen_key.c_str()))
+	{
+		std::cout << "error: could not write module cache " << cachefile << std::endl;
+		return 1;
+	}
+
 	if (print_glsl || print_hlsl)
 	{
 		std::cout << module.hlsl << std::endl;